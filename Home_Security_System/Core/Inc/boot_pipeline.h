@@ -0,0 +1,99 @@
+/*
+ * boot_pipeline.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_BOOT_PIPELINE_H_
+#define INC_BOOT_PIPELINE_H_
+
+#include <stdint.h>
+
+/**
+ * Define the results of a stage step
+ */
+#define BOOT_STAGE_DONE (0)
+#define BOOT_STAGE_PENDING (1)
+#define BOOT_STAGE_ERR (-1)
+
+/**
+ * Define the maximum number of stages of a pipeline
+ */
+#define BOOT_PIPELINE_MAX_STAGES (16)
+
+/**
+ * Define the dependency mask of a stage, by its index into the stage table
+ */
+#define BOOT_STAGE(index) ((uint16_t)1 << (index))
+
+/**
+ * Define the step type of a stage: BOOT_STAGE_DONE, BOOT_STAGE_PENDING or BOOT_STAGE_ERR
+ */
+typedef int8_t (*boot_step_t)(void);
+
+/**
+ * Define boot stage structure
+ */
+struct boot_stage_s{
+
+	const char *name;
+
+	uint16_t depends; // BOOT_STAGE() of the stages that must be done before the start
+
+	boot_step_t start; // called once, as soon as the dependencies are done
+
+	boot_step_t poll; // called by each pass while the stage is pending, NULL if the start always completes it
+
+};
+
+typedef struct boot_stage_s boot_stage_t;
+
+/**
+ * Define boot pipeline status
+ */
+typedef enum{
+	BOOT_RUNNING,
+	BOOT_FINISHED,
+	BOOT_FAILED
+} boot_pipeline_state_t;
+
+/**
+ * Define boot pipeline structure: the stages start as soon as their dependencies are done, so the waits overlap
+ */
+struct boot_pipeline_s{
+
+	const boot_stage_t *stages;
+
+	uint8_t count;
+
+	uint16_t started; // BOOT_STAGE() of the started stages
+
+	uint16_t done; // BOOT_STAGE() of the completed stages
+
+	boot_pipeline_state_t state;
+
+	uint32_t start_time[BOOT_PIPELINE_MAX_STAGES]; // HAL tick at the start of each stage
+
+	uint32_t end_time[BOOT_PIPELINE_MAX_STAGES]; // HAL tick at the completion of each stage
+
+};
+
+typedef struct boot_pipeline_s boot_pipeline_t;
+
+/**
+ * Initialize the pipeline with a table of stages, none is started
+ */
+void init_boot_pipeline(boot_pipeline_t *pipeline, const boot_stage_t *stages, uint8_t count);
+
+/**
+ * Start the stages whose dependencies are done and poll the pending ones
+ */
+boot_pipeline_state_t boot_pipeline_process(boot_pipeline_t *pipeline);
+
+/**
+ * Format the start time and the length of each stage, return the characters written
+ */
+uint16_t boot_pipeline_format(boot_pipeline_t *pipeline, char *buffer, uint16_t size);
+
+#endif /* INC_BOOT_PIPELINE_H_ */
@@ -0,0 +1,100 @@
+/*
+ * config_schema.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_CONFIG_SCHEMA_H_
+#define INC_CONFIG_SCHEMA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "configuration_protocol.h"
+
+/**
+ * Define config schema return values
+ */
+#define CONFIG_SCHEMA_OK (0)
+#define CONFIG_SCHEMA_ERR (-1)
+
+/**
+ * Define the widest field, in characters, and the most fields the schema can have
+ */
+#define CONFIG_FIELD_MAX_WIDTH (PIN_SIZE)
+#define CONFIG_SCHEMA_MAX_FIELDS (8)
+
+/**
+ * Define the field types
+ */
+typedef enum{
+	CONFIG_FIELD_DIGITS, // width digits kept as characters, e.g. the user pin
+	CONFIG_FIELD_UINT8 // width digits converted into a number between min and max
+} config_field_type_t;
+
+/**
+ * Define a field of the system configuration: how it is asked, checked, converted and stored
+ */
+typedef struct{
+
+	const char *name; // key of the bulk line and of the console
+
+	const char *prompt; // request of the interactive protocol
+
+	config_field_type_t type;
+
+	uint8_t width; // characters of the field
+
+	uint8_t min; // accepted range of a CONFIG_FIELD_UINT8
+
+	uint8_t max;
+
+	const char *default_text; // default value, as it would be inserted
+
+	uint8_t offset; // destination into system_configuration_t
+
+	uint8_t size; // bytes of the destination
+
+} config_field_t;
+
+/**
+ * Define the schema of the system configuration, the fields are asked in this order
+ */
+extern const config_field_t config_schema[];
+
+/**
+ * Define the number of fields of the schema
+ */
+extern const uint8_t config_fields;
+
+/**
+ * Find a field by name, NULL if there is none
+ */
+const config_field_t *config_schema_find(const char *name, uint8_t length);
+
+/**
+ * Check the characters of a field
+ */
+int8_t config_schema_check(const config_field_t *field, const uint8_t *text);
+
+/**
+ * Check and convert the characters of a field into the configuration
+ */
+int8_t config_schema_set(system_configuration_t *configuration, const config_field_t *field, const uint8_t *text);
+
+/**
+ * Load the default value of all the fields
+ */
+void config_schema_load_defaults(system_configuration_t *configuration);
+
+/**
+ * Copy the fields, one after the other, into a buffer; return the bytes written, 0 if they do not fit
+ */
+uint8_t config_schema_pack(const system_configuration_t *configuration, uint8_t *buffer, uint8_t size);
+
+/**
+ * Copy the fields from a buffer written by config_schema_pack(), the missing or invalid ones take their default
+ */
+void config_schema_unpack(system_configuration_t *configuration, const uint8_t *buffer, uint8_t size);
+
+#endif /* INC_CONFIG_SCHEMA_H_ */
@@ -0,0 +1,139 @@
+/*
+ * config_store.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_CONFIG_STORE_H_
+#define INC_CONFIG_STORE_H_
+
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+#include "configuration_protocol.h"
+
+/**
+ * Define config store return values
+ */
+#define CONFIG_STORE_OK (0)
+#define CONFIG_STORE_ERR (-1)
+
+/**
+ * Define the two flash slots, sectors 6 and 7: the linker script keeps the program below them.
+ * Erasing a 128 KB sector stalls every flash fetch, the vector table and the interrupt handlers included, for
+ * 1 to 2 s: it happens once every CONFIG_STORE_RECORDS records, config_store_needs_erase() tells when.
+ */
+#define CONFIG_STORE_SLOT_A_ADDRESS (0x08040000)
+#define CONFIG_STORE_SLOT_A_SECTOR (FLASH_SECTOR_6)
+#define CONFIG_STORE_SLOT_B_ADDRESS (0x08060000)
+#define CONFIG_STORE_SLOT_B_SECTOR (FLASH_SECTOR_7)
+#define CONFIG_STORE_SLOT_SIZE (0x20000)
+
+/**
+ * Define the record header: magic, payload version and payload size, a size of 0 marks a cleared configuration
+ */
+#define CONFIG_STORE_MAGIC (0xC0F1)
+#define CONFIG_STORE_VERSION (3)
+#define CONFIG_STORE_HEADER(size) (((uint32_t)CONFIG_STORE_MAGIC << 16) | (CONFIG_STORE_VERSION << 8) | (size))
+#define CONFIG_STORE_HEADER_SIZE(header) ((header) & 0xFF)
+
+/**
+ * Define the payload layout: console baud rate, barrier thresholds, then the fields packed by config_schema_pack()
+ * up to the payload end. A cleared configuration keeps only the baud rate.
+ */
+#define CONFIG_STORE_BAUD_OFFSET (0)
+#define CONFIG_STORE_THRESHOLD_UP_OFFSET (CONFIG_STORE_BAUD_OFFSET + 1)
+#define CONFIG_STORE_THRESHOLD_DOWN_OFFSET (CONFIG_STORE_THRESHOLD_UP_OFFSET + 2)
+#define CONFIG_STORE_SCHEMA_OFFSET (CONFIG_STORE_THRESHOLD_DOWN_OFFSET + 2)
+#define CONFIG_STORE_PAYLOAD_SIZE (20)
+
+/**
+ * Define the baud rate index of a record without baud rate
+ */
+#define CONFIG_STORE_NO_BAUD (0xFF)
+
+/**
+ * Define the value of an erased flash word
+ */
+#define CONFIG_STORE_ERASED (0xFFFFFFFF)
+
+/**
+ * Define config record structure, it is programmed one word at a time from header to crc
+ */
+struct config_record_s{
+
+	uint32_t header; // first word programmed, so the written records are a prefix of the slot
+
+	uint32_t sequence; // incremented by each record, across the slots
+
+	uint8_t payload[CONFIG_STORE_PAYLOAD_SIZE];
+
+	uint32_t crc; // CRC-16/CCITT-FALSE of the previous bytes, last word programmed
+
+};
+
+typedef struct config_record_s config_record_t;
+
+/**
+ * Define the number of records of a slot
+ */
+#define CONFIG_STORE_RECORDS (CONFIG_STORE_SLOT_SIZE / sizeof(config_record_t))
+
+/**
+ * Define config store structure: a log of records appended to the active slot, the newest one is the configuration
+ */
+struct config_store_s{
+
+	uint8_t active; // slot of the newest record
+
+	uint8_t valid; // 1 if the active slot holds a valid record
+
+	uint16_t newest; // index of the newest valid record of the active slot
+
+	uint16_t next; // index of the next free record of the active slot
+
+	uint32_t sequence; // sequence of the newest record
+
+	uint8_t loaded; // 1 if a configuration has been read at boot
+
+	uint16_t threshold_up; // barrier calibration of the loaded record
+
+	uint16_t threshold_down;
+
+	uint8_t baud_index; // index into uart_baud_rates of the newest record, CONFIG_STORE_NO_BAUD if none
+
+};
+
+typedef struct config_store_s config_store_t;
+
+/**
+ * Initialize the config store: find the active slot and its newest record
+ */
+void init_config_store(config_store_t *store);
+
+/**
+ * Copy the newest record into the configuration, CONFIG_STORE_ERR if there is none or it is cleared
+ */
+int8_t config_store_load(config_store_t *store, system_configuration_t *configuration);
+
+/**
+ * Append the configuration and the barrier calibration as a new record
+ */
+int8_t config_store_save(config_store_t *store, const system_configuration_t *configuration, uint16_t threshold_up, uint16_t threshold_down);
+
+/**
+ * Append a cleared record, the next boot runs the configuration protocol again
+ */
+int8_t config_store_erase(config_store_t *store);
+
+/**
+ * Append the newest record with another console baud rate, given as index into uart_baud_rates
+ */
+int8_t config_store_save_baud_rate(config_store_t *store, uint8_t baud_index);
+
+/**
+ * Check if the next record erases a slot, so it stalls the flash fetches
+ */
+uint8_t config_store_needs_erase(config_store_t *store);
+
+#endif /* INC_CONFIG_STORE_H_ */
@@ -13,6 +13,7 @@
 #include "timer_handler.h"
 #include "stm32f4xx.h"
 #include "ds1307rtc.h"
+#include "timer_wheel.h"
 /**
  * Define protocol Error
  */
@@ -20,12 +21,6 @@
 #define PROTOCOL_ERR (-1)
 
 
-/**
- * Define default configuration values
- */
-#define DEFAULT_DELAY (0)
-#define DEFAULT_DURATION (5)
-
 /**
  * Define messages to sent through UART
  */
@@ -45,6 +40,15 @@
 #define DATE_TIME_SIZE (2)
 #define DATE_TIME_BUFFER_SIZE (12)
 
+/**
+ * Define the bulk mode: a line "PIN=xxxx;D1=xx;D2=xx;DUR=xx;DT=dd/mm/yy hh:mm:ss" answers all the requests at once.
+ * It is recognized by its first PIN_SIZE characters, which are not a valid pin: the pin is the first field of the schema.
+ */
+#define BULK_PREFIX ("PIN=")
+#define BULK_LINE_SIZE (64)
+#define BULK_FIELD_SEPARATOR (';')
+#define BULK_KEY_SEPARATOR ('=')
+
 /**
  * Defines protocol status type
  */
@@ -52,14 +56,8 @@ typedef enum{
 	IDLE_P,
 	START_P,
 	STOP_P,
-	PIN_T,
-	PIN_R,
-	DELAY1_T,
-	DELAY1_R,
-	DELAY2_T,
-	DELAY2_R,
-	DURATION_T,
-	DURATION_R,
+	FIELD_T,
+	FIELD_R,
 	DATE_T,
 	DATE_R,
 	MONTH_T,
@@ -72,6 +70,7 @@ typedef enum{
 	MINUTE_R,
 	SECOND_T,
 	SECOND_R,
+	BULK_R,
 	END_DEFAULT,
 	END_CUSTOM,
 	END_ERR
@@ -119,7 +118,11 @@ typedef struct{
 
 	protocol_status_type state;
 
-	TIM_HandleTypeDef *timer;
+	uint8_t field; // schema field under request
+
+	timer_wheel_t *wheel;
+
+	virtual_timer_t timer; // timeout of the protocol
 
 	rtc_t *rtc;
 
@@ -129,7 +132,7 @@ typedef struct{
 /**
  * Initialize protocol's structure with the given parameters
  */
-void init_protocol(configuration_protocol_t *protocol, system_configuration_t *configuration, TIM_HandleTypeDef *timer, rtc_t *rtc);
+void init_protocol(configuration_protocol_t *protocol, system_configuration_t *configuration, timer_wheel_t *wheel, rtc_t *rtc);
 
 /**
  * Perform system_configuration procedure in a blocking-mode.
@@ -137,7 +140,7 @@ void init_protocol(configuration_protocol_t *protocol, system_configuration_t *c
 protocol_status_type configuration_protocol(configuration_protocol_t *protocol);
 
 /**
- * Perform the transmission protocol steps
+ * Perform the transmission protocol steps, once the previous echo has been queued
  */
 void protocol_callback_tx();
 
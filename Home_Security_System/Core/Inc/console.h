@@ -0,0 +1,107 @@
+/*
+ * console.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_CONSOLE_H_
+#define INC_CONSOLE_H_
+
+#include <stdint.h>
+#include "system_log.h"
+#include "kernel.h"
+
+/**
+ * Define console return values
+ */
+#define CONSOLE_OK (0)
+#define CONSOLE_ERR (-1)
+
+/**
+ * Define the maximum length of a command line
+ */
+#define CONSOLE_LINE_SIZE (64)
+
+/**
+ * Define the number of complete lines queued for the background task
+ */
+#define CONSOLE_QUEUE_SIZE (2)
+
+/**
+ * Define console commands
+ */
+#define CONSOLE_HELP ("HELP")
+#define CONSOLE_STATUS ("STATUS")
+#define CONSOLE_DIAG ("DIAG")
+#define CONSOLE_LOG_ASCII ("LOG ASCII")
+#define CONSOLE_LOG_BINARY ("LOG BINARY")
+#define CONSOLE_HEARTBEAT ("HEARTBEAT ")
+#define CONSOLE_BAUD ("BAUD ")
+#define CONSOLE_TELEMETRY_ON ("TELEMETRY ON")
+#define CONSOLE_TELEMETRY_OFF ("TELEMETRY OFF")
+#define CONSOLE_CONFIG_CLEAR ("CONFIG CLEAR")
+#define CONSOLE_SET ("SET ")
+
+/**
+ * Define how many times a failed save of the baud rate, or save and erase of the configuration, is retried
+ */
+#define CONSOLE_STORE_RETRY (3)
+
+/**
+ * Define console structure
+ */
+struct console_s{
+
+	uint8_t line[CONSOLE_LINE_SIZE];
+
+	uint8_t length; // characters inserted in line
+
+	uint8_t overflow; // 1 if the current line is longer than line
+
+	kernel_t *kernel;
+
+	kernel_queue_t lines; // complete lines, executed by console_process()
+
+	uint8_t lines_buffer[CONSOLE_QUEUE_SIZE][CONSOLE_LINE_SIZE];
+
+	system_log_t *system_log;
+
+	uint32_t baud_rate_to_store; // baud rate to save into the flash, 0 if none
+
+	uint8_t store_retry; // save attempts left
+
+	uint8_t erase_retry; // erase attempts left of the saved configuration, 0 if none
+
+	uint8_t save_retry; // save attempts left of the changed configuration, 0 if none
+
+};
+
+typedef struct console_s console_t;
+
+/**
+ * Initialize the console
+ */
+void init_console(console_t *console, system_log_t *system_log, kernel_t *kernel);
+
+/**
+ * Start the console: the UART continuous reception feeds the command line
+ */
+int8_t start_console(console_t *console);
+
+/**
+ * Collect the received characters into the command line and queue the complete lines, it is the UART reception callback
+ */
+void console_receive(uint8_t *data, uint16_t size);
+
+/**
+ * Execute a complete command line
+ */
+void console_execute_line(console_t *console, char *line);
+
+/**
+ * Execute the queued lines and complete the deferred work of the commands, called by the background task
+ */
+void console_process(console_t *console);
+
+#endif /* INC_CONSOLE_H_ */
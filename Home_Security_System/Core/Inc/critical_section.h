@@ -0,0 +1,36 @@
+/*
+ * critical_section.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_CRITICAL_SECTION_H_
+#define INC_CRITICAL_SECTION_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/**
+ * Disable the interrupts and return the previous PRIMASK value.
+ * It can be nested and it can be used from thread mode and from any interrupt.
+ */
+static inline uint32_t critical_section_enter(){
+
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	return primask;
+}
+
+/**
+ * Restore the PRIMASK value returned by critical_section_enter()
+ */
+static inline void critical_section_exit(uint32_t primask){
+
+	__set_PRIMASK(primask);
+
+}
+
+#endif /* INC_CRITICAL_SECTION_H_ */
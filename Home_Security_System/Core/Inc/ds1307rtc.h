@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 #include "stm32f4xx.h"
+#include "i2c_bus.h"
 
 /**
  * Define return values
@@ -26,6 +27,13 @@
 #define DS1307_MONTH				(0x05)
 #define DS1307_YEAR					(0x06)
 #define DS1307_CONTROL				(0x07)
+#define DS1307_RAM					(0x08)
+
+/* Size of the battery backed RAM, from DS1307_RAM to 0x3F */
+#define DS1307_RAM_SIZE				(56)
+
+/* Timeout of the presence check at boot, in ms */
+#define DS1307_READY_TIMEOUT		(100)
 
 /* Bits in control register */
 #define DS1307_CONTROL_OUT			(7)
@@ -63,16 +71,20 @@ struct rtc_s{
 
 	date_time_t date_time;
 
-	I2C_HandleTypeDef* i2c;
+	i2c_bus_t *bus;
+
+	volatile uint8_t reading; // 1 while a DMA reading is queued or running
+
+	uint32_t read_tick; // HAL tick of the start of the last DMA reading, when the rtc latches its registers
 
 };
 
 typedef struct rtc_s rtc_t;
 
 /**
- * Initialize the rtc structure with the given i2c peripheral handler
+ * Initialize the rtc structure on the given i2c bus
  */
-int8_t ds1307rtc_init(rtc_t *rtc, I2C_HandleTypeDef *i2c);
+int8_t ds1307rtc_init(rtc_t *rtc, i2c_bus_t *bus);
 
 /**
  * update the date_time structure referenced by the rtc pointer in non-blocking mode
@@ -94,6 +106,21 @@ int8_t ds1307rtc_update_date_time(rtc_t *rtc);
  */
 int8_t ds1307rtc_set_date_time(rtc_t *rtc);
 
+/**
+ * enable or disable the 1 Hz square wave output, in blocking mode.
+ */
+int8_t ds1307rtc_set_square_wave(rtc_t *rtc, uint8_t enable);
+
+/**
+ * read size bytes of the battery backed RAM starting from offset, in blocking mode.
+ */
+int8_t ds1307rtc_read_ram(rtc_t *rtc, uint8_t offset, uint8_t *buffer, uint8_t size);
+
+/**
+ * write size bytes of the battery backed RAM starting from offset, in blocking mode.
+ */
+int8_t ds1307rtc_write_ram(rtc_t *rtc, uint8_t offset, uint8_t *buffer, uint8_t size);
+
 /**
  * set the internal rtc date structure fields;
  */
@@ -0,0 +1,54 @@
+/*
+ * epoch.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_EPOCH_H_
+#define INC_EPOCH_H_
+
+#include <stdint.h>
+#include "ds1307rtc.h"
+
+/**
+ * Define the number of seconds in a day
+ */
+#define EPOCH_SECONDS_PER_DAY (86400)
+
+/**
+ * Define the epoch type: seconds since 01-01-2000 00:00:00, it covers the years [2000-2099] of date_time_t
+ */
+typedef uint32_t epoch_t;
+
+/**
+ * Return 1 if the year [00-99] is a leap year
+ */
+uint8_t epoch_is_leap_year(uint8_t year);
+
+/**
+ * Return the number of days of the month [1-12] in the year [00-99]
+ */
+uint8_t epoch_days_in_month(uint8_t year, uint8_t month);
+
+/**
+ * Return the number of days since 01-01-2000 of the given date
+ */
+uint32_t epoch_days_from_date(uint8_t year, uint8_t month, uint8_t date);
+
+/**
+ * Return the day of the week [1-7], Monday is 1, of the given days since 01-01-2000
+ */
+uint8_t epoch_week_day(uint32_t days);
+
+/**
+ * Convert a date time into epoch seconds, the day of the week is ignored
+ */
+epoch_t epoch_from_date_time(const date_time_t *date_time);
+
+/**
+ * Convert epoch seconds into a date time, the day of the week included
+ */
+void epoch_to_date_time(epoch_t seconds, date_time_t *date_time);
+
+#endif /* INC_EPOCH_H_ */
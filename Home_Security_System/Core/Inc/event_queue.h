@@ -0,0 +1,88 @@
+/*
+ * event_queue.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_EVENT_QUEUE_H_
+#define INC_EVENT_QUEUE_H_
+
+#include <stdint.h>
+
+/**
+ * Define event queue return values
+ */
+#define EVENT_QUEUE_OK (0)
+#define EVENT_QUEUE_ERR (-1)
+
+/**
+ * Define the number of slots, it must be a power of two
+ */
+#define EVENT_QUEUE_SIZE (32)
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+/**
+ * Define the slots kept free for the events posted with reserved set: a burst of ordinary events cannot drop them
+ */
+#define EVENT_QUEUE_RESERVED (8)
+
+/**
+ * Define event structure: an identifier and a small argument sampled by the interrupt
+ */
+struct event_s{
+
+	uint16_t id;
+
+	uint16_t arg;
+
+};
+
+typedef struct event_s event_t;
+
+/**
+ * Define event slot structure
+ */
+struct event_slot_s{
+
+	volatile uint32_t sequence; // position + 1 once the event is written, position + EVENT_QUEUE_SIZE once it is read
+
+	event_t event;
+
+};
+
+typedef struct event_slot_s event_slot_t;
+
+/**
+ * Define event queue structure: lock-free, many interrupts post, a single task reads
+ */
+struct event_queue_s{
+
+	event_slot_t slots[EVENT_QUEUE_SIZE];
+
+	volatile uint32_t tail; // next position to reserve, shared by the producers
+
+	volatile uint32_t head; // next position to read, owned by the consumer
+
+	volatile uint32_t dropped; // events lost because the queue was full
+
+};
+
+typedef struct event_queue_s event_queue_t;
+
+/**
+ * Initialize the event queue
+ */
+void init_event_queue(event_queue_t *queue);
+
+/**
+ * Post an event, it can be called from any interrupt; reserved lets it take the last EVENT_QUEUE_RESERVED slots
+ */
+int8_t event_queue_post(event_queue_t *queue, uint16_t id, uint16_t arg, uint8_t reserved);
+
+/**
+ * Read the oldest event, it must be called by a single consumer
+ */
+int8_t event_queue_pop(event_queue_t *queue, event_t *event);
+
+#endif /* INC_EVENT_QUEUE_H_ */
@@ -0,0 +1,147 @@
+/*
+ * i2c_bus.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_I2C_BUS_H_
+#define INC_I2C_BUS_H_
+
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+
+/**
+ * Define i2c bus return values, also used as transaction results
+ */
+#define I2C_BUS_OK (0)
+#define I2C_BUS_ERR (-1)
+#define I2C_BUS_TIMEOUT (-2)
+
+/**
+ * Define the number of queued transactions, it must be a power of two
+ */
+#define I2C_BUS_QUEUE_SIZE (8)
+
+/**
+ * Define the maximum number of data bytes of a transaction
+ */
+#define I2C_BUS_DATA_SIZE (64)
+
+/**
+ * Define the time after which a running transaction is aborted and the bus recovered, in ms
+ */
+#define I2C_BUS_TRANSACTION_TIMEOUT (50)
+
+/**
+ * Define the pins released by the bus recovery, they are the I2C1 SCL and SDA
+ */
+#define I2C_BUS_SCL_PORT (GPIOB)
+#define I2C_BUS_SCL_PIN (GPIO_PIN_6)
+#define I2C_BUS_SDA_PORT (GPIOB)
+#define I2C_BUS_SDA_PIN (GPIO_PIN_7)
+
+/**
+ * Define the transaction direction
+ */
+typedef enum{
+	I2C_BUS_READ,
+	I2C_BUS_WRITE
+} i2c_bus_direction_t;
+
+typedef struct i2c_transaction_s i2c_transaction_t;
+
+/**
+ * Define the completion callback type, it is called in interrupt or by i2c_bus_process()
+ */
+typedef void (*i2c_bus_callback_t)(i2c_transaction_t *transaction);
+
+/**
+ * Define the transaction structure: a memory read or write of a device register range
+ */
+struct i2c_transaction_s{
+
+	uint16_t address; // 8 bit device address
+
+	uint16_t memory_address;
+
+	i2c_bus_direction_t direction;
+
+	uint8_t data[I2C_BUS_DATA_SIZE]; // bytes to write, or bytes read when the callback is called
+
+	uint8_t size;
+
+	int8_t result; // I2C_BUS_OK, I2C_BUS_ERR or I2C_BUS_TIMEOUT
+
+	uint32_t tick; // HAL tick of the start on the bus
+
+	i2c_bus_callback_t callback; // NULL if the client does not wait the result
+
+	void *context; // client data passed back to the callback
+
+};
+
+/**
+ * Define i2c bus structure: the transactions of all the clients are run one after the other on DMA
+ */
+struct i2c_bus_s{
+
+	I2C_HandleTypeDef *i2c;
+
+	i2c_transaction_t queue[I2C_BUS_QUEUE_SIZE];
+
+	volatile uint8_t head; // next free transaction, free running
+
+	volatile uint8_t tail; // running or next transaction, free running
+
+	volatile uint8_t active; // 1 while the tail transaction is on the bus
+
+	volatile uint8_t recover; // 1 if the bus must be recovered before the next transaction
+
+	uint32_t start_tick; // HAL tick of the start of the running transaction
+
+	uint32_t completed;
+
+	uint32_t errors;
+
+	uint32_t timeouts;
+
+	uint32_t recoveries;
+
+};
+
+typedef struct i2c_bus_s i2c_bus_t;
+
+/**
+ * Initialize the i2c bus on the given peripheral, already initialized
+ */
+void init_i2c_bus(i2c_bus_t *bus, I2C_HandleTypeDef *i2c);
+
+/**
+ * Queue a transaction, it can be called from any interrupt. data is copied, it is ignored by the reads.
+ */
+int8_t i2c_bus_submit(i2c_bus_t *bus, i2c_bus_direction_t direction, uint16_t address, uint16_t memory_address,
+		const uint8_t *data, uint8_t size, i2c_bus_callback_t callback, void *context);
+
+/**
+ * Run a transaction and wait its completion, it must be called from the main loop
+ */
+int8_t i2c_bus_transfer(i2c_bus_t *bus, i2c_bus_direction_t direction, uint16_t address, uint16_t memory_address,
+		uint8_t *data, uint8_t size);
+
+/**
+ * Return 1 if no transaction is running or queued
+ */
+uint8_t i2c_bus_idle(i2c_bus_t *bus);
+
+/**
+ * Check the timeout of the running transaction and recover the bus, it is called by the main loop
+ */
+void i2c_bus_process(i2c_bus_t *bus);
+
+/**
+ * Handle the end of the running transaction, it is called by the HAL callbacks; the next one is started by i2c_bus_process()
+ */
+void i2c_bus_complete(i2c_bus_t *bus, int8_t result);
+
+#endif /* INC_I2C_BUS_H_ */
@@ -0,0 +1,51 @@
+/*
+ * idle_meter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_IDLE_METER_H_
+#define INC_IDLE_METER_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/**
+ * Define the measure window, in core cycles: one second
+ */
+#define IDLE_METER_WINDOW (SystemCoreClock)
+
+/**
+ * Define idle meter structure: the cycles spent sleeping, counted by the DWT cycle counter
+ */
+struct idle_meter_s{
+
+	uint32_t window_start; // cycle counter at the start of the current window
+
+	uint32_t idle_cycles; // cycles spent sleeping in the current window
+
+	uint8_t idle_percent; // share of the last complete window spent sleeping
+
+	uint32_t sleeps; // sleeps since the boot
+
+};
+
+typedef struct idle_meter_s idle_meter_t;
+
+/**
+ * Initialize the idle meter and start the DWT cycle counter
+ */
+void init_idle_meter(idle_meter_t *meter);
+
+/**
+ * Sleep until the next interrupt and count the cycles spent sleeping, it must be called from thread mode
+ */
+void idle_meter_sleep(idle_meter_t *meter);
+
+/**
+ * Get the share, in percent, of the last complete window spent sleeping
+ */
+uint8_t idle_meter_percent(idle_meter_t *meter);
+
+#endif /* INC_IDLE_METER_H_ */
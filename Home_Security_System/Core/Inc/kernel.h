@@ -0,0 +1,220 @@
+/*
+ * kernel.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_KERNEL_H_
+#define INC_KERNEL_H_
+
+#include <stdint.h>
+
+/**
+ * Define kernel return values
+ */
+#define KERNEL_OK (0)
+#define KERNEL_ERR (-1)
+#define KERNEL_TIMEOUT (-2)
+
+/**
+ * Define the maximum number of tasks, the idle one excluded
+ */
+#define KERNEL_MAX_TASKS (4)
+
+/**
+ * Define the idle task: the lowest priority, it sleeps until the next interrupt
+ */
+#define KERNEL_IDLE_PRIORITY (255)
+#define KERNEL_IDLE_STACK_WORDS (64)
+
+/**
+ * Define the timeout of a wait without limit, in ticks
+ */
+#define KERNEL_WAIT_FOREVER (0xFFFFFFFF)
+
+/**
+ * Define the pattern of the unused stack words, the high-water mark is the first word changed
+ */
+#define KERNEL_STACK_FILL (0xA5A5A5A5)
+
+/**
+ * Define the entry type of the tasks, it never returns
+ */
+typedef void (*kernel_task_entry_t)(void);
+
+/**
+ * Define task status
+ */
+typedef enum{
+	TASK_READY,
+	TASK_BLOCKED
+} kernel_task_state_t;
+
+/**
+ * Define task structure
+ */
+struct kernel_task_s{
+
+	uint32_t *sp; // saved stack pointer, the first member: it is written by the context switch
+
+	uint32_t *stack; // lowest word of the stack
+
+	uint16_t stack_words;
+
+	uint8_t priority; // 0 is the highest
+
+	kernel_task_state_t state;
+
+	const char *name;
+
+	uint32_t timeout; // ticks left to a blocked task, KERNEL_WAIT_FOREVER without limit
+
+	struct kernel_task_s **wait_list; // list of the object waited by the task, NULL for a sleep
+
+	struct kernel_task_s *next_waiter; // next task blocked on the same object, by priority
+
+	int8_t result; // result of the last wait
+
+};
+
+typedef struct kernel_task_s kernel_task_t;
+
+/**
+ * Define kernel structure: fixed priority preemptive scheduler, a task runs until a higher one is ready
+ */
+struct kernel_s{
+
+	kernel_task_t *current; // running task, the first member: it is read by the context switch
+
+	kernel_task_t *next; // task selected by the last schedule
+
+	kernel_task_t *tasks[KERNEL_MAX_TASKS + 1]; // by priority, the idle one is the last
+
+	uint8_t count;
+
+	uint8_t running;
+
+	uint32_t switches; // context switches since the start
+
+};
+
+typedef struct kernel_s kernel_t;
+
+/**
+ * Define counting semaphore structure
+ */
+struct kernel_semaphore_s{
+
+	uint16_t count;
+
+	uint16_t limit; // count reached by the gives, 1 for a binary semaphore
+
+	kernel_task_t *waiters; // tasks blocked by a take, by priority
+
+};
+
+typedef struct kernel_semaphore_s kernel_semaphore_t;
+
+/**
+ * Define message queue structure: fixed size items copied into a static buffer
+ */
+struct kernel_queue_s{
+
+	uint8_t *buffer;
+
+	uint16_t item_size;
+
+	uint16_t capacity; // items of the buffer
+
+	uint16_t head; // next item to read
+
+	uint16_t length; // items queued
+
+	kernel_semaphore_t items; // one count for each item not taken by a receive yet
+
+};
+
+typedef struct kernel_queue_s kernel_queue_t;
+
+/**
+ * Initialize the kernel, only the idle task is added
+ */
+void init_kernel(kernel_t *kernel);
+
+/**
+ * Add a task with its static stack, before the start
+ */
+int8_t kernel_add_task(kernel_t *kernel, kernel_task_t *task, const char *name, uint8_t priority, kernel_task_entry_t entry, uint32_t *stack, uint16_t stack_words);
+
+/**
+ * Start the highest priority task, it never returns
+ */
+void kernel_start(kernel_t *kernel);
+
+/**
+ * Advance the timeouts of the blocked tasks, it is called by the tick interrupt
+ */
+void kernel_tick(kernel_t *kernel);
+
+/**
+ * Return the ticks to the first timeout of the blocked tasks, KERNEL_WAIT_FOREVER if none
+ */
+uint32_t kernel_next_timeout(kernel_t *kernel);
+
+/**
+ * Advance the timeouts of the blocked tasks by some ticks at once, it compensates the ticks lost by the stop mode
+ */
+void kernel_skip(kernel_t *kernel, uint32_t ticks);
+
+/**
+ * Block the running task for some ticks
+ */
+void kernel_sleep(kernel_t *kernel, uint32_t ticks);
+
+/**
+ * Return the running task, NULL before the start
+ */
+kernel_task_t *kernel_current(kernel_t *kernel);
+
+/**
+ * Select the task to resume, it is called by the context switch
+ */
+kernel_task_t *kernel_switch_context(kernel_t *kernel);
+
+/**
+ * Return the stack words never used by the task
+ */
+uint16_t kernel_task_stack_free(kernel_task_t *task);
+
+/**
+ * Initialize a semaphore with its initial count and its limit
+ */
+void init_kernel_semaphore(kernel_semaphore_t *semaphore, uint16_t count, uint16_t limit);
+
+/**
+ * Take a semaphore, the running task is blocked up to timeout ticks while its count is 0
+ */
+int8_t kernel_semaphore_take(kernel_t *kernel, kernel_semaphore_t *semaphore, uint32_t timeout);
+
+/**
+ * Give a semaphore, it can be called from any interrupt
+ */
+int8_t kernel_semaphore_give(kernel_t *kernel, kernel_semaphore_t *semaphore);
+
+/**
+ * Initialize a message queue on a buffer of capacity items
+ */
+void init_kernel_queue(kernel_queue_t *queue, void *buffer, uint16_t item_size, uint16_t capacity);
+
+/**
+ * Copy an item into the queue, it can be called from any interrupt and it never blocks
+ */
+int8_t kernel_queue_send(kernel_t *kernel, kernel_queue_t *queue, const void *item);
+
+/**
+ * Copy the oldest item out of the queue, the running task is blocked up to timeout ticks while it is empty
+ */
+int8_t kernel_queue_receive(kernel_t *kernel, kernel_queue_t *queue, void *item, uint32_t timeout);
+
+#endif /* INC_KERNEL_H_ */
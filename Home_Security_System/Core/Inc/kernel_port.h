@@ -0,0 +1,33 @@
+/*
+ * kernel_port.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_KERNEL_PORT_H_
+#define INC_KERNEL_PORT_H_
+
+#include "kernel.h"
+
+/**
+ * Fill the stack of a task and build the frame of its first switch
+ */
+void kernel_port_init_stack(kernel_task_t *task, kernel_task_entry_t entry);
+
+/**
+ * Request a context switch, it happens once no interrupt is running and the interrupts are enabled
+ */
+void kernel_port_request_switch();
+
+/**
+ * Sleep until the next interrupt, it is called by the idle task
+ */
+void kernel_port_idle();
+
+/**
+ * Switch from the main to the first task, it never returns
+ */
+void kernel_port_start(kernel_t *kernel);
+
+#endif /* INC_KERNEL_PORT_H_ */
@@ -0,0 +1,97 @@
+/*
+ * log_format.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_LOG_FORMAT_H_
+#define INC_LOG_FORMAT_H_
+
+#include <stdint.h>
+#include "ds1307rtc.h"
+
+/**
+ * Define log format return values
+ */
+#define LOG_FORMAT_OK (0)
+#define LOG_FORMAT_ERR (-1)
+
+/**
+ * Define the length of the date time field "[dd-mm-yyyy hh:mm:ss]"
+ */
+#define LOG_FORMAT_DATE_TIME_SIZE (21)
+
+/**
+ * Define the length of the timestamp field "[dd-mm-yyyy hh:mm:ss.mmm]"
+ */
+#define LOG_FORMAT_TIMESTAMP_SIZE (25)
+
+/**
+ * Define log format structure: a caller-provided buffer filled from the start
+ */
+struct log_format_s{
+
+	char *buffer;
+
+	uint16_t size; // buffer capacity
+
+	uint16_t length; // characters written into buffer
+
+	uint8_t overflow; // 1 if a field has been truncated
+
+};
+
+typedef struct log_format_s log_format_t;
+
+/**
+ * Initialize the log format structure on the given buffer
+ */
+void log_format_init(log_format_t *format, char *buffer, uint16_t size);
+
+/**
+ * Append a character
+ */
+int8_t log_format_char(log_format_t *format, char c);
+
+/**
+ * Append a null terminated string
+ */
+int8_t log_format_string(log_format_t *format, const char *string);
+
+/**
+ * Append size characters of the given buffer
+ */
+int8_t log_format_chars(log_format_t *format, const uint8_t *chars, uint16_t size);
+
+/**
+ * Append an unsigned decimal value, padded with zeros to width digits (0 for no padding)
+ */
+int8_t log_format_uint(log_format_t *format, uint32_t value, uint8_t width);
+
+/**
+ * Append a signed decimal value
+ */
+int8_t log_format_int(log_format_t *format, int32_t value);
+
+/**
+ * Append the given date and time, as "[dd-mm-yyyy hh:mm:ss]"
+ */
+int8_t log_format_date_time(log_format_t *format, date_time_t *date_time);
+
+/**
+ * Append the given date and time with milliseconds, as "[dd-mm-yyyy hh:mm:ss.mmm]"
+ */
+int8_t log_format_timestamp(log_format_t *format, date_time_t *date_time, uint16_t milliseconds);
+
+/**
+ * Append a message text replacing each "%u" or "%d" with the next argument
+ */
+int8_t log_format_message(log_format_t *format, const char *text, const uint32_t *args);
+
+/**
+ * Terminate the formatted string with '\0' and return its length
+ */
+uint16_t log_format_end(log_format_t *format);
+
+#endif /* INC_LOG_FORMAT_H_ */
@@ -0,0 +1,69 @@
+/*
+ * log_frame.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_LOG_FRAME_H_
+#define INC_LOG_FRAME_H_
+
+#include <stdint.h>
+
+/**
+ * Define the frame delimiter, COBS encoding removes it from the frame content
+ */
+#define LOG_FRAME_DELIMITER (0x00)
+
+/**
+ * Define the record types
+ */
+#define LOG_FRAME_STATUS (0x01)
+#define LOG_FRAME_EVENT (0x02)
+#define LOG_FRAME_TELEMETRY (0x03)
+
+/**
+ * Define the size of the status and event records: type, date, month, year, hour, minute, second, states,
+ * milliseconds (little endian)
+ */
+#define LOG_FRAME_STATUS_SIZE (10)
+
+/**
+ * Define the size of the CRC appended to each record
+ */
+#define LOG_FRAME_CRC_SIZE (2)
+
+/**
+ * Define the maximum size of a record
+ */
+#define LOG_FRAME_MAX_RECORD_SIZE (64)
+
+/**
+ * Define the size of the frame carrying a record of the given size:
+ * leading delimiter, COBS overhead byte, record, CRC, trailing delimiter
+ */
+#define LOG_FRAME_SIZE(record_size) ((record_size) + LOG_FRAME_CRC_SIZE + 3)
+
+/**
+ * Pack the states of the status record: area in bits 0-1, barrier in bits 2-3, system in bits 4-5
+ */
+#define LOG_FRAME_PACK_STATES(area, barrier, system) ((uint8_t)(((area) & 0x03) | (((barrier) & 0x03) << 2) | (((system) & 0x03) << 4)))
+
+/**
+ * Unpack the states of the status record
+ */
+#define LOG_FRAME_AREA_STATE(states) ((states) & 0x03)
+#define LOG_FRAME_BARRIER_STATE(states) (((states) >> 2) & 0x03)
+#define LOG_FRAME_SYSTEM_STATE(states) (((states) >> 4) & 0x03)
+
+/**
+ * Compute the CRC-16/CCITT-FALSE of the given buffer
+ */
+uint16_t log_frame_crc16(const uint8_t *data, uint16_t size);
+
+/**
+ * Append the CRC to the given record, encode it with COBS and delimit it, return the frame size
+ */
+uint16_t log_frame_encode(const uint8_t *record, uint16_t size, uint8_t *frame);
+
+#endif /* INC_LOG_FRAME_H_ */
@@ -0,0 +1,38 @@
+/*
+ * log_messages.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_LOG_MESSAGES_H_
+#define INC_LOG_MESSAGES_H_
+
+/**
+ * Define the deferred log messages: identifier and text, where each "%u" (unsigned) or "%d" (signed) is replaced
+ * by the next argument.
+ * LOG_ID_STATUS and LOG_ID_EVENT carry epoch seconds, milliseconds and packed states, they are formatted as the
+ * status and state change lines. Tools/log_ring_decoder.py parses this list: append new messages
+ * at the end, so that the identifiers of the old dumps do not change.
+ */
+#define LOG_MESSAGES \
+	LOG_MESSAGE(LOG_ID_STATUS, "STATUS") \
+	LOG_MESSAGE(LOG_ID_EVENT, "EVENT") \
+	LOG_MESSAGE(LOG_ID_RTC_ERROR, "RTC PROBLEM: CHECK CONNECTIONS AND RESTART THE BOARD") \
+	LOG_MESSAGE(LOG_ID_I2C_ERROR, "I2C ERROR %u") \
+	LOG_MESSAGE(LOG_ID_UART_ERROR, "UART ERROR %u") \
+	LOG_MESSAGE(LOG_ID_RING_OVERFLOW, "LOG RING OVERFLOW: %u RECORDS DROPPED") \
+	LOG_MESSAGE(LOG_ID_TIMEBASE_RESYNC, "TIMEBASE RESYNC %d S - DRIFT %d MS IN %u S")
+
+/**
+ * Define the message identifiers, 0 marks an unused record
+ */
+#define LOG_MESSAGE(id, text) id,
+typedef enum{
+	LOG_ID_NONE,
+	LOG_MESSAGES
+	LOG_IDS
+} log_id_t;
+#undef LOG_MESSAGE
+
+#endif /* INC_LOG_MESSAGES_H_ */
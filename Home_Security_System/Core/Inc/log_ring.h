@@ -0,0 +1,83 @@
+/*
+ * log_ring.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_LOG_RING_H_
+#define INC_LOG_RING_H_
+
+#include <stdint.h>
+#include "log_messages.h"
+
+/**
+ * Define log ring return values
+ */
+#define LOG_RING_OK (0)
+#define LOG_RING_ERR (-1)
+
+/**
+ * Define the number of records, it must be a power of two. One record is always kept free.
+ */
+#define LOG_RING_SIZE (32)
+
+/**
+ * Define the number of raw arguments of a record
+ */
+#define LOG_RING_ARGS (3)
+
+/**
+ * Define log record structure: 20 bytes, the layout is read by Tools/log_ring_decoder.py
+ */
+struct log_record_s{
+
+	uint32_t tick; // HAL_GetTick() when the record has been pushed
+
+	uint32_t args[LOG_RING_ARGS];
+
+	uint16_t sequence; // incremented by each pushed record
+
+	uint8_t id; // log_id_t
+
+	uint8_t reserved;
+
+};
+
+typedef struct log_record_s log_record_t;
+
+/**
+ * Define log ring structure
+ */
+struct log_ring_s{
+
+	log_record_t records[LOG_RING_SIZE];
+
+	volatile uint16_t head; // next record to write
+
+	volatile uint16_t tail; // next record to read
+
+	volatile uint32_t dropped; // records lost because the ring was full
+
+	uint16_t sequence;
+
+};
+
+typedef struct log_ring_s log_ring_t;
+
+/**
+ * Initialize the log ring
+ */
+void log_ring_init(log_ring_t *ring);
+
+/**
+ * Push a record, it can be called from any interrupt
+ */
+int8_t log_ring_push(log_ring_t *ring, log_id_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+
+/**
+ * Pop the oldest record, it must be called by a single consumer
+ */
+int8_t log_ring_pop(log_ring_t *ring, log_record_t *record);
+
+#endif /* INC_LOG_RING_H_ */
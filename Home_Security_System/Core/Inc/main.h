@@ -55,6 +55,7 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+int8_t check_putty(uint32_t baud_rate);
 
 /* USER CODE END EFP */
 
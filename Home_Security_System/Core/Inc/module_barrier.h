@@ -13,6 +13,17 @@
 #include "photoresistor.h"
 #include "laser.h"
 
+/**
+ * Define how long the laser is kept on before the threshold_down reading, in ms
+ */
+#define BARRIER_CALIBRATION_TIME (1000)
+
+/**
+ * Define the results of complete_threshold()
+ */
+#define BARRIER_CALIBRATION_DONE (0)
+#define BARRIER_CALIBRATION_PENDING (1)
+
 /**
  * Define barrier struct
  */
@@ -36,6 +47,8 @@ typedef struct{
 
 	uint32_t stable_signal;
 
+	uint32_t calibration_start; // HAL tick of the laser switch on of start_threshold()
+
 }module_barrier_t;
 
 /**
@@ -48,6 +61,21 @@ void init_module_barrier(module_barrier_t *module_barrier,module_state_t state,
  */
 void set_threshold(module_barrier_t *module_barrier);
 
+/**
+ * Read the threshold_up and switch the laser on, the calibration goes on while the caller does other work
+ */
+void start_threshold(module_barrier_t *module_barrier);
+
+/**
+ * Read the threshold_down once the laser has been on for BARRIER_CALIBRATION_TIME, BARRIER_CALIBRATION_PENDING before
+ */
+int8_t complete_threshold(module_barrier_t *module_barrier);
+
+/**
+ * Restore the up and down threshold measured at a previous boot
+ */
+void restore_threshold(module_barrier_t *module_barrier, uint16_t threshold_up, uint16_t threshold_down);
+
 /**
  * Get barrier state
  */
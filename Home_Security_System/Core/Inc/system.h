@@ -16,6 +16,16 @@
 #include "ds1307rtc.h"
 #include "system_log.h"
 #include "configuration_protocol.h"
+#include "console.h"
+#include "telemetry.h"
+#include "system_clock.h"
+#include "i2c_bus.h"
+#include "config_store.h"
+#include "idle_meter.h"
+#include "config_schema.h"
+#include "event_queue.h"
+#include "kernel.h"
+#include "tickless.h"
 
 #define ACTIVE_AREA_ALLARM ("A#")
 #define ACTIVE_BARRIER_ALLARM ("B#")
@@ -39,6 +49,20 @@
 #define COMMAND_ERROR (-3)
 #define COMMAND_BUFFER_SIZE (7)
 
+/**
+ * Define the tasks: the alarm task dispatches the events of the sensors and of the alarm timers, the background
+ * task runs the boot, the keypad and console commands, the log and the uart
+ */
+#define ALARM_TASK_PRIORITY (1)
+#define ALARM_STACK_WORDS (384)
+#define BACKGROUND_TASK_PRIORITY (2)
+#define BACKGROUND_STACK_WORDS (1024)
+
+/**
+ * Define the number of keypad buttons queued for the background task
+ */
+#define KEYPAD_QUEUE_SIZE (8)
+
 #define COMMAND_PULSE (99)
 #define PIR_PULSE (199)
 #define BARRIER_PULSE (499)
@@ -55,6 +79,20 @@ typedef enum{
 
 }system_state_t;
 
+/**
+ * Define the events posted by the interrupts and dispatched by the alarm task
+ */
+typedef enum{
+
+	EVENT_PIR_EDGE, // argument: pin level
+	EVENT_PIR_STABLE,
+	EVENT_BARRIER_CROSSED,
+	EVENT_PIR_DELAY,
+	EVENT_BARRIER_DELAY,
+	EVENT_ALARM_DURATION
+
+}system_event_t;
+
 /**
  * Define system struct
  */
@@ -68,16 +106,26 @@ typedef struct{
 	system_configuration_t *system_configuration;
 	configuration_protocol_t *protocol;
 	system_log_t *system_log;
+	i2c_bus_t *i2c_bus;
 	rtc_t *rtc;
+	uart_handler_t *uart;
+	console_t *console;
+	telemetry_t *telemetry;
+	system_clock_t *clock;
+	config_store_t *config_store;
+	idle_meter_t *idle_meter;
+	event_queue_t *event_queue;
+	kernel_t *kernel;
+	tickless_t *tickless;
 
 } system_t;
 
 extern system_t system;
 
 /**
- * Initialize the system
+ * Initialize the system, its boot stages are run by process_system()
  */
-int8_t init_system();
+void init_system();
 
 /**
  * Initialize all the support elements
@@ -86,11 +134,51 @@ int8_t init_system();
 int8_t init_elements();
 
 /**
- * Run the system
+ * Start the tasks of the system, it never returns
+ */
+void start_system_tasks();
+
+/**
+ * Run the system, once the sensors are initialized
  */
 
 void run_system();
 
+/**
+ * Run the boot stages and process the deferred work of the system, called by the background task
+ */
+void process_system();
+
+/**
+ * Post an event to the alarm task, called by the interrupts; only the pir edges can be dropped by a full queue
+ */
+int8_t post_system_event(system_event_t event, uint16_t arg);
+
+/**
+ * Start the measure of the idle time and prepare the stop mode, called by the main before any wait
+ */
+void init_system_idle();
+
+/**
+ * Sleep until the next interrupt, in stop mode while no peripheral needs the clocks, called by the loops that wait for an interrupt
+ */
+void system_idle();
+
+/**
+ * Read the console baud rate saved into the flash, UART_DEFAULT_BAUD_RATE if none has been saved
+ */
+uint32_t load_baud_rate();
+
+/**
+ * Save the console baud rate into the flash
+ */
+int8_t store_baud_rate(uint32_t baud_rate);
+
+/**
+ * Read the configuration saved into the flash, SYS_ERR if none has been saved
+ */
+int8_t load_configuration();
+
 /**
  * Inizialize all the sensor
  */
@@ -160,5 +248,20 @@ void get_user_pin(uint8_t *dest);
  */
 int8_t execute_command(uint8_t* command);
 
+/**
+ * Check the user pin, execute the command and send the feedback
+ */
+int8_t run_user_command(uint8_t *buffer);
+
+/**
+ * Check the user pin and change a field of the configuration in use, without restarting the system
+ */
+int8_t update_configuration(uint8_t *buffer, const config_field_t *field, const uint8_t *text);
+
+/**
+ * Get the system state and convert it into string
+ */
+char* get_system_state_string(system_state_t state);
+
 
 #endif /* INC_SYSTEM_H_ */
@@ -0,0 +1,178 @@
+/*
+ * system_clock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_SYSTEM_CLOCK_H_
+#define INC_SYSTEM_CLOCK_H_
+
+#include <stdint.h>
+#include "ds1307rtc.h"
+
+/**
+ * Define system clock return values
+ */
+#define SYSTEM_CLOCK_OK (0)
+#define SYSTEM_CLOCK_ERR (-1)
+
+/**
+ * Define the difference, in seconds, tolerated between the internal rtc and the backup at boot
+ */
+#define SYSTEM_CLOCK_TOLERANCE (2)
+
+/**
+ * Define the value of the backup register that marks a set calendar
+ */
+#define SYSTEM_CLOCK_MARKER (0x32F2)
+
+/**
+ * Define the timeout of the internal rtc initialization mode and synchronization, in ms
+ */
+#define SYSTEM_CLOCK_TIMEOUT (1000)
+
+/**
+ * Define the polls of a flag of the internal rtc while the interrupts are masked, the HAL tick is not counting
+ */
+#define SYSTEM_CLOCK_POLLS (2000)
+
+/**
+ * Define the oscillator of the internal rtc
+ */
+typedef enum{
+	SYSTEM_CLOCK_NONE, // the internal rtc did not start: the time is read from the backup
+	SYSTEM_CLOCK_LSE, // 32768 Hz crystal
+	SYSTEM_CLOCK_LSI // internal 32 kHz RC, a few percent of error
+} system_clock_source_t;
+
+/**
+ * Define what the boot reconciliation has done
+ */
+typedef enum{
+	SYSTEM_CLOCK_KEPT, // the internal rtc and the backup agree
+	SYSTEM_CLOCK_SEEDED, // the internal rtc has been set from the backup
+	SYSTEM_CLOCK_RESTORED, // the backup has been set from the internal rtc
+	SYSTEM_CLOCK_UNSET, // no valid time is available
+	SYSTEM_CLOCK_RESTORE_FAILED // the internal rtc keeps the time, the backup could not be set from it
+} system_clock_reconcile_t;
+
+/**
+ * Define the callback type of the second and alarm interrupts
+ */
+typedef void (*system_clock_callback_t)(void);
+
+/**
+ * Define system clock structure: the internal rtc, backed up by the DS1307
+ */
+struct system_clock_s{
+
+	system_clock_source_t source;
+
+	system_clock_reconcile_t reconcile;
+
+	uint16_t prediv_s; // synchronous prescaler, the sub-second counter counts down from it
+
+	rtc_t *backup;
+
+	system_clock_callback_t second_callback; // called by the wakeup interrupt, each second
+
+	system_clock_callback_t alarm_callback; // called by the alarm A interrupt
+
+	uint32_t oscillator_start; // HAL tick of the crystal switch on
+
+};
+
+typedef struct system_clock_s system_clock_t;
+
+/**
+ * Switch the crystal on, its startup goes on while the caller does other work
+ */
+void system_clock_start_oscillator(system_clock_t *clock);
+
+/**
+ * Return 1 if the crystal is ready or its startup timeout has elapsed
+ */
+uint8_t system_clock_oscillator_settled(system_clock_t *clock);
+
+/**
+ * Start the internal rtc oscillator, the calendar is kept if already set
+ */
+int8_t init_system_clock(system_clock_t *clock, rtc_t *backup);
+
+/**
+ * Reconcile the internal rtc and the backup, it is called once at boot
+ */
+system_clock_reconcile_t system_clock_reconcile(system_clock_t *clock);
+
+/**
+ * Return 1 if the internal rtc keeps the time
+ */
+uint8_t system_clock_is_internal(system_clock_t *clock);
+
+/**
+ * Read the date time and the milliseconds from the internal rtc registers
+ */
+int8_t system_clock_get(system_clock_t *clock, date_time_t *date_time, uint16_t *milliseconds);
+
+/**
+ * Set the date time of the internal rtc and of the backup
+ */
+int8_t system_clock_set(system_clock_t *clock, date_time_t *date_time);
+
+/**
+ * Start the wakeup interrupt, each second at the increment of the calendar
+ */
+int8_t system_clock_start_seconds(system_clock_t *clock, system_clock_callback_t callback);
+
+/**
+ * Start the alarm A interrupt, each day at the hours, minutes and seconds of date_time
+ */
+int8_t system_clock_set_alarm(system_clock_t *clock, date_time_t *date_time, system_clock_callback_t callback);
+
+/**
+ * Stop the alarm A interrupt
+ */
+void system_clock_stop_alarm(system_clock_t *clock);
+
+/**
+ * Return the sub-second periods elapsed since midnight, prediv_s + 1 each second
+ */
+uint32_t system_clock_periods(system_clock_t *clock);
+
+/**
+ * Return the sub-second periods elapsed from one value of system_clock_periods() to a later one
+ */
+uint32_t system_clock_elapsed(system_clock_t *clock, uint32_t from, uint32_t to);
+
+/**
+ * Start the alarm B interrupt at a period within the next second, it wakes the core from the stop mode
+ */
+int8_t system_clock_start_timeout(system_clock_t *clock, uint32_t periods);
+
+/**
+ * Stop the alarm B interrupt
+ */
+void system_clock_stop_timeout(system_clock_t *clock);
+
+/**
+ * Wait for the update of the calendar shadow registers, it must be called after a wakeup from the stop mode
+ */
+int8_t system_clock_resync(system_clock_t *clock);
+
+/**
+ * Get the name of the clock source
+ */
+char* get_system_clock_source_string(system_clock_t *clock);
+
+/**
+ * Handle the wakeup interrupt, it must be called by RTC_WKUP_IRQHandler
+ */
+void system_clock_wakeup_IRQHandler();
+
+/**
+ * Handle the alarm interrupt, it must be called by RTC_Alarm_IRQHandler
+ */
+void system_clock_alarm_IRQHandler();
+
+#endif /* INC_SYSTEM_CLOCK_H_ */
@@ -12,6 +12,10 @@
 #include "stm32f4xx_hal.h"
 #include "ds1307rtc.h"
 #include "uart_handler.h"
+#include "sensor.h"
+#include "log_ring.h"
+#include "timebase.h"
+#include "timer_wheel.h"
 
 /**
  * Define standard messages
@@ -19,6 +23,7 @@
 #define SYSTEM_BOOT ("\n\rSYSTEM BOOT ")
 #define CUSTOM_CONFIGURATION_LOADED ("\n\rSystem Configuration Loaded\n\r")
 #define DEFAULT_CONFIGURATION_LOADED ("\n\rSystem Configuration Rejected\n\r")
+#define STORED_CONFIGURATION_LOADED ("\n\rStored Configuration Loaded\n\r")
 #define ERROR_STRING ("\n\rERROR RESTART THE BOARD")
 
 
@@ -27,9 +32,21 @@
 #define ALLARMED_STRING (" ALLARMED ")
 
 /**
- * Define the system log period
+ * Define system log return values
  */
-#define SYSTEM_LOG_PERIOD (9999)
+#define SYSTEM_LOG_OK (0)
+#define SYSTEM_LOG_ERR (-1)
+
+/**
+ * Define the default heartbeat period, in seconds, and its maximum value
+ */
+#define SYSTEM_LOG_HEARTBEAT (60)
+#define SYSTEM_LOG_MAX_HEARTBEAT (3600)
+
+/**
+ * Define the period, in seconds of the rtc square wave, of the readings that resync the timebase
+ */
+#define SYSTEM_LOG_RESYNC (3600)
 
 /**
  * Define system log status
@@ -43,15 +60,39 @@ typedef enum{
 	STOP_L
 } log_state_t;
 
+/**
+ * Define system log output format
+ */
+typedef enum{
+	LOG_MODE_ASCII, // "[dd-mm-yyyy hh:mm:ss] AREA ... - BARRIER ..." lines
+	LOG_MODE_BINARY // COBS framed records with CRC, see log_frame.h
+} log_mode_t;
+
+/**
+ * Define the output format used at boot
+ */
+#define SYSTEM_LOG_DEFAULT_MODE (LOG_MODE_ASCII)
+
 /**
  * Define system log structure
  */
 struct system_log_s{
 
 	log_state_t state;
+	log_mode_t mode;
+	uint16_t heartbeat; // period of the status message in seconds, 0 if disabled
+	volatile uint8_t heartbeat_pending; // 1 if the status message waits for the date and time
+	volatile uint8_t event_pending; // 1 if a state change record waits for the date and time
+	uint8_t states; // last seen states, packed
+	log_ring_t ring; // records waiting to be formatted
+	uint32_t reported_dropped; // ring overflows already reported
+	timebase_t timebase; // rtc date time anchored to the HAL tick, for millisecond timestamps
+	uint16_t resync_elapsed; // square wave seconds since the last rtc reading
+	uint32_t reads; // rtc readings started
 	rtc_t *rtc;
 	uart_handler_t *uart;
-	TIM_HandleTypeDef *timer;
+	timer_wheel_t *wheel;
+	virtual_timer_t heartbeat_timer; // period of the status message
 
 };
 
@@ -60,7 +101,7 @@ typedef struct system_log_s system_log_t;
 /**
  * Initialize system_log
  */
-void init_system_log(system_log_t *system_log, rtc_t *rtc, uart_handler_t *uart_handler, TIM_HandleTypeDef *timer);
+void init_system_log(system_log_t *system_log, rtc_t *rtc, uart_handler_t *uart_handler, timer_wheel_t *wheel);
 
 /**
  * Start the log procedure
@@ -72,16 +113,51 @@ void start_system_log(system_log_t *system_log);
  */
 void stop_system_log(system_log_t *system_log);
 
+/**
+ * Select the output format of the log messages
+ */
+void set_system_log_mode(system_log_t *system_log, log_mode_t mode);
+
+/**
+ * Set the heartbeat period in seconds, 0 disables the periodic status message
+ */
+int8_t set_system_log_heartbeat(system_log_t *system_log, uint16_t heartbeat);
+
+/**
+ * Check the system and sensors states and send a state change record if they have changed
+ */
+void system_log_check_state(system_log_t *system_log);
+
+/**
+ * Push a record into the log ring, it can be called from any interrupt
+ */
+int8_t system_log_event(system_log_t *system_log, log_id_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+
+/**
+ * Format and send the records pushed into the log ring, it is called by the main loop
+ */
+void system_log_process(system_log_t *system_log);
+
+/**
+ * Advance the log timebase by one second, it is called on each rtc square wave edge
+ */
+void system_log_second(system_log_t *system_log);
+
 /**
  * Start to send the messages for the log
  */
 void start_send_log_message(system_log_t *system_log);
 
 /**
- * Perform the action in response to the UART transmission callback
+ * Format and queue the system log message, in response to the rtc update callback
  */
 void log_callback_tx();
 
+/**
+ * Discard the records waiting for the date and time, in response to a failed rtc reading
+ */
+void log_callback_error();
+
 
 // Declaration of some module's functions
 
@@ -96,9 +172,9 @@ int8_t system_log_send_message_IT(system_log_t *system_log, uint8_t *buffer, int
 int8_t system_log_send_message_DMA(system_log_t *system_log, uint8_t *buffer, int16_t buffer_size);
 
 /**
- * Send the given buffer with the given size through UART, in blocking mode
+ * Queue the given buffer with the given size for the transmission through UART, on the given channel
  */
-int8_t system_log_send_message(system_log_t *system_log, uint8_t *buffer, int16_t buffer_size);
+int8_t system_log_send_message(system_log_t *system_log, uart_channel_t channel, uint8_t *buffer, int16_t buffer_size);
 
 
 /**
@@ -117,5 +193,10 @@ int8_t system_log_receive_message_DMA(system_log_t *system_log, uint8_t *buffer,
  */
 int8_t system_log_receive_message(system_log_t *system_log, uint8_t *buffer, int16_t buffer_size);
 
+/**
+ * Get the sensor state and convert it into string
+ */
+char* get_state_string(module_state_t state);
+
 
 #endif /* INC_SYSTEM_LOG_H_ */
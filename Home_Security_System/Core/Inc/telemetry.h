@@ -0,0 +1,124 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_TELEMETRY_H_
+#define INC_TELEMETRY_H_
+
+#include <stdint.h>
+#include "uart_handler.h"
+
+/**
+ * Define telemetry return values
+ */
+#define TELEMETRY_OK (0)
+#define TELEMETRY_ERR (-1)
+
+/**
+ * Define the number of decimated samples carried by a record
+ */
+#define TELEMETRY_SAMPLES (8)
+
+/**
+ * Define the size of the telemetry record: type, sequence, decimation, threshold, stable signal,
+ * number of samples, then value and stability counter of each sample (16 bit fields, little endian)
+ */
+#define TELEMETRY_RECORD_SIZE (9 + 4*TELEMETRY_SAMPLES)
+
+/**
+ * Define the sample blocks of the ring between the ADC callback and the main loop, a power of two
+ */
+#define TELEMETRY_BLOCKS (8)
+
+/**
+ * Define the frames sent together by one enqueue: they fill a DMA transfer of the telemetry channel
+ */
+#define TELEMETRY_BATCH (5)
+
+/**
+ * Define the barrier ADC conversion rate: 8 MHz ADC clock, 480 + 12 cycles each conversion
+ */
+#define TELEMETRY_ADC_RATE (16260)
+
+/**
+ * Define the percentage of the link bandwidth used by the stream, the rest is left to the log
+ */
+#define TELEMETRY_LINK_SHARE (75)
+
+/**
+ * Define telemetry sample structure
+ */
+struct telemetry_sample_s{
+
+	uint16_t value; // mean of the decimated conversions
+
+	uint16_t counter; // highest stability counter during the decimated conversions
+
+};
+
+typedef struct telemetry_sample_s telemetry_sample_t;
+
+/**
+ * Define telemetry structure: a ring of sample blocks, filled by the ADC callback and sent in batches by the main loop
+ */
+struct telemetry_s{
+
+	volatile uint8_t active;
+
+	uint16_t decimation; // conversions averaged into a sample
+
+	uint32_t baud_rate; // baud rate used to compute decimation
+
+	telemetry_sample_t blocks[TELEMETRY_BLOCKS][TELEMETRY_SAMPLES];
+
+	volatile uint8_t head; // block written by the ADC callback, free running
+
+	volatile uint8_t tail; // oldest block not sent yet, free running
+
+	uint8_t count; // samples written into the filling block
+
+	uint32_t sum; // sum of the conversions of the current sample
+
+	uint16_t accumulated; // conversions of the current sample
+
+	uint32_t max_counter;
+
+	uint8_t sequence; // incremented by each record
+
+	volatile uint32_t overruns; // blocks lost because the ring was full
+
+	uart_handler_t *uart;
+
+};
+
+typedef struct telemetry_s telemetry_t;
+
+/**
+ * Initialize the telemetry, it is stopped
+ */
+void init_telemetry(telemetry_t *telemetry, uart_handler_t *uart);
+
+/**
+ * Start streaming the barrier samples
+ */
+void start_telemetry(telemetry_t *telemetry);
+
+/**
+ * Stop streaming the barrier samples
+ */
+void stop_telemetry(telemetry_t *telemetry);
+
+/**
+ * Add a barrier conversion and its stability counter, it is called by the ADC callback
+ */
+void telemetry_sample(telemetry_t *telemetry, uint16_t value, uint32_t counter);
+
+/**
+ * Send the filled sample blocks in batches, called by the main loop
+ */
+void telemetry_process(telemetry_t *telemetry);
+
+#endif /* INC_TELEMETRY_H_ */
@@ -0,0 +1,106 @@
+/*
+ * tickless.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_TICKLESS_H_
+#define INC_TICKLESS_H_
+
+#include <stdint.h>
+#include "system_clock.h"
+#include "timer_wheel.h"
+#include "kernel.h"
+
+/**
+ * Define tickless return values
+ */
+#define TICKLESS_OK (0)
+#define TICKLESS_ERR (-1)
+
+/**
+ * Define the shortest stop, in ms: a closer deadline sleeps with the tick running
+ */
+#define TICKLESS_MIN_STOP (10)
+
+/**
+ * Define the wakeup time from the stop mode that the cycle counter cannot see, in us: datasheet maximum of
+ * tWUSTOP with the low power regulator and the flash not in deep power down, restart of the regulator and of the HSI
+ */
+#define TICKLESS_STOP_WAKEUP_US (33)
+
+/**
+ * Define the cycles of the exception entry, from the interrupts enabled to the first instruction of the handler
+ */
+#define TICKLESS_EXCEPTION_ENTRY_CYCLES (12)
+
+/**
+ * Define the callback type of the compensation of the caller, it is called with the ms spent in stop mode
+ */
+typedef void (*tickless_callback_t)(uint32_t elapsed);
+
+/**
+ * Define tickless structure: the stop mode between two deadlines, timed and compensated by the internal rtc
+ */
+struct tickless_s{
+
+	system_clock_t *clock;
+
+	timer_wheel_t *wheel;
+
+	kernel_t *kernel;
+
+	uint32_t wake_lines; // EXTI lines unmasked only during the stop, their interrupt wakes the core
+
+	tickless_callback_t compensate; // called after the HAL tick, the wheel and the kernel are compensated
+
+	uint32_t carry; // fraction of ms, in ms / (prediv_s + 1), not compensated yet
+
+	uint32_t stops; // stops since the boot
+
+	uint32_t stopped; // ms spent in stop mode since the boot
+
+	uint32_t wake; // cycle counter when the core has left the stop mode
+
+	uint8_t waking; // 1 from the end of a stop to the entry of the handler of its wakeup source
+
+	uint32_t wake_cycles; // core cycles from the end of the stop to the entry of the handler of the wakeup source, last stop
+
+	uint32_t wake_cycles_max;
+
+};
+
+typedef struct tickless_s tickless_t;
+
+/**
+ * Initialize the tickless idle
+ */
+void init_tickless(tickless_t *tickless, system_clock_t *clock, timer_wheel_t *wheel, kernel_t *kernel, uint32_t wake_lines, tickless_callback_t compensate);
+
+/**
+ * Return the ms to the first deadline of the timer wheel and of the kernel
+ */
+uint32_t tickless_deadline(tickless_t *tickless);
+
+/**
+ * Stop the core up to deadline ms, then compensate the ticks lost; it must be called with the interrupts masked
+ */
+int8_t tickless_stop(tickless_t *tickless, uint32_t deadline);
+
+/**
+ * End the measure of the wake latency, it must be called right before the interrupts are enabled after a stop
+ */
+void tickless_wake_end(tickless_t *tickless);
+
+/**
+ * Get the wake latency of the last stop, from the wakeup event to the entry of its handler, in us
+ */
+uint32_t tickless_wake_us(tickless_t *tickless);
+
+/**
+ * Get the highest wake latency since the boot, in us
+ */
+uint32_t tickless_wake_max_us(tickless_t *tickless);
+
+#endif /* INC_TICKLESS_H_ */
@@ -0,0 +1,90 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include <stdint.h>
+#include "ds1307rtc.h"
+#include "epoch.h"
+
+/**
+ * Define timebase return values
+ */
+#define TIMEBASE_OK (0)
+#define TIMEBASE_ERR (-1)
+
+/**
+ * Define the time without square wave edges after which the anchor is extrapolated from the tick, in ms
+ */
+#define TIMEBASE_SQW_TIMEOUT (1500)
+
+/**
+ * Define timebase structure: the rtc date time anchored to the HAL tick of its reading, then moved
+ * to the tick of each rtc square wave edge
+ */
+struct timebase_s{
+
+	uint8_t valid; // 1 after the first rtc reading
+
+	epoch_t anchor_seconds; // second of the anchor
+
+	uint32_t anchor_tick; // HAL tick corresponding to the start of anchor_seconds
+
+	date_time_t date_time; // date time of anchor_seconds
+
+	uint8_t square_wave; // 1 if anchor_tick is a square wave edge
+
+	uint32_t edges; // square wave edges counted
+
+	epoch_t reference_seconds; // first anchor, it is the start of the drift measurement
+
+	uint32_t reference_tick;
+
+	int32_t drift; // tick elapsed minus rtc elapsed since the reference, in ms
+
+	uint32_t drift_interval; // rtc seconds elapsed since the reference
+
+	int32_t last_correction; // anchor correction applied by the last resync, in seconds
+
+	uint32_t resyncs; // number of resyncs that corrected the anchor
+
+};
+
+typedef struct timebase_s timebase_t;
+
+/**
+ * Initialize the timebase, it stays invalid until the first sync
+ */
+void timebase_init(timebase_t *timebase);
+
+/**
+ * Anchor the timebase to the date time read from the rtc at the given tick, return the correction in seconds
+ */
+int32_t timebase_sync(timebase_t *timebase, date_time_t *date_time, uint32_t tick);
+
+/**
+ * Advance the timebase by one second at the given tick, it is called on each square wave edge
+ */
+void timebase_second(timebase_t *timebase, uint32_t tick);
+
+/**
+ * Return 1 if the square wave keeps the timebase in phase with the rtc
+ */
+uint8_t timebase_locked(timebase_t *timebase, uint32_t tick);
+
+/**
+ * Convert the given tick into date time and milliseconds
+ */
+int8_t timebase_get(timebase_t *timebase, uint32_t tick, date_time_t *date_time, uint16_t *milliseconds);
+
+/**
+ * Convert the given tick into epoch seconds and milliseconds
+ */
+int8_t timebase_get_epoch(timebase_t *timebase, uint32_t tick, epoch_t *seconds, uint16_t *milliseconds);
+
+#endif /* INC_TIMEBASE_H_ */
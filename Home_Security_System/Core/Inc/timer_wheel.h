@@ -0,0 +1,105 @@
+/*
+ * timer_wheel.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#ifndef INC_TIMER_WHEEL_H_
+#define INC_TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+/**
+ * Define the number of slots of the wheel, a power of two: a timer shorter than a turn expires at its first visit
+ */
+#define TIMER_WHEEL_SLOTS (256)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+/**
+ * Define the next expiry of a wheel without running timers
+ */
+#define TIMER_WHEEL_IDLE (0xFFFFFFFF)
+
+/**
+ * Define the callback type of the virtual timers, it is called by the tick interrupt
+ */
+typedef void (*virtual_timer_callback_t)(void);
+
+/**
+ * Define virtual timer structure, it is queued into the slot of its expiry
+ */
+struct virtual_timer_s{
+
+	struct virtual_timer_s *next; // next timer of the same slot
+
+	struct virtual_timer_s **link; // pointer that points to this timer, NULL if the timer is not running
+
+	uint32_t rounds; // wheel turns left before the expiry
+
+	uint32_t period; // ticks between two expiries, 0 for a one shot timer
+
+	virtual_timer_callback_t callback;
+
+};
+
+typedef struct virtual_timer_s virtual_timer_t;
+
+/**
+ * Define timer wheel structure: the hashed wheel of the virtual timers, advanced by one hardware tick
+ */
+struct timer_wheel_s{
+
+	virtual_timer_t *slots[TIMER_WHEEL_SLOTS];
+
+	virtual_timer_t *expired; // timers expired by the current tick, waiting for their callback
+
+	uint32_t now; // ticks since the initialization
+
+	uint32_t expiries; // callbacks called since the initialization
+
+};
+
+typedef struct timer_wheel_s timer_wheel_t;
+
+/**
+ * Initialize the timer wheel, no timer is running
+ */
+void init_timer_wheel(timer_wheel_t *wheel);
+
+/**
+ * Initialize a virtual timer with its callback, the timer is not running
+ */
+void init_virtual_timer(virtual_timer_t *timer, virtual_timer_callback_t callback);
+
+/**
+ * Start, or restart, a timer: it expires after delay ticks, then each period ticks if period is not 0
+ */
+void timer_wheel_start(timer_wheel_t *wheel, virtual_timer_t *timer, uint32_t delay, uint32_t period);
+
+/**
+ * Stop a timer, its callback is not called
+ */
+void timer_wheel_stop(virtual_timer_t *timer);
+
+/**
+ * Return 1 if the timer is running
+ */
+uint8_t timer_wheel_is_running(virtual_timer_t *timer);
+
+/**
+ * Advance the wheel by one tick and call the callbacks of the expired timers, it is called by the tick interrupt
+ */
+void timer_wheel_tick(timer_wheel_t *wheel);
+
+/**
+ * Return the ticks from now to the first expiry, TIMER_WHEEL_IDLE if no timer is running
+ */
+uint32_t timer_wheel_next_expiry(timer_wheel_t *wheel);
+
+/**
+ * Advance the wheel by some ticks at once, fewer than the ones to the first expiry: no callback is called
+ */
+void timer_wheel_skip(timer_wheel_t *wheel, uint32_t ticks);
+
+#endif /* INC_TIMER_WHEEL_H_ */
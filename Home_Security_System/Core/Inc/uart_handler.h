@@ -16,6 +16,83 @@
 #define UART_OK (0)
 #define UART_ERR (1)
 
+/**
+ * Define the size of the circular reception buffer
+ */
+#define UART_RX_BUFFER_SIZE (64)
+
+/**
+ * Define the supported baud rates, UART_DEFAULT_BAUD_RATE is the fallback one of the boot handshake
+ */
+#define UART_BAUD_RATES (8)
+#define UART_DEFAULT_BAUD_RATE (9600)
+
+extern const uint32_t uart_baud_rates[UART_BAUD_RATES];
+
+/**
+ * Define the callback type that receives the incoming bytes
+ */
+typedef void (*uart_rx_callback_t)(uint8_t *data, uint16_t size);
+
+/**
+ * Define the maximum number of pending messages of each channel, it must be a power of two
+ */
+#define UART_TX_MESSAGES (16)
+
+/**
+ * Define the transmission channels, from the highest priority to the lowest one
+ */
+typedef enum{
+	UART_CHANNEL_ALARM,
+	UART_CHANNEL_FEEDBACK,
+	UART_CHANNEL_STATUS,
+	UART_CHANNEL_DIAGNOSTIC,
+	UART_CHANNEL_TELEMETRY,
+	UART_CHANNELS
+} uart_channel_t;
+
+/**
+ * Define what a full channel does with a new message
+ */
+typedef enum{
+	UART_POLICY_DROP, // the new message is rejected
+	UART_POLICY_OVERWRITE // the oldest pending messages are discarded to make room for the new one
+} uart_policy_t;
+
+/**
+ * Define the transmission queue structure of a channel.
+ * head and tail are free running indexes, they are masked when the buffer is accessed.
+ */
+struct uart_tx_queue_s{
+
+	uint8_t *buffer;
+
+	uint16_t size; // buffer size, power of two
+
+	uint16_t max_transfer; // maximum bytes sent by a single DMA transfer
+
+	uart_policy_t policy;
+
+	volatile uint16_t head; // first free byte
+
+	volatile uint16_t tail; // first byte not yet transmitted
+
+	volatile uint16_t sent; // bytes of the oldest pending message already transmitted
+
+	uint16_t lengths[UART_TX_MESSAGES]; // length of each pending message
+
+	volatile uint8_t message_head;
+
+	volatile uint8_t message_tail;
+
+	volatile uint32_t dropped; // messages lost because the channel was full
+
+	volatile uint32_t errors; // DMA transfers ended by a transmission error
+
+};
+
+typedef struct uart_tx_queue_s uart_tx_queue_t;
+
 /**
  * Define UART_Handler structure
  */
@@ -23,6 +100,24 @@ struct uart_handler_s{
 
 	UART_HandleTypeDef *huart;
 
+	uart_tx_queue_t tx_queue[UART_CHANNELS];
+
+	volatile int8_t active_channel; // channel under DMA transfer, -1 if the uart is idle
+
+	volatile uint16_t in_flight; // bytes under DMA transfer
+
+	uint8_t rx_buffer[UART_RX_BUFFER_SIZE]; // circular DMA reception buffer
+
+	volatile uint16_t rx_position; // first byte of rx_buffer not yet delivered
+
+	uart_rx_callback_t rx_callback; // receiver of the incoming bytes, NULL if the reception is stopped
+
+	volatile uint32_t pending_baud_rate; // baud rate applied once the transmission is idle, 0 if none
+
+	volatile uint8_t reconfiguring; // 1 while the baud rate changes, the transmission is held
+
+	volatile uint32_t rx_tick; // HAL tick of the last activity of the reception line
+
 };
 
 typedef struct uart_handler_s uart_handler_t;
@@ -44,9 +139,69 @@ int8_t uart_handler_send_message_IT(uart_handler_t *uart_handler, uint8_t *buffe
 int8_t uart_handler_send_message_DMA(uart_handler_t *uart_handler, uint8_t *buffer, int16_t buffer_size);
 
 /**
- * Send buffer_size data if buffer through UART, in blocking mode
+ * Copy buffer_size data of buffer into the transmission queue of the given channel, the queues are sent in DMA mode
+ */
+int8_t uart_handler_enqueue_message(uart_handler_t *uart_handler, uart_channel_t channel, uint8_t *buffer, int16_t buffer_size);
+
+/**
+ * Release the transmitted data and start the transmission of the highest priority queued ones
+ */
+void uart_handler_tx_callback(uart_handler_t *uart_handler);
+
+/**
+ * Count a failed transmission and restart the queue, the alarm bytes are sent again
+ */
+void uart_handler_tx_error(uart_handler_t *uart_handler);
+
+/**
+ * Start the continuous reception in circular DMA mode, the incoming bytes are delivered to rx_callback
+ */
+int8_t uart_handler_start_reception(uart_handler_t *uart_handler, uart_rx_callback_t rx_callback);
+
+/**
+ * Stop the continuous reception
+ */
+void uart_handler_stop_reception(uart_handler_t *uart_handler);
+
+/**
+ * Deliver the bytes written by the DMA since the last call
+ */
+void uart_handler_rx_event(uart_handler_t *uart_handler);
+
+/**
+ * Handle the idle line interrupt, it must be called by the USART IRQ handler
+ */
+void uart_handler_idle_IRQHandler(UART_HandleTypeDef *huart);
+
+/**
+ * Return the index of the given baud rate into uart_baud_rates, -1 if it is not supported
+ */
+int8_t uart_handler_baud_rate_index(uint32_t baud_rate);
+
+/**
+ * Reconfigure the UART with the given baud rate, immediately
+ */
+int8_t uart_handler_set_baud_rate(uart_handler_t *uart_handler, uint32_t baud_rate);
+
+/**
+ * Request a baud rate change, applied by uart_handler_process() once the queued messages have been sent
+ */
+int8_t uart_handler_request_baud_rate(uart_handler_t *uart_handler, uint32_t baud_rate);
+
+/**
+ * Apply the pending baud rate change if the transmission is idle
+ */
+void uart_handler_process(uart_handler_t *uart_handler);
+
+/**
+ * Return 1 if no message is queued or under transmission
+ */
+uint8_t uart_handler_tx_idle(uart_handler_t *uart_handler);
+
+/**
+ * Record an activity of the reception line, it is called by the interrupt of the line that wakes the stop mode
  */
-int8_t uart_handler_send_message(uart_handler_t *uart_handler, uint8_t *buffer, int16_t buffer_size);
+void uart_handler_rx_wakeup(uart_handler_t *uart_handler);
 
 /**
  * Receive buffer_size data, inserted into buffer, through UART, in interrupt mode
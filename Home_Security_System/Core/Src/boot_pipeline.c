@@ -0,0 +1,131 @@
+/*
+ * boot_pipeline.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include "boot_pipeline.h"
+#include "log_format.h"
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief  Initialize the pipeline
+ * @param  pipeline		pointer to boot pipeline structure
+ * @param  stages		table of stages, each one with the BOOT_STAGE() of its dependencies
+ * @param  count		number of stages, at most BOOT_PIPELINE_MAX_STAGES
+ */
+void init_boot_pipeline(boot_pipeline_t *pipeline, const boot_stage_t *stages, uint8_t count){
+
+	pipeline->stages = stages;
+	pipeline->count = count;
+	pipeline->started = 0;
+	pipeline->done = 0;
+	pipeline->state = BOOT_RUNNING;
+
+}
+
+/**
+ * @brief  Record the result of a stage step
+ * @param  pipeline		pointer to boot pipeline structure
+ * @param  index		index of the stage
+ * @param  result		result of its step
+ * @return 1 if the stage has been completed
+ */
+static uint8_t stage_result(boot_pipeline_t *pipeline, uint8_t index, int8_t result){
+
+	if(result == BOOT_STAGE_ERR){
+		pipeline->state = BOOT_FAILED;
+	}else if(result == BOOT_STAGE_DONE || pipeline->stages[index].poll == NULL){
+		pipeline->end_time[index] = HAL_GetTick();
+		pipeline->done |= BOOT_STAGE(index);
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief  Start the stages whose dependencies are done and poll the pending ones
+ * @param  pipeline		pointer to boot pipeline structure
+ * @return pipeline status
+ * @note   It is called by the main loop until the pipeline is finished. The passes are repeated while a stage
+ * 		   completes, so a chain of stages that do not wait is run by a single call. A stage that waits for a
+ * 		   time or a flag returns BOOT_STAGE_PENDING, then the main loop sleeps until the next interrupt, the
+ * 		   HAL tick included, and polls it again. A failed stage stops the pipeline.
+ */
+boot_pipeline_state_t boot_pipeline_process(boot_pipeline_t *pipeline){
+
+	const boot_stage_t *stage;
+	uint8_t progress = 1;
+	uint8_t i;
+
+	while(progress && pipeline->state == BOOT_RUNNING){
+
+		progress = 0;
+
+		for(i = 0; i < pipeline->count && pipeline->state == BOOT_RUNNING; i++){
+
+			stage = &pipeline->stages[i];
+
+			if(pipeline->done & BOOT_STAGE(i)){
+				continue;
+			}else if(pipeline->started & BOOT_STAGE(i)){
+				progress |= stage_result(pipeline, i, stage->poll());
+			}else if((pipeline->done & stage->depends) == stage->depends){
+				pipeline->started |= BOOT_STAGE(i);
+				pipeline->start_time[i] = HAL_GetTick();
+				progress |= stage_result(pipeline, i, stage->start());
+			}
+
+		}
+
+		if(pipeline->done == BOOT_STAGE(pipeline->count) - 1){
+			pipeline->state = BOOT_FINISHED;
+		}
+
+	}
+
+	return pipeline->state;
+}
+
+/**
+ * @brief  Format the timing of the stages
+ * @param  pipeline		pointer to boot pipeline structure
+ * @param  buffer		destination buffer
+ * @param  size			buffer size
+ * @return characters written
+ * @note   One line for each stage: its start, in ms from the reset, and its length. The stages that overlap
+ * 		   have overlapping ranges, so the boot time is the last end, not the sum of the lengths.
+ */
+uint16_t boot_pipeline_format(boot_pipeline_t *pipeline, char *buffer, uint16_t size){
+
+	log_format_t format;
+	uint32_t last = 0;
+	uint8_t i;
+
+	log_format_init(&format, buffer, size);
+
+	for(i = 0; i < pipeline->count; i++){
+		log_format_string(&format, "\n\rBOOT ");
+		log_format_string(&format, pipeline->stages[i].name);
+		if(pipeline->done & BOOT_STAGE(i)){
+			log_format_string(&format, " AT ");
+			log_format_uint(&format, pipeline->start_time[i], 0);
+			log_format_string(&format, " FOR ");
+			log_format_uint(&format, pipeline->end_time[i] - pipeline->start_time[i], 0);
+			log_format_string(&format, " MS");
+			if(pipeline->end_time[i] > last){
+				last = pipeline->end_time[i];
+			}
+		}else{
+			log_format_string(&format, (pipeline->started & BOOT_STAGE(i)) ? " FAILED" : " NOT STARTED");
+		}
+	}
+
+	log_format_string(&format, "\n\rBOOT TOTAL ");
+	log_format_uint(&format, last, 0);
+	log_format_string(&format, " MS\n\r");
+
+	return log_format_end(&format);
+}
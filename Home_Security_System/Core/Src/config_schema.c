@@ -0,0 +1,187 @@
+/*
+ * config_schema.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include <string.h>
+#include "config_schema.h"
+
+/**
+ * @brief Schema of the system configuration: adding a parameter is adding a row
+ */
+const config_field_t config_schema[] = {
+	{"PIN", INSERT_PIN, CONFIG_FIELD_DIGITS, PIN_SIZE, 0, 0, "0000", offsetof(system_configuration_t, pin), PIN_SIZE},
+	{"D1", INSERT_DELAY_SENSOR_1, CONFIG_FIELD_UINT8, DELAY_SIZE, 0, 30, "00", offsetof(system_configuration_t, sensor_delay_1), 1},
+	{"D2", INSERT_DELAY_SENSOR_2, CONFIG_FIELD_UINT8, DELAY_SIZE, 0, 30, "00", offsetof(system_configuration_t, sensor_delay_2), 1},
+	{"DUR", INSERT_ALLARM_DURATION, CONFIG_FIELD_UINT8, DURATION_SIZE, 5, 60, "05", offsetof(system_configuration_t, duration), 1}
+};
+
+/**
+ * @brief Number of fields of the schema
+ */
+const uint8_t config_fields = sizeof(config_schema) / sizeof(config_schema[0]);
+
+/**
+ * @brief  Find a field by name
+ * @param  name		name characters, not terminated
+ * @param  length	number of name characters
+ * @return pointer to the field, NULL if there is none
+ */
+const config_field_t *config_schema_find(const char *name, uint8_t length){
+
+	uint8_t i;
+
+	for(i = 0; i < config_fields; i++){
+		if(strlen(config_schema[i].name) == length && memcmp(config_schema[i].name, name, length) == 0){
+			return &config_schema[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief  Convert the characters of a field
+ * @param  field	pointer to the field
+ * @param  text		width characters
+ * @param  value	pointer where store the number, for a CONFIG_FIELD_UINT8
+ * @return operation result, CONFIG_SCHEMA_ERR if a character is not a digit or the number is out of range
+ */
+static int8_t convert_field(const config_field_t *field, const uint8_t *text, uint8_t *value){
+
+	uint16_t number = 0;
+	uint8_t i;
+
+	for(i = 0; i < field->width; i++){
+		if(text[i] < '0' || text[i] > '9'){
+			return CONFIG_SCHEMA_ERR;
+		}
+		number = number * 10 + (text[i] - '0');
+	}
+
+	if(field->type == CONFIG_FIELD_UINT8){
+		if(number < field->min || number > field->max){
+			return CONFIG_SCHEMA_ERR;
+		}
+		*value = number;
+	}
+
+	return CONFIG_SCHEMA_OK;
+}
+
+/**
+ * @brief  Check the characters of a field
+ * @param  field	pointer to the field
+ * @param  text		width characters
+ * @return operation result
+ */
+int8_t config_schema_check(const config_field_t *field, const uint8_t *text){
+
+	uint8_t value;
+
+	return convert_field(field, text, &value);
+}
+
+/**
+ * @brief  Check and convert the characters of a field into the configuration
+ * @param  configuration	configuration to update, it is left untouched if the characters are not valid
+ * @param  field			pointer to the field
+ * @param  text				width characters
+ * @return operation result
+ */
+int8_t config_schema_set(system_configuration_t *configuration, const config_field_t *field, const uint8_t *text){
+
+	uint8_t *destination = (uint8_t *)configuration + field->offset;
+	uint8_t value;
+
+	if(convert_field(field, text, &value) != CONFIG_SCHEMA_OK){
+		return CONFIG_SCHEMA_ERR;
+	}
+
+	if(field->type == CONFIG_FIELD_DIGITS){
+		memcpy(destination, text, field->size);
+	}else{
+		*destination = value;
+	}
+
+	return CONFIG_SCHEMA_OK;
+}
+
+/**
+ * @brief  Load the default value of all the fields
+ * @param  configuration	configuration to fill
+ */
+void config_schema_load_defaults(system_configuration_t *configuration){
+
+	uint8_t i;
+
+	for(i = 0; i < config_fields; i++){
+		config_schema_set(configuration, &config_schema[i], (const uint8_t *)config_schema[i].default_text);
+	}
+
+}
+
+/**
+ * @brief  Copy the fields into a buffer
+ * @param  configuration	configuration to copy
+ * @param  buffer			destination buffer
+ * @param  size				buffer size
+ * @return bytes written, 0 if the fields do not fit
+ * @note   The fields are copied as they are in the configuration, in the order of the schema: a row added
+ * 		   at the end of the schema extends the packed fields without moving the others.
+ */
+uint8_t config_schema_pack(const system_configuration_t *configuration, uint8_t *buffer, uint8_t size){
+
+	uint8_t i, length = 0;
+
+	for(i = 0; i < config_fields; i++){
+		if(length + config_schema[i].size > size){
+			return 0;
+		}
+		memcpy(buffer + length, (const uint8_t *)configuration + config_schema[i].offset, config_schema[i].size);
+		length += config_schema[i].size;
+	}
+
+	return length;
+}
+
+/**
+ * @brief  Copy the fields from a buffer
+ * @param  configuration	configuration to fill
+ * @param  buffer			buffer written by config_schema_pack()
+ * @param  size				bytes of the buffer
+ * @note   A field beyond size, written by an older schema, or out of the range of the current schema takes its
+ * 		   default value.
+ */
+void config_schema_unpack(system_configuration_t *configuration, const uint8_t *buffer, uint8_t size){
+
+	const config_field_t *field;
+	uint8_t *destination;
+	uint8_t i, length = 0;
+	uint8_t valid;
+
+	for(i = 0; i < config_fields; i++){
+
+		field = &config_schema[i];
+		destination = (uint8_t *)configuration + field->offset;
+
+		if(length + field->size > size){
+			valid = 0;
+		}else if(field->type == CONFIG_FIELD_DIGITS){
+			valid = (config_schema_check(field, buffer + length) == CONFIG_SCHEMA_OK);
+		}else{
+			valid = (buffer[length] >= field->min && buffer[length] <= field->max);
+		}
+
+		if(valid){
+			memcpy(destination, buffer + length, field->size);
+		}else{
+			config_schema_set(configuration, field, (const uint8_t *)field->default_text);
+		}
+
+		length += field->size;
+	}
+
+}
@@ -0,0 +1,317 @@
+/*
+ * config_store.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include "config_store.h"
+#include "log_frame.h"
+#include "config_schema.h"
+
+/**
+ * @brief Start address of the slots
+ */
+static const uint32_t slot_addresses[2] = {CONFIG_STORE_SLOT_A_ADDRESS, CONFIG_STORE_SLOT_B_ADDRESS};
+
+/**
+ * @brief Flash sector of the slots
+ */
+static const uint32_t slot_sectors[2] = {CONFIG_STORE_SLOT_A_SECTOR, CONFIG_STORE_SLOT_B_SECTOR};
+
+/**
+ * @brief  Get a record of a slot
+ * @param  slot		slot index
+ * @param  index	record index into the slot
+ * @return pointer to the record, memory mapped
+ */
+static const config_record_t *record_at(uint8_t slot, uint16_t index){
+
+	return (const config_record_t *)(slot_addresses[slot] + index * sizeof(config_record_t));
+
+}
+
+/**
+ * @brief  Check a record
+ * @param  record	pointer to the record
+ * @return 1 if its header and its CRC are valid, 0 if it is erased, torn or of another version
+ */
+static uint8_t record_is_valid(const config_record_t *record){
+
+	if((record->header & 0xFFFFFF00) != (CONFIG_STORE_HEADER(0) & 0xFFFFFF00) || CONFIG_STORE_HEADER_SIZE(record->header) > CONFIG_STORE_PAYLOAD_SIZE){
+		return 0;
+	}
+
+	return record->crc == log_frame_crc16((const uint8_t *)record, offsetof(config_record_t, crc));
+}
+
+/**
+ * @brief  Get the baud rate of a record
+ * @param  record	pointer to a valid record
+ * @return index into uart_baud_rates, CONFIG_STORE_NO_BAUD if the record has none
+ */
+static uint8_t record_baud_index(const config_record_t *record){
+
+	if(CONFIG_STORE_HEADER_SIZE(record->header) <= CONFIG_STORE_BAUD_OFFSET){
+		return CONFIG_STORE_NO_BAUD;
+	}
+
+	return record->payload[CONFIG_STORE_BAUD_OFFSET];
+}
+
+/**
+ * @brief  Erase a slot
+ * @param  slot		slot index
+ * @return HAL status
+ * @note   The flash must be unlocked. The fetches from flash, the interrupt handlers included, stall until the
+ * 		   end of the erase, 1 to 2 s for a 128 KB sector.
+ */
+static HAL_StatusTypeDef erase_slot(uint8_t slot){
+
+	FLASH_EraseInitTypeDef erase;
+	uint32_t sector_error;
+
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = slot_sectors[slot];
+	erase.NbSectors = 1;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+	return HAL_FLASHEx_Erase(&erase, &sector_error);
+}
+
+/**
+ * @brief  Append a record to the log
+ * @param  store	pointer to the config store structure
+ * @param  payload	payload bytes
+ * @param  size		payload size, 0 for a cleared configuration
+ * @return operation result
+ * @note   The record goes after the newest one. When the active slot is full, or there is no valid record,
+ * 		   the other slot is erased and the record becomes its first one: the previous slot is left intact,
+ * 		   so a power loss at any point leaves one of the two records valid. The slot switches only once
+ * 		   its first record is verified.
+ */
+static int8_t append_record(config_store_t *store, const uint8_t *payload, uint8_t size){
+
+	config_record_t record;
+	const uint32_t *words = (const uint32_t *)&record;
+	uint8_t slot = store->active;
+	uint16_t index = store->next;
+	HAL_StatusTypeDef result = HAL_OK;
+	uint32_t address;
+	uint8_t i;
+
+	record.header = CONFIG_STORE_HEADER(size);
+	record.sequence = store->sequence + 1;
+	memset(record.payload, 0, CONFIG_STORE_PAYLOAD_SIZE);
+	if(size > 0){
+		memcpy(record.payload, payload, size);
+	}
+	record.crc = log_frame_crc16((const uint8_t *)&record, offsetof(config_record_t, crc));
+
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+	if(!store->valid || index >= CONFIG_STORE_RECORDS){
+		slot = store->valid ? !store->active : 0;
+		index = 0;
+		result = erase_slot(slot);
+	}
+
+	address = (uint32_t)record_at(slot, index);
+
+	for(i = 0; i < sizeof(config_record_t) / sizeof(uint32_t) && result == HAL_OK; i++){ // header first, crc last
+		result = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + i * sizeof(uint32_t), words[i]);
+	}
+
+	HAL_FLASH_Lock();
+
+	if(result != HAL_OK || !record_is_valid(record_at(slot, index))){
+		if(index > 0){
+			store->next = index + 1; // the record is no longer erased, it is skipped
+		}
+		return CONFIG_STORE_ERR;
+	}
+
+	store->active = slot;
+	store->valid = 1;
+	store->newest = index;
+	store->next = index + 1;
+	store->sequence = record.sequence;
+	store->baud_index = record_baud_index(&record);
+
+	return CONFIG_STORE_OK;
+}
+
+/**
+ * @brief  Initialize the config store
+ * @param  store	pointer to the config store structure
+ * @note   The active slot is the one whose first record is valid with the higher sequence. Its records are
+ * 		   written in order from the first, so the first erased one is found by a binary search of the
+ * 		   headers and the newest is the one before, or the last valid before it after a torn write.
+ */
+void init_config_store(config_store_t *store){
+
+	uint8_t valid_a = record_is_valid(record_at(0, 0));
+	uint8_t valid_b = record_is_valid(record_at(1, 0));
+	uint16_t low = 1, high = CONFIG_STORE_RECORDS, middle;
+
+	store->loaded = 0;
+	store->threshold_up = 0;
+	store->threshold_down = 0;
+	store->baud_index = CONFIG_STORE_NO_BAUD;
+
+	if(!valid_a && !valid_b){
+		store->active = 0;
+		store->valid = 0;
+		store->newest = 0;
+		store->next = 0;
+		store->sequence = 0;
+		return;
+	}
+
+	store->active = (valid_a && (!valid_b || record_at(0, 0)->sequence > record_at(1, 0)->sequence)) ? 0 : 1;
+	store->valid = 1;
+
+	while(low < high){
+		middle = (low + high) / 2;
+		if(record_at(store->active, middle)->header != CONFIG_STORE_ERASED){
+			low = middle + 1;
+		}else{
+			high = middle;
+		}
+	}
+
+	store->next = low;
+
+	store->newest = low - 1;
+	while(store->newest > 0 && !record_is_valid(record_at(store->active, store->newest))){
+		store->newest--;
+	}
+
+	store->sequence = record_at(store->active, store->newest)->sequence;
+	store->baud_index = record_baud_index(record_at(store->active, store->newest));
+
+}
+
+/**
+ * @brief  Load the stored configuration
+ * @param  store			pointer to the config store structure
+ * @param  configuration	configuration to fill, it is left untouched if there is no configuration
+ * @return operation result
+ * @note   Only the newest record is read. The fields it does not hold, added to the schema after it has been
+ * 		   written, take their default.
+ */
+int8_t config_store_load(config_store_t *store, system_configuration_t *configuration){
+
+	const config_record_t *record;
+
+	store->loaded = 0;
+
+	if(!store->valid){
+		return CONFIG_STORE_ERR;
+	}
+
+	record = record_at(store->active, store->newest);
+
+	if(CONFIG_STORE_HEADER_SIZE(record->header) < CONFIG_STORE_SCHEMA_OFFSET){ // cleared
+		return CONFIG_STORE_ERR;
+	}
+
+	config_schema_unpack(configuration, &record->payload[CONFIG_STORE_SCHEMA_OFFSET], CONFIG_STORE_HEADER_SIZE(record->header) - CONFIG_STORE_SCHEMA_OFFSET);
+
+	store->threshold_up = record->payload[CONFIG_STORE_THRESHOLD_UP_OFFSET] | (record->payload[CONFIG_STORE_THRESHOLD_UP_OFFSET + 1] << 8);
+	store->threshold_down = record->payload[CONFIG_STORE_THRESHOLD_DOWN_OFFSET] | (record->payload[CONFIG_STORE_THRESHOLD_DOWN_OFFSET + 1] << 8);
+
+	store->loaded = 1;
+
+	return CONFIG_STORE_OK;
+}
+
+/**
+ * @brief  Save the configuration
+ * @param  store			pointer to the config store structure
+ * @param  configuration	configuration to save
+ * @param  threshold_up		barrier value without laser
+ * @param  threshold_down	barrier value with laser
+ * @return operation result
+ * @note   It must be called from the main loop: programming a record takes a few hundred microseconds,
+ * 		   the erase of a full slot 1 to 2 s, see config_store_needs_erase(). The saved baud rate is kept.
+ */
+int8_t config_store_save(config_store_t *store, const system_configuration_t *configuration, uint16_t threshold_up, uint16_t threshold_down){
+
+	uint8_t payload[CONFIG_STORE_PAYLOAD_SIZE];
+	uint8_t size;
+
+	size = config_schema_pack(configuration, &payload[CONFIG_STORE_SCHEMA_OFFSET], CONFIG_STORE_PAYLOAD_SIZE - CONFIG_STORE_SCHEMA_OFFSET);
+
+	if(size == 0){
+		return CONFIG_STORE_ERR; // the schema has outgrown the record
+	}
+
+	payload[CONFIG_STORE_BAUD_OFFSET] = store->baud_index;
+	payload[CONFIG_STORE_THRESHOLD_UP_OFFSET] = threshold_up;
+	payload[CONFIG_STORE_THRESHOLD_UP_OFFSET + 1] = threshold_up >> 8;
+	payload[CONFIG_STORE_THRESHOLD_DOWN_OFFSET] = threshold_down;
+	payload[CONFIG_STORE_THRESHOLD_DOWN_OFFSET + 1] = threshold_down >> 8;
+
+	return append_record(store, payload, CONFIG_STORE_SCHEMA_OFFSET + size);
+}
+
+/**
+ * @brief  Erase the stored configuration
+ * @param  store	pointer to the config store structure
+ * @return operation result
+ * @note   A record holding only the baud rate is appended, the previous ones are left in the log.
+ */
+int8_t config_store_erase(config_store_t *store){
+
+	uint8_t payload[CONFIG_STORE_PAYLOAD_SIZE];
+
+	payload[CONFIG_STORE_BAUD_OFFSET] = store->baud_index;
+
+	if(append_record(store, payload, CONFIG_STORE_BAUD_OFFSET + 1) != CONFIG_STORE_OK){
+		return CONFIG_STORE_ERR;
+	}
+
+	store->loaded = 0;
+
+	return CONFIG_STORE_OK;
+}
+
+/**
+ * @brief  Save the console baud rate
+ * @param  store		pointer to the config store structure
+ * @param  baud_index	index into uart_baud_rates
+ * @return operation result
+ * @note   The newest record is appended again with the new baud rate, so the configuration, or its absence,
+ * 		   is kept. The payload is copied first: the erase of a slot switch can wipe the newest record.
+ */
+int8_t config_store_save_baud_rate(config_store_t *store, uint8_t baud_index){
+
+	const config_record_t *newest = record_at(store->active, store->newest);
+	uint8_t payload[CONFIG_STORE_PAYLOAD_SIZE];
+	uint8_t size = CONFIG_STORE_BAUD_OFFSET + 1;
+
+	if(store->valid && CONFIG_STORE_HEADER_SIZE(newest->header) > size){
+		size = CONFIG_STORE_HEADER_SIZE(newest->header);
+		memcpy(payload, newest->payload, size);
+	}
+
+	payload[CONFIG_STORE_BAUD_OFFSET] = baud_index;
+
+	return append_record(store, payload, size);
+}
+
+/**
+ * @brief  Check if the next record erases a slot
+ * @param  store	pointer to the config store structure
+ * @return 1 if the active slot is full or there is no valid record, 0 otherwise
+ * @note   The erase stalls the flash fetches for 1 to 2 s, so the caller can postpone such a save while a
+ * 		   stall is not acceptable, e.g. while the system is armed.
+ */
+uint8_t config_store_needs_erase(config_store_t *store){
+
+	return !store->valid || store->next >= CONFIG_STORE_RECORDS;
+}
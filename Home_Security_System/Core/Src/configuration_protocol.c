@@ -6,16 +6,22 @@
 #include "ds1307rtc.h"
 #include "system_log.h"
 #include "system.h"
-#include "stdio.h"
+#include "log_format.h"
+#include "config_schema.h"
 /**
- * @brief Define timer's period for configuration task.
+ * @brief Define the timeout of the configuration task, in ms
  */
-#define CONFIGURATION_PERIOD (29999)
+#define CONFIGURATION_TIMEOUT (30000)
+
+/**
+ * @brief Size of the buffer for sending the inserted date and time back: separator, two digits, separator, terminator
+ */
+#define ECHO_SIZE (5)
 
 /**
  * @brief buffer for sending the inserted date and time back
  */
-char msg[4];
+char echo[ECHO_SIZE];
 
 /**
  * @brief Function that checks the configuration parameters inserted by the user
@@ -38,41 +44,48 @@ static int8_t load_default_configuration(configuration_protocol_t *protocol);
  */
 
 /**
- * @brief User PIN buffer
+ * @brief Characters inserted for each field of the schema
  */
-uint8_t pin_buffer[PIN_SIZE];
+uint8_t field_buffers[CONFIG_SCHEMA_MAX_FIELDS][CONFIG_FIELD_MAX_WIDTH];
 
 /**
- * @brief Delay of the first sensor
+ * @brief Buffer for date and time
  */
-uint8_t delay1_buffer[DELAY_SIZE];
+uint8_t date_time_buffer[DATE_TIME_BUFFER_SIZE];
 
 /**
- * @brief Delay of the second sensor
+ * @brief Buffer for the bulk mode line
  */
-uint8_t delay2_buffer[DELAY_SIZE];
+uint8_t bulk_line[BULK_LINE_SIZE];
 
 /**
- * @brief Duration of the alarm
+ * @brief Characters inserted in the bulk mode line
  */
-uint8_t duration_buffer[DURATION_SIZE];
+uint8_t bulk_length;
 
 /**
- * @brief Buffer for date and time
+ * @brief Key of the date and time in the bulk mode line, the other keys are the names of the schema fields
  */
-uint8_t date_time_buffer[DATE_TIME_BUFFER_SIZE];
-
+#define BULK_DATE_TIME ("DT")
 
 /**
- * @brief Default USER PIN
+ * @brief  End the protocol with the default configuration
+ * @note   Called by the protocol timer, from the tick interrupt, if the user has not completed the configuration in time.
  */
-user_pin DEFAULT_USER_PIN[PIN_SIZE] = {'0','0','0','0'};
+static void protocol_timeout(){
+
+	if(system.protocol->state != END_CUSTOM && system.protocol->state != END_DEFAULT){ // check if the protocol is running
+		uart_handler_stop_reception(system.uart); // abort the pending receiving operation, the queued messages are still sent
+		system.protocol->state = END_DEFAULT; // set the protocol' state to END_DEFAULT
+	}
+
+}
 
 /**
  * @brief  Initialize protocol structure
  * @param  protocol			pointer to configuration protocol structure
  * @param  configuration	pointer to system configuration structure
- * @param  timer			pointer to timer to use in the configuration procedure
+ * @param  wheel			pointer to the timer wheel of the protocol timeout
  * @param  rtc				pointer to rtc structure
  * @return void
  * @note   It is used to initialize the configuration protocol. It assigns:
@@ -81,7 +94,7 @@ user_pin DEFAULT_USER_PIN[PIN_SIZE] = {'0','0','0','0'};
  * 				-   state
  * 				-   timer
  */
-void init_protocol(configuration_protocol_t *protocol, system_configuration_t *configuration, TIM_HandleTypeDef *timer, rtc_t *rtc){
+void init_protocol(configuration_protocol_t *protocol, system_configuration_t *configuration, timer_wheel_t *wheel, rtc_t *rtc){
 
 	protocol->configuration = configuration;
 
@@ -89,9 +102,9 @@ void init_protocol(configuration_protocol_t *protocol, system_configuration_t *c
 
 	protocol->state = IDLE_P; // set the state to IDLE
 
-	protocol->timer = timer;
+	protocol->wheel = wheel;
 
-	set_timer_period(protocol->timer, CONFIGURATION_PERIOD); // configure the timer's period
+	init_virtual_timer(&protocol->timer, protocol_timeout);
 
 }
 
@@ -104,16 +117,20 @@ protocol_status_type configuration_protocol(configuration_protocol_t *protocol){
 
 	protocol->state = START_P; // set the state to start
 
-	system_log_send_message_IT(system.system_log, (uint8_t *)SYSTEM_BOOT, strlen(SYSTEM_BOOT)); // send the SYSTEM BOOT message over uart
+	system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)SYSTEM_BOOT, strlen(SYSTEM_BOOT)); // queue the SYSTEM BOOT message
+
+	timer_wheel_start(protocol->wheel, &protocol->timer, CONFIGURATION_TIMEOUT, 0); // start the protocol timer
 
-	start_timer_IT(protocol->timer); // start the protocol timer
+	protocol_callback_tx(); // send the first request
 
-	while(protocol->state != END_CUSTOM && protocol->state != END_DEFAULT){} // wait until the protocol is finished
+	while(protocol->state != END_CUSTOM && protocol->state != END_DEFAULT){ // wait until the protocol is finished
+		system_idle(); // the uart and timer interrupts advance the protocol
+	}
 
 	if(protocol->state == END_DEFAULT){
 		// check if the protocol is finished due to the timer period elapsed
 		if(load_default_configuration(protocol) == PROTOCOL_OK){ // load the default configuration
-			system_log_send_message(system.system_log, (uint8_t *)DEFAULT_CONFIGURATION_LOADED, strlen(DEFAULT_CONFIGURATION_LOADED)); // send "SYSTEM CONFIGURATION REJECTED" MESSAGE
+			system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)DEFAULT_CONFIGURATION_LOADED, strlen(DEFAULT_CONFIGURATION_LOADED)); // send "SYSTEM CONFIGURATION REJECTED" MESSAGE
 			return protocol->state;
 		}
 	}else{
@@ -122,7 +139,7 @@ protocol_status_type configuration_protocol(configuration_protocol_t *protocol){
 
 			if(load_custom_configuration(protocol) == PROTOCOL_OK){ // load the configuration inserted by the user
 				// send "System Configuration Loaded" message
-				system_log_send_message(system.system_log, (uint8_t *)CUSTOM_CONFIGURATION_LOADED, strlen(CUSTOM_CONFIGURATION_LOADED));
+				system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)CUSTOM_CONFIGURATION_LOADED, strlen(CUSTOM_CONFIGURATION_LOADED));
 				return protocol->state;
 			}
 
@@ -131,14 +148,14 @@ protocol_status_type configuration_protocol(configuration_protocol_t *protocol){
 				if(load_default_configuration(protocol)==PROTOCOL_OK){
 					// send "System Configuration Rejected" message
 					protocol->state = END_DEFAULT;
-					system_log_send_message(system.system_log, (uint8_t *)DEFAULT_CONFIGURATION_LOADED, strlen(DEFAULT_CONFIGURATION_LOADED));
+					system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)DEFAULT_CONFIGURATION_LOADED, strlen(DEFAULT_CONFIGURATION_LOADED));
 					return protocol->state;
 				}
 			}
 	}
 
 	// send an error message if the loading procedure was not successfully
-	system_log_send_message(system.system_log, (uint8_t *)ERROR_STRING, strlen(ERROR_STRING));
+	system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)ERROR_STRING, strlen(ERROR_STRING));
 	protocol->state = END_ERR;
 	return protocol->state;
 
@@ -155,82 +172,6 @@ static uint8_t convert_buffer_to_uint8(uint8_t *buffer){
 
 }
 
-/**
- * @brief   Check if the inserted pin is valid
- * @param   pin 	pointer to the pin buffer
- * @return  operation result
- */
-static int8_t check_pin(uint8_t *pin){
-
-	uint8_t i = 0;
-
-	for(i=0; i<PIN_SIZE; i++){
-
-		if(pin[i] < '0' || pin[i] > '9'){
-			return PROTOCOL_ERR;
-		}
-
-	}
-
-	return PROTOCOL_OK;
-}
-
-/**
- * @brief   Check if the inserted delay is valid
- * @param   delay 	 pointer to the delay buffer
- * @return  operation result
- */
-static int8_t check_delay(uint8_t *delay){
-
-	uint8_t i = 0;
-
-	for(i=0; i<DELAY_SIZE; i++){
-
-		if((i == 0 && (delay[i] < '0' || delay[i] > '3'))
-			|| (i == 1 && (delay[i] < '0' || (delay[i] > '9')))){
-
-			return PROTOCOL_ERR;
-
-		}else if( (i == 1 && (delay[i] > '0' && delay[0] == '3' ))){
-
-			return PROTOCOL_ERR;
-
-		}
-
-	}
-
-	return PROTOCOL_OK;
-
-}
-
-/**
- * @brief   Check if the inserted duration is valid
- * @param   duration	 pointer to the duration buffer
- * @return  operation result
- */
-static int8_t check_duration(uint8_t *duration){
-
-	uint8_t i = 0;
-
-	for(i=0; i<DURATION_SIZE; i++){
-
-		if((i == 0 && (duration[i] < '0' || duration[i] > '6'))
-			|| (i == 1 && (duration[i] < '0' || (duration[i] > '9')))){
-
-			return PROTOCOL_ERR;
-
-		}else if( (i == 1 && ((duration[i] > '0' && duration[0] == '6' ) ||  (duration[i] < '5' && duration[0] == '0' )))){
-
-			return PROTOCOL_ERR;
-
-		}
-
-	}
-
-	return PROTOCOL_OK;
-
-}
-
 /**
  * @brief   Take the date and time parameters inserted by the user from date_time buffer
  * @param   protocol 	pointer to the protocol structure
@@ -282,14 +223,15 @@ static int8_t check_date_time(configuration_protocol_t *protocol, uint8_t *date_
  */
 static int8_t check_configuration_fields(configuration_protocol_t *protocol){
 
-	// call the procedure for checking the buffers
-	if( check_pin(pin_buffer) != PROTOCOL_OK || check_delay(delay1_buffer) != PROTOCOL_OK
-		|| check_delay(delay2_buffer) != PROTOCOL_OK || check_duration(duration_buffer) != PROTOCOL_OK || check_date_time(protocol, date_time_buffer) != PROTOCOL_OK){
+	uint8_t i;
 
-		return PROTOCOL_ERR;
+	for(i = 0; i < config_fields; i++){ // the same checks of the bulk line and of the console
+		if(config_schema_check(&config_schema[i], field_buffers[i]) != CONFIG_SCHEMA_OK){
+			return PROTOCOL_ERR;
+		}
 	}
 
-	return PROTOCOL_OK;
+	return check_date_time(protocol, date_time_buffer);
 }
 
 /**
@@ -299,13 +241,11 @@ static int8_t check_configuration_fields(configuration_protocol_t *protocol){
  */
 static int8_t load_custom_configuration(configuration_protocol_t *protocol){
 
-	memcpy(protocol->configuration->pin, pin_buffer, PIN_SIZE); // set the pin field to the inserted pin
-
-	protocol->configuration->sensor_delay_1 = convert_buffer_to_uint8(delay1_buffer); // set the sensor delay field to the inserted delay
-
-	protocol->configuration->sensor_delay_2 = convert_buffer_to_uint8(delay2_buffer); // set the sensor delay field to the inserted delay
+	uint8_t i;
 
-	protocol->configuration->duration =  convert_buffer_to_uint8(duration_buffer); // set the duration field to the inserted duration
+	for(i = 0; i < config_fields; i++){ // already checked by check_configuration_fields()
+		config_schema_set(protocol->configuration, &config_schema[i], field_buffers[i]);
+	}
 
 	if (ds1307rtc_set_date_time(protocol->rtc) == DS1307_OK){ // update the device memory with the inserted values
 		return PROTOCOL_OK;
@@ -321,10 +261,7 @@ static int8_t load_custom_configuration(configuration_protocol_t *protocol){
  */
 static int8_t load_default_configuration(configuration_protocol_t *protocol){
 
-	memcpy(protocol->configuration->pin, DEFAULT_USER_PIN, PIN_SIZE); // load the default pin
-	protocol->configuration->sensor_delay_1 = DEFAULT_DELAY; // load the default sensor delay
-	protocol->configuration->sensor_delay_2 = DEFAULT_DELAY; // load the default sensor delay
-	protocol->configuration->duration = DEFAULT_DURATION; // load the default duration time
+	config_schema_load_defaults(protocol->configuration); // load the default of each field
 
 	if (ds1307rtc_update_date_time(protocol->rtc) == DS1307_OK){
 		return PROTOCOL_OK;
@@ -337,37 +274,22 @@ static int8_t load_default_configuration(configuration_protocol_t *protocol){
 /**
  * @brief 	Function that implements the tx callback procedure
  * @return 	void
+ * @note	It queues the next request and prepares the reception of the related field.
+ * 			It is called at the protocol start and after each received field has been echoed back.
  */
 void protocol_callback_tx(){
 
-	if(system.protocol->state == START_P){
-
-			system.protocol->state = PIN_R;
-			system_log_send_message_IT(system.system_log, (uint8_t *)INSERT_PIN , strlen(INSERT_PIN));
-			system_log_receive_message_IT(system.system_log, pin_buffer, PIN_SIZE);// wait for receiving pin
-
-		}else if(system.protocol->state  == PIN_T){
-
-			system.protocol->state = DELAY1_R; // wait for delay1
-			system_log_send_message_IT(system.system_log, (uint8_t *)INSERT_DELAY_SENSOR_1,strlen(INSERT_DELAY_SENSOR_1));
-			system_log_receive_message_IT(system.system_log, delay1_buffer, DELAY_SIZE); // wait for receiving the first delay
-
-		}else if(system.protocol->state == DELAY1_T){
-
-			system.protocol->state = DELAY2_R;
-			system_log_send_message_IT(system.system_log, (uint8_t *)INSERT_DELAY_SENSOR_2,strlen(INSERT_DELAY_SENSOR_2));
-			system_log_receive_message_IT(system.system_log, delay2_buffer, DELAY_SIZE);// wait for receiving the second delay
+	if(system.protocol->state == START_P || (system.protocol->state == FIELD_T && system.protocol->field + 1 < config_fields)){
 
-		}else if(system.protocol->state == DELAY2_T){
+			system.protocol->field = (system.protocol->state == START_P) ? 0 : system.protocol->field + 1;
+			system.protocol->state = FIELD_R; // wait for the next field of the schema
+			system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)config_schema[system.protocol->field].prompt, strlen(config_schema[system.protocol->field].prompt));
+			system_log_receive_message_IT(system.system_log, field_buffers[system.protocol->field], config_schema[system.protocol->field].width);
 
-			system.protocol->state = DURATION_R; // wait for duration
-			system_log_send_message_IT(system.system_log, (uint8_t *)INSERT_ALLARM_DURATION,strlen(INSERT_ALLARM_DURATION));
-			system_log_receive_message_IT(system.system_log, duration_buffer, DURATION_SIZE);// wait for receiving the duration
-
-		}else if(system.protocol->state == DURATION_T){
+		}else if(system.protocol->state == FIELD_T){
 
 			system.protocol->state = DATE_R;
-			system_log_send_message_IT(system.system_log, (uint8_t *)INSERT_DATE_TIME,strlen(INSERT_DATE_TIME));
+			system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)INSERT_DATE_TIME,strlen(INSERT_DATE_TIME));
 			system_log_receive_message_IT(system.system_log, date_time_buffer, DATE_TIME_SIZE);// wait for receiving the  date
 
 
@@ -403,82 +325,205 @@ void protocol_callback_tx(){
 		}
 		else if(system.protocol->state == SECOND_T){
 
-			stop_timer_IT(system.protocol->timer);
-			reset_timer_counter(system.protocol->timer);
+			timer_wheel_stop(&system.protocol->timer);
 			system.protocol->state = END_CUSTOM;
 
 		}
 
 }
 
+/**
+ * @brief 	Send back a date time field inserted by the user
+ * @param	prefix		string sent before the field
+ * @param	field		pointer to the two characters of the field
+ * @param	suffix		string sent after the field
+ */
+static void send_date_time_echo(const char *prefix, uint8_t *field, const char *suffix){
+
+	log_format_t format;
+
+	log_format_init(&format, echo, ECHO_SIZE);
+	log_format_string(&format, prefix);
+	log_format_chars(&format, field, DATE_TIME_SIZE);
+	log_format_string(&format, suffix);
+	system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)echo, log_format_end(&format));
+
+}
+
+/**
+ * @brief 	Copy a bulk mode value into the buffer of its field
+ * @param	buffer		buffer of the field
+ * @param	width		characters of the field
+ * @param	value		value characters
+ * @param	length		number of value characters
+ * @return	operation result, PROTOCOL_ERR if the value has not the width of the field
+ * @note	The date time separators '/', ':' and ' ' are skipped, the other characters are checked
+ * 			later by check_configuration_fields(), as for the interactive mode.
+ */
+static int8_t take_bulk_value(uint8_t *buffer, uint8_t width, const uint8_t *value, uint8_t length){
+
+	uint8_t i, size = 0;
+
+	for(i = 0; i < length; i++){
+		if(value[i] == '/' || value[i] == ':' || value[i] == ' '){
+			continue;
+		}
+		if(size == width){
+			return PROTOCOL_ERR;
+		}
+		buffer[size++] = value[i];
+	}
+
+	return size == width ? PROTOCOL_OK : PROTOCOL_ERR;
+}
+
+/**
+ * @brief 	Split the bulk mode line into the field buffers
+ * @param	line		line characters, without the terminator
+ * @param	length		number of line characters
+ * @return	operation result, PROTOCOL_ERR if a field is unknown, repeated, missing or of the wrong size
+ */
+static int8_t take_bulk_line(const uint8_t *line, uint8_t length){
+
+	const config_field_t *field;
+	uint8_t start = 0, end, key_end, i;
+	uint16_t taken = 0; // one bit for each field of the schema, then one for the date and time
+	int8_t result;
+
+	while(start < length){
+
+		for(end = start; end < length && line[end] != BULK_FIELD_SEPARATOR; end++){}
+		for(key_end = start; key_end < end && line[key_end] != BULK_KEY_SEPARATOR; key_end++){}
+
+		if(key_end == end){
+			return PROTOCOL_ERR; // no value
+		}
+
+		field = config_schema_find((const char *)line + start, key_end - start);
+
+		if(field != NULL){
+			i = field - config_schema;
+			result = take_bulk_value(field_buffers[i], field->width, line + key_end + 1, end - key_end - 1);
+		}else if(strlen(BULK_DATE_TIME) == key_end - start && memcmp(BULK_DATE_TIME, line + start, key_end - start) == 0){
+			i = config_fields;
+			result = take_bulk_value(date_time_buffer, DATE_TIME_BUFFER_SIZE, line + key_end + 1, end - key_end - 1);
+		}else{
+			return PROTOCOL_ERR; // unknown key
+		}
+
+		if(result != PROTOCOL_OK || (taken & (1 << i))){
+			return PROTOCOL_ERR;
+		}
+
+		taken |= 1 << i;
+		start = end + 1;
+	}
+
+	return taken == (1 << (config_fields + 1)) - 1 ? PROTOCOL_OK : PROTOCOL_ERR;
+}
+
+/**
+ * @brief 	Collect the bulk mode line
+ * @param	data	pointer to the received characters
+ * @param	size	number of received characters
+ * @note	It is the callback of the continuous DMA reception, so the line usually arrives in one call.
+ * 			A carriage return or a line feed ends the protocol: END_CUSTOM if the line is well formed,
+ * 			then the values are checked as the interactive ones, END_DEFAULT otherwise.
+ */
+static void protocol_receive_bulk(uint8_t *data, uint16_t size){
+
+	uint16_t i;
+
+	system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, data, size); // echo
+
+	for(i = 0; i < size && system.protocol->state == BULK_R; i++){
+
+		if(data[i] == '\r' || data[i] == '\n' || bulk_length == BULK_LINE_SIZE){
+
+			uart_handler_stop_reception(system.uart);
+			timer_wheel_stop(&system.protocol->timer);
+
+			if(bulk_length < BULK_LINE_SIZE && take_bulk_line(bulk_line, bulk_length) == PROTOCOL_OK){
+				system.protocol->state = END_CUSTOM;
+			}else{
+				system.protocol->state = END_DEFAULT;
+			}
+
+		}else{
+			bulk_line[bulk_length++] = data[i];
+		}
+
+	}
+
+}
+
 /**
  * @brief 	Function that implements the rx callback procedure
  * @return 	void
+ * @note	A pin starting with BULK_PREFIX switches to the bulk mode: the rest of the line is collected
+ * 			by the continuous DMA reception, whose buffer end also completes here. The switch happens in
+ * 			this interrupt, so a byte following the prefix at once could be lost: the reception is started
+ * 			before the prefix is echoed, and the sender waits the echo before the rest of the line.
  */
 void protocol_callback_rx(){
 
-	if(system.protocol->state == PIN_R ){
-
-		system.protocol->state = PIN_T;
-		system_log_send_message_IT(system.system_log, pin_buffer, PIN_SIZE); // send the inserted pin
+	if(system.protocol->state == BULK_R){
 
-	}else if(system.protocol->state == DELAY1_R){
+		uart_handler_rx_event(system.uart); // the circular DMA has reached the buffer end
+		return;
 
-		system.protocol->state = DELAY1_T;
-		system_log_send_message_IT(system.system_log, delay1_buffer,DELAY_SIZE); // send the inserted delay
+	}else if(system.protocol->state == FIELD_R && system.protocol->field == 0 && memcmp(field_buffers[0], BULK_PREFIX, PIN_SIZE) == 0){
 
-	}else if(system.protocol->state == DELAY2_R){
+		system.protocol->state = BULK_R;
+		memcpy(bulk_line, field_buffers[0], PIN_SIZE);
+		bulk_length = PIN_SIZE;
+		uart_handler_start_reception(system.uart, protocol_receive_bulk);
+		system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, field_buffers[0], PIN_SIZE); // send the inserted prefix, the reception is running
+		return;
 
-		system.protocol->state = DELAY2_T;
-		system_log_send_message_IT(system.system_log, delay2_buffer,DELAY_SIZE); // send the inserted delay
+	}else if(system.protocol->state == FIELD_R){
 
-	}else if(system.protocol->state == DURATION_R){
-
-		system.protocol->state = DURATION_T;
-		system_log_send_message_IT(system.system_log, duration_buffer,DURATION_SIZE); // send the inserted duration
+		system.protocol->state = FIELD_T;
+		system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, field_buffers[system.protocol->field], config_schema[system.protocol->field].width); // send the inserted field
 
 	}
 	else if(system.protocol->state == DATE_R){
 
 		system.protocol->state = DATE_T;
-		sprintf(msg," %c%c/", (char)date_time_buffer[0], (char)date_time_buffer[1]);
-		system_log_send_message_IT(system.system_log, (uint8_t *)msg,strlen(msg)); // send the inserted date
+		send_date_time_echo(" ", date_time_buffer, "/"); // send the inserted date
 
 	}
 	else if(system.protocol->state == MONTH_R){
 
 		system.protocol->state = MONTH_T;
-		sprintf(msg,"%c%c/", (char)date_time_buffer[2], (char)date_time_buffer[3]);
-		system_log_send_message_IT(system.system_log, (uint8_t *)msg,strlen(msg)); // send the inserted month
+		send_date_time_echo("", date_time_buffer+2, "/"); // send the inserted month
 
 	}
 	else if(system.protocol->state == YEAR_R){
 
 		system.protocol->state = YEAR_T;
-		sprintf(msg,"%c%c ", (char)date_time_buffer[4], (char)date_time_buffer[5]);
-		system_log_send_message_IT(system.system_log, (uint8_t *)msg,strlen(msg)); // send the inserted year
+		send_date_time_echo("", date_time_buffer+4, " "); // send the inserted year
 
 	}
 	else if(system.protocol->state == HOUR_R){
 
 		system.protocol->state = HOUR_T;
-		sprintf(msg,"%c%c:", (char)date_time_buffer[6], (char)date_time_buffer[7]);
-		system_log_send_message_IT(system.system_log, (uint8_t *)msg,strlen(msg)); // send the inserted hour
+		send_date_time_echo("", date_time_buffer+6, ":"); // send the inserted hour
 
 	}
 	else if(system.protocol->state == MINUTE_R){
 
 		system.protocol->state = MINUTE_T;
-		sprintf(msg,"%c%c:", (char)date_time_buffer[8], (char)date_time_buffer[9]);
-		system_log_send_message_IT(system.system_log, (uint8_t *)msg,strlen(msg)); // send the inserted minute
+		send_date_time_echo("", date_time_buffer+8, ":"); // send the inserted minute
 
 	}
 	else if(system.protocol->state == SECOND_R){
 
 		system.protocol->state = SECOND_T;
-		sprintf(msg,"%c%c", (char)date_time_buffer[10], (char)date_time_buffer[11]);
-		system_log_send_message_IT(system.system_log, (uint8_t *)msg,strlen(msg)); // send the inserted second
+		send_date_time_echo("", date_time_buffer+10, ""); // send the inserted second
 
 	}
 
+	protocol_callback_tx(); // the echo has been queued, go on with the next request
+
 }
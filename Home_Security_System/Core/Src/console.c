@@ -0,0 +1,494 @@
+/*
+ * console.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "console.h"
+#include "system.h"
+#include "uart_handler.h"
+#include "log_format.h"
+#include "string.h"
+
+/**
+ * @brief Console messages
+ */
+#define CONSOLE_PROMPT ("\n\r> ")
+#define CONSOLE_NEW_LINE ("\n\r")
+#define CONSOLE_UNKNOWN_COMMAND ("UNKNOWN COMMAND\n\r")
+#define CONSOLE_LINE_TOO_LONG ("LINE TOO LONG\n\r")
+#define CONSOLE_BUSY ("CONSOLE BUSY\n\r")
+#define CONSOLE_DONE ("DONE\n\r")
+#define CONSOLE_INVALID_VALUE ("INVALID VALUE\n\r")
+#define CONSOLE_BAUD_SWITCH ("SWITCH THE TERMINAL TO ")
+#define CONSOLE_BAUD_NOT_SAVED ("BAUD RATE NOT SAVED\n\r")
+#define CONSOLE_CONFIG_NOT_CLEARED ("CONFIGURATION NOT CLEARED\n\r")
+#define CONSOLE_CONFIG_NOT_SAVED ("CONFIGURATION NOT SAVED\n\r")
+#define CONSOLE_HELP_MESSAGE ("[pin] [command]  execute a keypad command, e.g. 0000 D#\n\r" \
+							  "STATUS           print the system state\n\r" \
+							  "DIAG             print the diagnostic counters\n\r" \
+							  "LOG ASCII        send the periodic log as text\n\r" \
+							  "LOG BINARY       send the periodic log as framed records\n\r" \
+							  "HEARTBEAT [s]    set the periodic log period, 0 to disable it\n\r" \
+							  "BAUD [rate]      set and save the baud rate, 9600 to 921600\n\r" \
+							  "TELEMETRY ON     stream the barrier samples as framed records\n\r" \
+							  "TELEMETRY OFF    stop the barrier samples stream\n\r" \
+							  "CONFIG CLEAR     run the configuration protocol at the next boot\n\r" \
+							  "SET [pin] [field] [value]  change and save a field, e.g. SET 0000 D1 10\n\r" \
+							  "                 fields: PIN, D1 and D2 0 to 30 s, DUR 5 to 60 s\n\r")
+
+/**
+ * @brief Size of the buffer for the formatted console answers
+ */
+#define CONSOLE_MSG_SIZE (768)
+
+/**
+ * @brief Buffer for the formatted console answers
+ */
+char console_msg[CONSOLE_MSG_SIZE];
+
+/**
+ * @brief  Initialize the console
+ * @param  console		pointer to console structure
+ * @param  system_log	pointer to system log structure, used to send the answers
+ * @param  kernel		kernel of the background task, which executes the lines
+ */
+void init_console(console_t *console, system_log_t *system_log, kernel_t *kernel){
+
+	console->length = 0;
+	console->overflow = 0;
+	console->kernel = kernel;
+	init_kernel_queue(&console->lines, console->lines_buffer, CONSOLE_LINE_SIZE, CONSOLE_QUEUE_SIZE);
+	console->system_log = system_log;
+
+	console->baud_rate_to_store = 0;
+	console->store_retry = 0;
+
+	console->erase_retry = 0;
+	console->save_retry = 0;
+
+}
+
+/**
+ * @brief  Start the console
+ * @param  console		pointer to console structure
+ * @return operation result
+ * @note   The UART continuous reception is started, so the commands are accepted in any system state
+ */
+int8_t start_console(console_t *console){
+
+	console->length = 0;
+	console->overflow = 0;
+
+	system_log_send_message(console->system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)CONSOLE_PROMPT, strlen(CONSOLE_PROMPT));
+
+	return uart_handler_start_reception(console->system_log->uart, console_receive);
+}
+
+/**
+ * @brief   Send a console answer
+ * @param   console		pointer to console structure
+ * @param	message		string to send
+ */
+static void console_send(console_t *console, char *message){
+
+	system_log_send_message(console->system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)message, strlen(message));
+
+}
+
+/**
+ * @brief   Send the current system and sensors state
+ * @param   console		pointer to console structure
+ */
+static void console_status(console_t *console){
+
+	log_format_t format;
+
+	log_format_init(&format, console_msg, CONSOLE_MSG_SIZE);
+	log_format_string(&format, "SYSTEM");
+	log_format_string(&format, get_system_state_string(system.state));
+	log_format_string(&format, "- AREA");
+	log_format_string(&format, get_state_string(get_state_pir(system.pir)));
+	log_format_string(&format, "- BARRIER");
+	log_format_string(&format, get_state_string(get_state_barrier(system.barrier)));
+	log_format_string(&format, "\n\r");
+	log_format_end(&format);
+	console_send(console, console_msg);
+
+}
+
+/**
+ * @brief Names of the boot reconciliation results, in the order of system_clock_reconcile_t
+ */
+static const char *reconcile_strings[] = {"KEPT", "SEEDED", "RESTORED", "UNSET", "RESTORE FAILED"};
+
+/**
+ * @brief   Send the diagnostic counters
+ * @param   console		pointer to console structure
+ * @note	The counters are sent on the diagnostic channel, so they never delay alarms and feedbacks
+ */
+static void console_diag(console_t *console){
+
+	uart_handler_t *uart = console->system_log->uart;
+	kernel_task_t *task;
+	log_format_t format;
+	uint8_t i;
+
+	log_format_init(&format, console_msg, CONSOLE_MSG_SIZE);
+	log_format_string(&format, "TX DROPPED: ALARM ");
+	log_format_uint(&format, uart->tx_queue[UART_CHANNEL_ALARM].dropped, 0);
+	log_format_string(&format, " FEEDBACK ");
+	log_format_uint(&format, uart->tx_queue[UART_CHANNEL_FEEDBACK].dropped, 0);
+	log_format_string(&format, " STATUS ");
+	log_format_uint(&format, uart->tx_queue[UART_CHANNEL_STATUS].dropped, 0);
+	log_format_string(&format, " DIAGNOSTIC ");
+	log_format_uint(&format, uart->tx_queue[UART_CHANNEL_DIAGNOSTIC].dropped, 0);
+	log_format_string(&format, " TELEMETRY ");
+	log_format_uint(&format, uart->tx_queue[UART_CHANNEL_TELEMETRY].dropped, 0);
+	log_format_string(&format, " - TX ERRORS ");
+	log_format_uint(&format, uart->tx_queue[UART_CHANNEL_ALARM].errors + uart->tx_queue[UART_CHANNEL_FEEDBACK].errors +
+			uart->tx_queue[UART_CHANNEL_STATUS].errors + uart->tx_queue[UART_CHANNEL_DIAGNOSTIC].errors +
+			uart->tx_queue[UART_CHANNEL_TELEMETRY].errors, 0);
+	log_format_string(&format, " - LOG RING DROPPED ");
+	log_format_uint(&format, console->system_log->ring.dropped, 0);
+	log_format_string(&format, "\n\rTIMEBASE DRIFT ");
+	log_format_int(&format, console->system_log->timebase.drift);
+	log_format_string(&format, " MS IN ");
+	log_format_uint(&format, console->system_log->timebase.drift_interval, 0);
+	log_format_string(&format, " S - RESYNCS ");
+	log_format_uint(&format, console->system_log->timebase.resyncs, 0);
+	log_format_string(&format, "\n\rRTC READS ");
+	log_format_uint(&format, console->system_log->reads, 0);
+	log_format_string(&format, " - SECOND EDGES ");
+	log_format_uint(&format, console->system_log->timebase.edges, 0);
+	log_format_string(&format, "\n\rCLOCK ");
+	log_format_string(&format, get_system_clock_source_string(system.clock));
+	log_format_string(&format, " - BOOT ");
+	log_format_string(&format, reconcile_strings[system.clock->reconcile]);
+	log_format_string(&format, "\n\rI2C DONE ");
+	log_format_uint(&format, system.i2c_bus->completed, 0);
+	log_format_string(&format, " - ERRORS ");
+	log_format_uint(&format, system.i2c_bus->errors, 0);
+	log_format_string(&format, " - TIMEOUTS ");
+	log_format_uint(&format, system.i2c_bus->timeouts, 0);
+	log_format_string(&format, " - RECOVERIES ");
+	log_format_uint(&format, system.i2c_bus->recoveries, 0);
+	log_format_string(&format, "\n\rTELEMETRY OVERRUNS ");
+	log_format_uint(&format, system.telemetry->overruns, 0);
+	log_format_string(&format, "\n\rIDLE ");
+	log_format_uint(&format, idle_meter_percent(system.idle_meter), 0);
+	log_format_string(&format, "% - SLEEPS ");
+	log_format_uint(&format, system.idle_meter->sleeps, 0);
+	log_format_string(&format, "\n\rSTOPS ");
+	log_format_uint(&format, system.tickless->stops, 0);
+	log_format_string(&format, " - STOPPED ");
+	log_format_uint(&format, system.tickless->stopped, 0);
+	log_format_string(&format, " MS - WAKE ");
+	log_format_uint(&format, tickless_wake_us(system.tickless), 0);
+	log_format_string(&format, " US, MAX ");
+	log_format_uint(&format, tickless_wake_max_us(system.tickless), 0);
+	log_format_string(&format, " US");
+	log_format_string(&format, "\n\rEVENTS DROPPED ");
+	log_format_uint(&format, system.event_queue->dropped, 0);
+	log_format_string(&format, " - SWITCHES ");
+	log_format_uint(&format, system.kernel->switches, 0);
+	for(i = 0; i < system.kernel->count; i++){ // stack high-water mark of each task
+		task = system.kernel->tasks[i];
+		log_format_string(&format, "\n\rTASK ");
+		log_format_string(&format, task->name);
+		log_format_string(&format, " STACK ");
+		log_format_uint(&format, task->stack_words - kernel_task_stack_free(task), 0);
+		log_format_string(&format, "/");
+		log_format_uint(&format, task->stack_words, 0);
+		log_format_string(&format, " WORDS");
+	}
+	log_format_string(&format, "\n\r");
+	system_log_send_message(console->system_log, UART_CHANNEL_DIAGNOSTIC, (uint8_t *)console_msg, log_format_end(&format));
+
+}
+
+/**
+ * @brief   Convert a decimal string into an unsigned value
+ * @param   string	null terminated string, only digits are accepted
+ * @param	value	pointer where store the converted value
+ * @param	max		maximum accepted value
+ * @return  operation result, CONSOLE_ERR if the string is empty, contains a non digit or exceeds max
+ */
+static int8_t console_parse_uint(char *string, uint32_t *value, uint32_t max){
+
+	uint32_t result = 0;
+
+	if(*string == '\0'){
+		return CONSOLE_ERR;
+	}
+
+	for(; *string != '\0'; string++){
+		if(*string < '0' || *string > '9'){
+			return CONSOLE_ERR;
+		}
+		if(result > (max - (*string - '0'))/10){ // result*10 + digit would exceed max
+			return CONSOLE_ERR;
+		}
+		result = result*10 + (*string - '0');
+	}
+
+	*value = result;
+
+	return CONSOLE_OK;
+}
+
+/**
+ * @brief   Set the heartbeat period of the system log
+ * @param   console		pointer to console structure
+ * @param	argument	period in seconds
+ */
+static void console_heartbeat(console_t *console, char *argument){
+
+	uint32_t heartbeat;
+
+	if(console_parse_uint(argument, &heartbeat, UINT16_MAX) == CONSOLE_OK && set_system_log_heartbeat(console->system_log, heartbeat) == SYSTEM_LOG_OK){
+		console_send(console, CONSOLE_DONE);
+	}else{
+		console_send(console, CONSOLE_INVALID_VALUE);
+	}
+
+}
+
+/**
+ * @brief   Change the baud rate of the console and save it
+ * @param   console		pointer to console structure
+ * @param	argument	baud rate, one of uart_baud_rates
+ * @note	The answer is sent at the old baud rate, then the change is applied by the main loop.
+ * 			The baud rate is saved into the flash by console_process(), so it is used at the next boot.
+ */
+static void console_baud(console_t *console, char *argument){
+
+	uint32_t baud_rate;
+	log_format_t format;
+
+	if(console_parse_uint(argument, &baud_rate, UINT32_MAX) != CONSOLE_OK || uart_handler_request_baud_rate(console->system_log->uart, baud_rate) != UART_OK){
+		console_send(console, CONSOLE_INVALID_VALUE);
+		return;
+	}
+
+	log_format_init(&format, console_msg, CONSOLE_MSG_SIZE);
+	log_format_string(&format, CONSOLE_BAUD_SWITCH);
+	log_format_uint(&format, baud_rate, 0);
+	log_format_string(&format, "\n\r");
+	log_format_end(&format);
+	console_send(console, console_msg);
+
+	console->baud_rate_to_store = baud_rate;
+	console->store_retry = CONSOLE_STORE_RETRY;
+
+}
+
+/**
+ * @brief   Change a field of the configuration in use and save it
+ * @param   console		pointer to console structure
+ * @param	argument	user pin, field name and value, separated by one space
+ * @note	A number shorter than the field is padded with leading zeros, so "D1 5" is "D1 05".
+ * 			The save is done by the main loop, as the one of the baud rate.
+ */
+static void console_set(console_t *console, char *argument){
+
+	uint8_t pin[1 + PIN_SIZE];
+	uint8_t value[CONFIG_FIELD_MAX_WIDTH];
+	const config_field_t *field;
+	char *name, *text;
+	uint8_t length;
+
+	name = strchr(argument, ' ');
+	text = (name != NULL) ? strchr(name + 1, ' ') : NULL;
+
+	if(name == NULL || text == NULL || name - argument != PIN_SIZE){
+		console_send(console, CONSOLE_INVALID_VALUE);
+		return;
+	}
+
+	name += 1;
+	text += 1;
+	field = config_schema_find(name, text - 1 - name);
+	length = strlen(text);
+
+	if(field == NULL || length == 0 || length > field->width || (field->type == CONFIG_FIELD_DIGITS && length != field->width)){
+		console_send(console, CONSOLE_INVALID_VALUE);
+		return;
+	}
+
+	pin[0] = '#'; // keypad format: '#' and user pin
+	memcpy(pin + 1, argument, PIN_SIZE);
+	memset(value, '0', field->width - length);
+	memcpy(value + field->width - length, text, length);
+
+	if(update_configuration(pin, field, value) == COMMAND_ACCEPTED){
+		console->save_retry = CONSOLE_STORE_RETRY;
+	}
+
+}
+
+/**
+ * @brief   Execute a complete command line
+ * @param   console		pointer to console structure
+ * @param	line		null terminated command line, upper case
+ * @note	A line composed by the user pin and a keypad command, spaces are ignored,
+ * 			is executed as if it was inserted through the keypad.
+ */
+void console_execute_line(console_t *console, char *line){
+
+	uint8_t command[COMMAND_BUFFER_SIZE + 1];
+	uint8_t length = 0;
+	uint8_t i;
+
+	command[length++] = '#'; // keypad command format: '#', user pin, command
+
+	for(i = 0; line[i] != '\0' && length <= COMMAND_BUFFER_SIZE; i++){
+		if(line[i] != ' '){
+			command[length++] = line[i];
+		}
+	}
+
+	if(line[0] == '\0'){
+		return; // empty line
+	}else if(strcmp(line, CONSOLE_HELP) == 0){
+		console_send(console, CONSOLE_HELP_MESSAGE);
+	}else if(strcmp(line, CONSOLE_STATUS) == 0){
+		console_status(console);
+	}else if(strcmp(line, CONSOLE_DIAG) == 0){
+		console_diag(console);
+	}else if(strcmp(line, CONSOLE_LOG_ASCII) == 0){
+		set_system_log_mode(console->system_log, LOG_MODE_ASCII);
+		console_send(console, CONSOLE_DONE);
+	}else if(strcmp(line, CONSOLE_LOG_BINARY) == 0){
+		set_system_log_mode(console->system_log, LOG_MODE_BINARY);
+		console_send(console, CONSOLE_DONE);
+	}else if(strncmp(line, CONSOLE_HEARTBEAT, strlen(CONSOLE_HEARTBEAT)) == 0){
+		console_heartbeat(console, line + strlen(CONSOLE_HEARTBEAT));
+	}else if(strcmp(line, CONSOLE_TELEMETRY_ON) == 0){
+		start_telemetry(system.telemetry);
+		console_send(console, CONSOLE_DONE);
+	}else if(strcmp(line, CONSOLE_TELEMETRY_OFF) == 0){
+		stop_telemetry(system.telemetry);
+		console_send(console, CONSOLE_DONE);
+	}else if(strncmp(line, CONSOLE_BAUD, strlen(CONSOLE_BAUD)) == 0){
+		console_baud(console, line + strlen(CONSOLE_BAUD));
+	}else if(strncmp(line, CONSOLE_SET, strlen(CONSOLE_SET)) == 0){
+		console_set(console, line + strlen(CONSOLE_SET));
+	}else if(strcmp(line, CONSOLE_CONFIG_CLEAR) == 0){
+		console->erase_retry = CONSOLE_STORE_RETRY;
+		console_send(console, CONSOLE_DONE);
+	}else if(length == COMMAND_BUFFER_SIZE && line[i] == '\0' && command[1] >= '0' && command[1] <= '9'){
+		run_user_command(command);
+	}else{
+		console_send(console, CONSOLE_UNKNOWN_COMMAND);
+	}
+
+}
+
+/**
+ * @brief   Collect the received characters into the command line
+ * @param   data	pointer to the received characters
+ * @param	size	number of received characters
+ * @note	It is the UART reception callback, so it is called only when the line is idle or the DMA
+ * 			has filled half of its buffer. The characters are echoed back and a carriage return or a
+ * 			line feed completes the line. The commands take the system lock and wait the i2c bus, so the
+ * 			complete line is queued for the background task instead of being executed in the interrupt.
+ */
+void console_receive(uint8_t *data, uint16_t size){
+
+	console_t *console = system.console;
+	uint16_t i;
+	uint8_t c;
+
+	system_log_send_message(console->system_log, UART_CHANNEL_FEEDBACK, data, size); // echo
+
+	for(i = 0; i < size; i++){
+
+		c = data[i];
+
+		if(c == '\r' || c == '\n'){
+
+			if(console->overflow){
+				console_send(console, CONSOLE_NEW_LINE);
+				console_send(console, CONSOLE_LINE_TOO_LONG);
+				console_send(console, CONSOLE_PROMPT);
+			}else if(console->length > 0){
+				console->line[console->length] = '\0';
+				console_send(console, CONSOLE_NEW_LINE);
+				if(kernel_queue_send(console->kernel, &console->lines, console->line) != KERNEL_OK){
+					console_send(console, CONSOLE_BUSY);
+					console_send(console, CONSOLE_PROMPT);
+				}
+			}
+			console->length = 0;
+			console->overflow = 0;
+
+		}else if(c == '\b' || c == 0x7F){ // backspace
+
+			if(console->length > 0){
+				console->length -= 1;
+			}
+
+		}else if(console->length < CONSOLE_LINE_SIZE - 1){
+
+			console->line[console->length++] = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+
+		}else{
+			console->overflow = 1;
+		}
+
+	}
+
+}
+
+/**
+ * @brief   Execute the queued lines and complete the deferred work of the commands
+ * @param   console		pointer to console structure
+ * @note	Called by the background task, each line is followed by the prompt. A failed save is retried a few
+ * 			times, then reported. A changed configuration is saved with the barrier calibration in use, so the
+ * 			next boot restores both. A save that erases a flash slot stalls the interrupts for 1 to 2 s, so it
+ * 			waits while the system is armed: it is done once the system is disarmed.
+ */
+void console_process(console_t *console){
+
+	char line[CONSOLE_LINE_SIZE];
+
+	while(kernel_queue_receive(console->kernel, &console->lines, line, 0) == KERNEL_OK){
+		console_execute_line(console, line);
+		console_send(console, CONSOLE_PROMPT);
+	}
+
+	if(system.state != SYSTEM_INACTIVE && config_store_needs_erase(system.config_store)){
+		return;
+	}
+
+	if(console->save_retry > 0){
+		if(config_store_save(system.config_store, system.system_configuration, system.barrier->threshold_up, system.barrier->threshold_down) == CONFIG_STORE_OK){
+			console->save_retry = 0;
+		}else if(--console->save_retry == 0){
+			console_send(console, CONSOLE_CONFIG_NOT_SAVED);
+		}
+	}
+
+	if(console->erase_retry > 0){
+		if(config_store_erase(system.config_store) == CONFIG_STORE_OK){
+			console->erase_retry = 0;
+		}else if(--console->erase_retry == 0){
+			console_send(console, CONSOLE_CONFIG_NOT_CLEARED);
+		}
+	}
+
+	if(console->baud_rate_to_store == 0){
+		return;
+	}
+
+	if(store_baud_rate(console->baud_rate_to_store) == SYS_OK){
+		console->baud_rate_to_store = 0;
+	}else if(--console->store_retry == 0){
+		console->baud_rate_to_store = 0;
+		console_send(console, CONSOLE_BAUD_NOT_SAVED);
+	}
+
+}
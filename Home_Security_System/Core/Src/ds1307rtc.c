@@ -8,33 +8,23 @@
 
 #include "ds1307rtc.h"
 #include "system.h"
+#include "epoch.h"
 /**
  * @brief Define BUFFER_SIZE constant
  */
 #define BUFFER_SIZE (7)
 
-/**
- * @brief Input buffer where write data received by the peripheral
- */
-uint8_t input_buffer[BUFFER_SIZE];
-
-/**
- * @brief Define months' days vector
- */
-uint8_t months[] = {
-	31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
-};
-
 
 /**
  * @brief 	RTC initializer
  * @param 	rtc  	pointer to the rtc_t structure to initialize
- * @param 	i2c 	pointer to the I2C peripheral handler to use
+ * @param 	bus 	pointer to the i2c bus to use
  * @return 	the operation result
+ * @note	The presence check is a direct HAL call: it is done at boot, while the bus is idle.
  */
-int8_t ds1307rtc_init(rtc_t *rtc, I2C_HandleTypeDef *i2c){
+int8_t ds1307rtc_init(rtc_t *rtc, i2c_bus_t *bus){
 
- 	HAL_StatusTypeDef returnValue = HAL_I2C_IsDeviceReady(i2c, DS1307_ADDRESS, MAX_RETRY, HAL_MAX_DELAY); // check if the device is ready
+ 	HAL_StatusTypeDef returnValue = HAL_I2C_IsDeviceReady(bus->i2c, DS1307_ADDRESS, MAX_RETRY, DS1307_READY_TIMEOUT); // check if the device is ready
 
 	if(returnValue != HAL_OK)
 	{
@@ -42,7 +32,8 @@ int8_t ds1307rtc_init(rtc_t *rtc, I2C_HandleTypeDef *i2c){
 
 	}else{
 
-		rtc->i2c = i2c; //assign the i2c peripheral handler
+		rtc->bus = bus; //assign the i2c bus
+		rtc->reading = 0;
 
 		ds1307rtc_update_date_time(rtc); // call update date_time structure procedure for initialization of the structure's fields
 
@@ -107,18 +98,44 @@ static void convert_input_buffer(date_time_t *date_time, uint8_t *buffer){
 
 }
 
+/**
+ * @brief 	Complete a DMA reading of the date and time
+ * @param 	transaction 	completed i2c bus transaction
+ * @note	Called by the i2c bus, in interrupt. A successful reading updates the rtc date_time structure and
+ * 			calls the system log, which is also informed of an error.
+ */
+static void date_time_read(i2c_transaction_t *transaction){
+
+	rtc_t *rtc = (rtc_t *)transaction->context;
+
+	rtc->reading = 0;
+
+	if(transaction->result != I2C_BUS_OK){
+		log_callback_error(); // the pending log records are discarded
+		return;
+	}
+
+	convert_input_buffer(&(rtc->date_time), transaction->data); // update rtc date_time structure
+	rtc->read_tick = transaction->tick;
+
+	log_callback_tx(); // call the system_log callback procedure
+
+}
+
 /**
  * @brief 	Update the date_time structure referenced by the rtc pointer in non-blocking mode
  * @param 	rtc 	RTC handler whose date and time must be updated
  * @return 	operation result
+ * @note	The reading is queued on the i2c bus, it waits the transactions of the other devices.
  */
 int8_t ds1307rtc_update_date_time_DMA(rtc_t *rtc){
 
-	// request for memory reading
-	HAL_StatusTypeDef return_value= HAL_I2C_Mem_Read_DMA(rtc->i2c, DS1307_ADDRESS, DS1307_SECONDS, ADDRESS_SIZE, input_buffer, BUFFER_SIZE);
+	rtc->reading = 1;
 
-	if(return_value != HAL_OK)
+	// request for memory reading
+	if(i2c_bus_submit(rtc->bus, I2C_BUS_READ, DS1307_ADDRESS, DS1307_SECONDS, NULL, BUFFER_SIZE, date_time_read, rtc) != I2C_BUS_OK)
 	{
+		rtc->reading = 0;
 		return DS1307_IC2_ERR;
 	}
 
@@ -135,14 +152,12 @@ int8_t ds1307rtc_update_date_time_DMA(rtc_t *rtc){
 */
 int8_t ds1307rtc_set_date_time_DMA(rtc_t *rtc){
 
-	uint8_t out_buffer[BUFFER_SIZE]; // define the output buffer
+	uint8_t out_buffer[BUFFER_SIZE]; // define the output buffer, it is copied by the i2c bus
 
 	prepare_out_buffer(&(rtc->date_time), out_buffer); // call the procedure for preparing the output buffer
 
 	// request for writing data
-	HAL_StatusTypeDef returnValue = HAL_I2C_Mem_Write_DMA(rtc->i2c, DS1307_ADDRESS, DS1307_SECONDS, ADDRESS_SIZE, out_buffer, BUFFER_SIZE);
-
-	if(returnValue != HAL_OK)
+	if(i2c_bus_submit(rtc->bus, I2C_BUS_WRITE, DS1307_ADDRESS, DS1307_SECONDS, out_buffer, BUFFER_SIZE, NULL, NULL) != I2C_BUS_OK)
 	{
 		return DS1307_IC2_ERR;
 	}
@@ -157,12 +172,10 @@ int8_t ds1307rtc_set_date_time_DMA(rtc_t *rtc){
  */
 int8_t ds1307rtc_update_date_time(rtc_t *rtc){
 
-	HAL_StatusTypeDef return_value;
+	uint8_t input_buffer[BUFFER_SIZE];
 
 	// request for memory reading
-	return_value = HAL_I2C_Mem_Read(rtc->i2c, DS1307_ADDRESS, DS1307_SECONDS, ADDRESS_SIZE, input_buffer, BUFFER_SIZE,HAL_MAX_DELAY);
-
-	if(return_value != HAL_OK)
+	if(i2c_bus_transfer(rtc->bus, I2C_BUS_READ, DS1307_ADDRESS, DS1307_SECONDS, input_buffer, BUFFER_SIZE) != I2C_BUS_OK)
 	{
 		return DS1307_IC2_ERR;
 	}
@@ -172,7 +185,7 @@ int8_t ds1307rtc_update_date_time(rtc_t *rtc){
 
 }
 /**
-* @brief 	Write the rtc's date_time structure values into peripheral memory, in non-blocking mode.
+* @brief 	Write the rtc's date_time structure values into peripheral memory, in blocking mode.
 * @param 	rtc 	pointer to the rtc handler to use
 * @return 	operation result
 */
@@ -183,9 +196,73 @@ int8_t ds1307rtc_set_date_time(rtc_t *rtc){
 	prepare_out_buffer(&(rtc->date_time), out_buffer); // call the procedure for preparing the output buffer
 
 	// request for writing data
-	HAL_StatusTypeDef returnValue = HAL_I2C_Mem_Write(rtc->i2c, DS1307_ADDRESS, DS1307_SECONDS, ADDRESS_SIZE, out_buffer, BUFFER_SIZE,HAL_MAX_DELAY);
+	if(i2c_bus_transfer(rtc->bus, I2C_BUS_WRITE, DS1307_ADDRESS, DS1307_SECONDS, out_buffer, BUFFER_SIZE) != I2C_BUS_OK)
+	{
+		return DS1307_IC2_ERR;
+	}
 
-	if(returnValue != HAL_OK)
+	return DS1307_OK;
+
+}
+
+/**
+ * @brief 	Enable or disable the 1 Hz square wave output, in blocking mode
+ * @param 	rtc 	pointer to the rtc handler to use
+ * @param 	enable 	1 to enable the output, 0 to keep it high
+ * @return 	operation result
+ * @note	The output is open drain: it needs a pull-up, the one of the MCU pin is enough.
+ * 			Its falling edge is the increment of the seconds.
+ */
+int8_t ds1307rtc_set_square_wave(rtc_t *rtc, uint8_t enable){
+
+	uint8_t control = enable ? (1 << DS1307_CONTROL_SQWE) : (1 << DS1307_CONTROL_OUT); // RS1 = RS0 = 0: 1 Hz
+
+	if(i2c_bus_transfer(rtc->bus, I2C_BUS_WRITE, DS1307_ADDRESS, DS1307_CONTROL, &control, DATA_SIZE) != I2C_BUS_OK)
+	{
+		return DS1307_IC2_ERR;
+	}
+
+	return DS1307_OK;
+
+}
+
+/**
+ * @brief 	Read the battery backed RAM of the rtc, in blocking mode
+ * @param 	rtc 	pointer to the rtc handler to use
+ * @param 	offset 	first byte to read, from the start of the RAM
+ * @param 	buffer 	pointer where store the read bytes
+ * @param 	size 	number of bytes to read
+ * @return 	operation result, DS1307_ERR if the range exceeds the RAM
+ * @note	The RAM keeps its content while the rtc is powered by the battery.
+ */
+int8_t ds1307rtc_read_ram(rtc_t *rtc, uint8_t offset, uint8_t *buffer, uint8_t size){
+
+	if(size == 0 || offset + size > DS1307_RAM_SIZE)
+		return DS1307_ERR;
+
+	if(i2c_bus_transfer(rtc->bus, I2C_BUS_READ, DS1307_ADDRESS, DS1307_RAM + offset, buffer, size) != I2C_BUS_OK)
+	{
+		return DS1307_IC2_ERR;
+	}
+
+	return DS1307_OK;
+
+}
+
+/**
+ * @brief 	Write the battery backed RAM of the rtc, in blocking mode
+ * @param 	rtc 	pointer to the rtc handler to use
+ * @param 	offset 	first byte to write, from the start of the RAM
+ * @param 	buffer 	bytes to write
+ * @param 	size 	number of bytes to write
+ * @return 	operation result, DS1307_ERR if the range exceeds the RAM
+ */
+int8_t ds1307rtc_write_ram(rtc_t *rtc, uint8_t offset, uint8_t *buffer, uint8_t size){
+
+	if(size == 0 || offset + size > DS1307_RAM_SIZE)
+		return DS1307_ERR;
+
+	if(i2c_bus_transfer(rtc->bus, I2C_BUS_WRITE, DS1307_ADDRESS, DS1307_RAM + offset, buffer, size) != I2C_BUS_OK)
 	{
 		return DS1307_IC2_ERR;
 	}
@@ -201,16 +278,18 @@ int8_t ds1307rtc_set_date_time(rtc_t *rtc){
  * @param 	month 	month value to set
  * @param 	date 	date value to set
  * @return 	operation result
+ * @note	29 February is accepted in the leap years only. The day of the week follows the date.
  */
 int8_t set_date(rtc_t *rtc,int8_t year,int8_t month,int8_t date){
 
 	if((year>=0 && year<=99) && (month>=1 && month<=12) && (date>=1 && date<=31)){
 		// check if the input parameters have a suitable value
-		if(date <= months[month-1]){
+		if(date <= epoch_days_in_month(year, month)){
 
 			rtc->date_time.year = year;
 			rtc->date_time.month = month;
 			rtc->date_time.date = date;
+			rtc->date_time.day = epoch_week_day(epoch_days_from_date(year, month, date));
 			return DS1307_OK;
 
 		}
@@ -296,15 +375,3 @@ uint8_t get_minute(rtc_t *rtc){
 uint8_t get_second(rtc_t *rtc){
 	return rtc->date_time.seconds;
 }
-
-/**
- * @brief 	I2C Memory Rx transfer completed callback redefinition
- * @param 	hi2c 	pointer to the peripheral handler that has raised the interrupt
- * @return 	void
- */
-void HAL_I2C_MemRxCpltCallback (I2C_HandleTypeDef *hi2c){
-
-	convert_input_buffer(&(system.rtc->date_time), input_buffer); // update system rtc date_time structure
-
-	log_callback_tx(); // call the system_log callback procedure
-}
@@ -0,0 +1,123 @@
+/*
+ * epoch.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "epoch.h"
+
+/**
+ * @brief Days from 01-03-0000 to 01-01-2000 of the proleptic Gregorian calendar
+ */
+#define DAYS_TO_EPOCH (730425)
+
+/**
+ * @brief Days in a 400 years era
+ */
+#define DAYS_PER_ERA (146097)
+
+/**
+ * @brief  Check if a year is a leap year
+ * @param  year		year [00-99] since 2000
+ * @return 1 if the year has 29 February
+ */
+uint8_t epoch_is_leap_year(uint8_t year){
+
+	uint16_t full_year = 2000 + year;
+
+	return (full_year%4 == 0 && full_year%100 != 0) || full_year%400 == 0;
+
+}
+
+/**
+ * @brief  Get the number of days of a month
+ * @param  year		year [00-99] since 2000
+ * @param  month	month [1-12]
+ * @return days of the month, 0 for an invalid month
+ * @note   Without table: the months alternate 31 and 30 days, with the phase changing in August.
+ */
+uint8_t epoch_days_in_month(uint8_t year, uint8_t month){
+
+	if(month < 1 || month > 12){
+		return 0;
+	}
+
+	if(month == 2){
+		return 28 + epoch_is_leap_year(year);
+	}
+
+	return 30 + ((month + (month >> 3)) & 1);
+}
+
+/**
+ * @brief  Convert a date into days since 01-01-2000
+ * @param  year		year [00-99] since 2000
+ * @param  month	month [1-12]
+ * @param  date		day of the month [1-31]
+ * @return days since 01-01-2000
+ * @note   The year starts in March, so 29 February is its last day and the month lengths follow
+ * 		   (153*m + 2)/5: no table is needed. Only divisions by constants, which become multiplications.
+ */
+uint32_t epoch_days_from_date(uint8_t year, uint8_t month, uint8_t date){
+
+	uint32_t y = 2000 + year - (month <= 2);
+	uint32_t era = y/400;
+	uint32_t year_of_era = y - era*400;
+	uint32_t day_of_year = (153*(month > 2 ? month - 3 : month + 9) + 2)/5 + date - 1;
+	uint32_t day_of_era = year_of_era*365 + year_of_era/4 - year_of_era/100 + day_of_year;
+
+	return era*DAYS_PER_ERA + day_of_era - DAYS_TO_EPOCH;
+}
+
+/**
+ * @brief  Get the day of the week
+ * @param  days		days since 01-01-2000
+ * @return day of the week [1-7], Monday is 1
+ */
+uint8_t epoch_week_day(uint32_t days){
+
+	return (days + 5)%7 + 1; // 01-01-2000 was a Saturday
+
+}
+
+/**
+ * @brief  Convert a date time into epoch seconds
+ * @param  date_time	pointer to date time structure, year in [00-99]
+ * @return seconds since 01-01-2000 00:00:00
+ */
+epoch_t epoch_from_date_time(const date_time_t *date_time){
+
+	uint32_t days = epoch_days_from_date(date_time->year, date_time->month, date_time->date);
+
+	return days*EPOCH_SECONDS_PER_DAY + date_time->hours*3600 + date_time->minutes*60 + date_time->seconds;
+}
+
+/**
+ * @brief  Convert epoch seconds into a date time
+ * @param  seconds		seconds since 01-01-2000 00:00:00
+ * @param  date_time	pointer where store the date time
+ * @note   Inverse of epoch_days_from_date(), on the year starting in March.
+ */
+void epoch_to_date_time(epoch_t seconds, date_time_t *date_time){
+
+	uint32_t days = seconds/EPOCH_SECONDS_PER_DAY;
+	uint32_t time = seconds - days*EPOCH_SECONDS_PER_DAY;
+	uint32_t z = days + DAYS_TO_EPOCH;
+	uint32_t era = z/DAYS_PER_ERA;
+	uint32_t day_of_era = z - era*DAYS_PER_ERA;
+	uint32_t year_of_era = (day_of_era - day_of_era/1460 + day_of_era/36524 - day_of_era/146096)/365;
+	uint32_t day_of_year = day_of_era - (365*year_of_era + year_of_era/4 - year_of_era/100);
+	uint32_t month_of_year = (5*day_of_year + 2)/153; // 0 is March
+	uint32_t month = month_of_year < 10 ? month_of_year + 3 : month_of_year - 9;
+
+	date_time->seconds = time%60;
+	date_time->minutes = (time/60)%60;
+	date_time->hours = time/3600;
+	date_time->day = epoch_week_day(days);
+	date_time->date = day_of_year - (153*month_of_year + 2)/5 + 1;
+	date_time->month = month;
+	date_time->year = era*400 + year_of_era + (month <= 2) - 2000;
+
+}
@@ -0,0 +1,119 @@
+/*
+ * event_queue.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include "event_queue.h"
+#include "stm32f4xx.h"
+
+/**
+ * @brief  Initialize the event queue
+ * @param  queue	pointer to event queue structure
+ * @note   It must be called before the interrupts that post are enabled.
+ */
+void init_event_queue(event_queue_t *queue){
+
+	uint32_t i;
+
+	for(i = 0; i < EVENT_QUEUE_SIZE; i++){
+		queue->slots[i].sequence = i;
+	}
+
+	queue->tail = 0;
+	queue->head = 0;
+	queue->dropped = 0;
+
+}
+
+/**
+ * @brief  Count a dropped event
+ * @param  queue	pointer to event queue structure
+ */
+static void count_dropped(event_queue_t *queue){
+
+	uint32_t dropped;
+
+	do{
+		dropped = __LDREXW(&queue->dropped);
+	}while(__STREXW(dropped + 1, &queue->dropped) != 0);
+
+}
+
+/**
+ * @brief  Post an event
+ * @param  queue	pointer to event queue structure
+ * @param  id		event identifier
+ * @param  arg		event argument
+ * @param  reserved	1 if the event can take the last EVENT_QUEUE_RESERVED slots, 0 otherwise
+ * @return operation result, EVENT_QUEUE_ERR if the queue is full and the event has been dropped
+ * @note   The slot is reserved by an exclusive increment of the tail: an interrupt that posts between the
+ * 		   LDREX and the STREX clears the exclusive monitor, so the STREX fails and the reservation is retried.
+ * 		   No interrupt is masked, the loop is retried at most once for each interrupt that preempts it.
+ * 		   A slot whose sequence is ahead of the position has been taken by such an interrupt: the tail is read
+ * 		   again. A slot whose sequence is behind has not been read yet: the queue is full.
+ * 		   The event is published by the sequence of its slot, written after the event.
+ * 		   An ordinary event is also dropped when only the reserved slots are left. The head read here can only
+ * 		   be older than the real one, so the free slots are never overestimated.
+ */
+int8_t event_queue_post(event_queue_t *queue, uint16_t id, uint16_t arg, uint8_t reserved){
+
+	event_slot_t *slot;
+	uint32_t position;
+	uint32_t limit = reserved ? EVENT_QUEUE_SIZE : EVENT_QUEUE_SIZE - EVENT_QUEUE_RESERVED;
+	int32_t distance;
+
+	for(;;){
+		position = __LDREXW(&queue->tail);
+		slot = &queue->slots[position & EVENT_QUEUE_MASK];
+		distance = (int32_t)(slot->sequence - position);
+		if(distance < 0 || (distance == 0 && position - queue->head >= limit)){ // the slot has not been read yet
+			__CLREX();
+			count_dropped(queue);
+			return EVENT_QUEUE_ERR;
+		}else if(distance > 0){ // the position has been reserved by a preempting post
+			__CLREX();
+		}else if(__STREXW(position + 1, &queue->tail) == 0){
+			break;
+		}
+	}
+
+	slot->event.id = id;
+	slot->event.arg = arg;
+
+	__DMB();
+
+	slot->sequence = position + 1;
+
+	return EVENT_QUEUE_OK;
+}
+
+/**
+ * @brief  Read the oldest event
+ * @param  queue	pointer to event queue structure
+ * @param  event	destination event
+ * @return operation result, EVENT_QUEUE_ERR if the queue is empty
+ * @note   Called by the consumer task. An event reserved by a post preempted before its publication stops the
+ * 		   reading: it is read by the next call, with the events that follow it.
+ */
+int8_t event_queue_pop(event_queue_t *queue, event_t *event){
+
+	event_slot_t *slot = &queue->slots[queue->head & EVENT_QUEUE_MASK];
+
+	if(slot->sequence != queue->head + 1){
+		return EVENT_QUEUE_ERR;
+	}
+
+	__DMB();
+
+	*event = slot->event;
+
+	__DMB();
+
+	slot->sequence = queue->head + EVENT_QUEUE_SIZE; // free for the post of the next turn
+
+	queue->head++;
+
+	return EVENT_QUEUE_OK;
+}
@@ -0,0 +1,419 @@
+/*
+ * i2c_bus.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "i2c_bus.h"
+#include "system.h"
+#include "critical_section.h"
+#include "string.h"
+
+/**
+ * @brief Mask of the free running queue indexes
+ */
+#define QUEUE_MASK (I2C_BUS_QUEUE_SIZE - 1)
+
+/**
+ * @brief Clock frequency of the recovery pulses, in Hz
+ */
+#define RECOVERY_CLOCK (100000)
+
+/**
+ * @brief Maximum clock pulses needed by a device to release SDA
+ */
+#define RECOVERY_PULSES (9)
+
+/**
+ * @brief Bus served by the HAL callbacks
+ */
+static i2c_bus_t *callback_bus = NULL;
+
+/**
+ * @brief Define the waiter of a blocking transfer
+ */
+struct transfer_waiter_s{
+
+	volatile uint8_t done;
+
+	int8_t result;
+
+	uint8_t *data; // where copy the bytes read
+
+};
+
+typedef struct transfer_waiter_s transfer_waiter_t;
+
+/**
+ * @brief  Initialize the i2c bus
+ * @param  bus		pointer to i2c bus structure
+ * @param  i2c		pointer to the I2C peripheral handler, already initialized
+ * @note   It can be called again while the bus is idle, for example by a second boot phase.
+ */
+void init_i2c_bus(i2c_bus_t *bus, I2C_HandleTypeDef *i2c){
+
+	if(callback_bus == bus && !i2c_bus_idle(bus)){
+		return;
+	}
+
+	bus->i2c = i2c;
+	bus->head = 0;
+	bus->tail = 0;
+	bus->active = 0;
+	bus->recover = 0;
+	bus->completed = 0;
+	bus->errors = 0;
+	bus->timeouts = 0;
+	bus->recoveries = 0;
+
+	callback_bus = bus;
+
+}
+
+/**
+ * @brief  End the running transaction and call its callback
+ * @param  bus		pointer to i2c bus structure
+ * @param  result	transaction result
+ * @note   The transaction is copied and released before the callback, so the callback can queue a new one.
+ * 		   Nothing is done if no transaction is running: a late HAL callback of an aborted transaction is ignored.
+ */
+static void finish(i2c_bus_t *bus, int8_t result){
+
+	i2c_transaction_t transaction;
+	uint32_t primask = critical_section_enter();
+
+	if(!bus->active){
+		critical_section_exit(primask);
+		return;
+	}
+
+	transaction = bus->queue[bus->tail & QUEUE_MASK];
+	bus->tail++;
+	bus->active = 0;
+	if(result == I2C_BUS_OK){
+		bus->completed++;
+	}else{
+		bus->errors++;
+	}
+	critical_section_exit(primask);
+
+	transaction.result = result;
+	if(transaction.callback != NULL){
+		transaction.callback(&transaction);
+	}
+
+}
+
+/**
+ * @brief  Start the queued transactions until one is running on DMA
+ * @param  bus		pointer to i2c bus structure
+ * @note   The running flag is taken with the interrupts disabled, the HAL call is done with the interrupts
+ * 		   enabled because it waits the address phase. A transaction that cannot start fails at once. The HAL
+ * 		   starts the DMA stream before the address phase and leaves it running after a NACK, so the stream is
+ * 		   aborted, otherwise every following start would fail.
+ */
+static void start_next(i2c_bus_t *bus){
+
+	i2c_transaction_t *transaction;
+	HAL_StatusTypeDef status;
+	uint32_t primask;
+
+	for(;;){
+
+		primask = critical_section_enter();
+		if(bus->active || bus->recover || bus->head == bus->tail){
+			critical_section_exit(primask);
+			return;
+		}
+		bus->active = 1;
+		critical_section_exit(primask);
+
+		transaction = &bus->queue[bus->tail & QUEUE_MASK];
+		transaction->result = I2C_BUS_OK;
+		bus->start_tick = HAL_GetTick();
+		transaction->tick = bus->start_tick;
+
+		if(transaction->direction == I2C_BUS_READ){
+			status = HAL_I2C_Mem_Read_DMA(bus->i2c, transaction->address, transaction->memory_address, I2C_MEMADD_SIZE_8BIT, transaction->data, transaction->size);
+		}else{
+			status = HAL_I2C_Mem_Write_DMA(bus->i2c, transaction->address, transaction->memory_address, I2C_MEMADD_SIZE_8BIT, transaction->data, transaction->size);
+		}
+
+		if(status == HAL_OK){
+			return;
+		}
+
+		if(status == HAL_BUSY){
+			bus->recover = 1; // BUSY flag stuck: a device holds SDA low
+		}else{
+			CLEAR_BIT(bus->i2c->Instance->CR2, I2C_CR2_DMAEN);
+			HAL_DMA_Abort(transaction->direction == I2C_BUS_READ ? bus->i2c->hdmarx : bus->i2c->hdmatx);
+		}
+		finish(bus, I2C_BUS_ERR);
+	}
+
+}
+
+/**
+ * @brief  Queue a transaction
+ * @param  bus				pointer to i2c bus structure
+ * @param  direction		I2C_BUS_READ or I2C_BUS_WRITE
+ * @param  address			8 bit device address
+ * @param  memory_address	first register of the device
+ * @param  data				bytes to write, copied into the transaction; ignored by the reads
+ * @param  size				number of bytes
+ * @param  callback			completion callback, NULL if the result is not needed
+ * @param  context			client data passed back to the callback
+ * @return operation result, I2C_BUS_ERR if the queue is full or size exceeds I2C_BUS_DATA_SIZE
+ * @note   It can be called from any interrupt and from the callbacks. An idle bus starts the transaction at once
+ * 		   only from the main loop with the interrupts enabled: the HAL waits the address phase on the tick, which
+ * 		   does not advance inside an interrupt, so the transaction is otherwise started by the next i2c_bus_process().
+ */
+int8_t i2c_bus_submit(i2c_bus_t *bus, i2c_bus_direction_t direction, uint16_t address, uint16_t memory_address,
+		const uint8_t *data, uint8_t size, i2c_bus_callback_t callback, void *context){
+
+	i2c_transaction_t *transaction;
+	uint32_t primask;
+
+	if(size == 0 || size > I2C_BUS_DATA_SIZE){
+		return I2C_BUS_ERR;
+	}
+
+	primask = critical_section_enter();
+
+	if((uint8_t)(bus->head - bus->tail) >= I2C_BUS_QUEUE_SIZE){
+		critical_section_exit(primask);
+		return I2C_BUS_ERR;
+	}
+
+	transaction = &bus->queue[bus->head & QUEUE_MASK];
+	transaction->direction = direction;
+	transaction->address = address;
+	transaction->memory_address = memory_address;
+	transaction->size = size;
+	transaction->callback = callback;
+	transaction->context = context;
+	if(direction == I2C_BUS_WRITE){
+		memcpy(transaction->data, data, size);
+	}
+	bus->head++;
+
+	critical_section_exit(primask);
+
+	if(primask == 0 && __get_IPSR() == 0){
+		start_next(bus);
+	}
+
+	return I2C_BUS_OK;
+}
+
+/**
+ * @brief  Store the result of a blocking transfer
+ * @param  transaction	completed transaction
+ */
+static void transfer_done(i2c_transaction_t *transaction){
+
+	transfer_waiter_t *waiter = (transfer_waiter_t *)transaction->context;
+
+	if(transaction->direction == I2C_BUS_READ && transaction->result == I2C_BUS_OK){
+		memcpy(waiter->data, transaction->data, transaction->size);
+	}
+
+	waiter->result = transaction->result;
+	waiter->done = 1;
+
+}
+
+/**
+ * @brief  Run a transaction and wait its completion
+ * @param  bus				pointer to i2c bus structure
+ * @param  direction		I2C_BUS_READ or I2C_BUS_WRITE
+ * @param  address			8 bit device address
+ * @param  memory_address	first register of the device
+ * @param  data				bytes to write, or where store the bytes read
+ * @param  size				number of bytes
+ * @return transaction result
+ * @note   It must be called from the main loop with the interrupts enabled: the transaction waits its turn
+ * 		   behind the queued ones, and the bus timeout bounds the wait.
+ */
+int8_t i2c_bus_transfer(i2c_bus_t *bus, i2c_bus_direction_t direction, uint16_t address, uint16_t memory_address,
+		uint8_t *data, uint8_t size){
+
+	transfer_waiter_t waiter = {0, I2C_BUS_ERR, data};
+
+	if(i2c_bus_submit(bus, direction, address, memory_address, data, size, transfer_done, &waiter) != I2C_BUS_OK){
+		return I2C_BUS_ERR;
+	}
+
+	while(!waiter.done){
+		i2c_bus_process(bus);
+		system_idle(); // woken by the i2c and DMA interrupts, or by the HAL tick for the timeout
+	}
+
+	return waiter.result;
+}
+
+/**
+ * @brief  Check if the bus is idle
+ * @param  bus		pointer to i2c bus structure
+ * @return 1 if no transaction is running or queued
+ */
+uint8_t i2c_bus_idle(i2c_bus_t *bus){
+
+	return !bus->active && bus->head == bus->tail;
+
+}
+
+/**
+ * @brief  Wait half period of the recovery clock
+ */
+static void recovery_delay(){
+
+	volatile uint32_t count = SystemCoreClock/(RECOVERY_CLOCK*2*4); // about 4 cycles for each iteration
+
+	while(count--);
+
+}
+
+/**
+ * @brief  Release a bus held by a device and reinitialize the peripheral
+ * @param  bus		pointer to i2c bus structure
+ * @note   A device reset in the middle of a read keeps SDA low until it has clocked out its byte: SCL is
+ * 		   pulsed as GPIO until SDA is released, then a STOP condition resets the state machine of the devices.
+ * 		   The peripheral is reinitialized, which also clears its BUSY flag and the DMA streams.
+ */
+static void recover_bus(i2c_bus_t *bus){
+
+	GPIO_InitTypeDef gpio = {0};
+	uint8_t pulses;
+
+	HAL_I2C_DeInit(bus->i2c);
+
+	HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+	HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+	gpio.Mode = GPIO_MODE_OUTPUT_OD;
+	gpio.Pull = GPIO_PULLUP;
+	gpio.Speed = GPIO_SPEED_FREQ_LOW;
+	gpio.Pin = I2C_BUS_SCL_PIN;
+	HAL_GPIO_Init(I2C_BUS_SCL_PORT, &gpio);
+	gpio.Pin = I2C_BUS_SDA_PIN;
+	HAL_GPIO_Init(I2C_BUS_SDA_PORT, &gpio);
+	recovery_delay();
+
+	for(pulses = 0; pulses < RECOVERY_PULSES && HAL_GPIO_ReadPin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN) == GPIO_PIN_RESET; pulses++){
+		HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_RESET);
+		recovery_delay();
+		HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+		recovery_delay();
+	}
+
+	// STOP: SDA rises while SCL is high
+	HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_RESET);
+	recovery_delay();
+	HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_RESET);
+	recovery_delay();
+	HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+	recovery_delay();
+	HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+	recovery_delay();
+
+	HAL_I2C_Init(bus->i2c); // the pins return to the peripheral
+
+	bus->recoveries++;
+
+}
+
+/**
+ * @brief  Supervise the bus
+ * @param  bus		pointer to i2c bus structure
+ * @note   Called by the main loop. A transaction running for more than I2C_BUS_TRANSACTION_TIMEOUT is aborted
+ * 		   and fails with I2C_BUS_TIMEOUT; the bus is recovered after a timeout or a bus error, then the
+ * 		   queue restarts. The transactions queued behind a completed one are started here.
+ */
+void i2c_bus_process(i2c_bus_t *bus){
+
+	uint8_t timeout = 0;
+	uint32_t primask = critical_section_enter();
+
+	if(bus->active && HAL_GetTick() - bus->start_tick > I2C_BUS_TRANSACTION_TIMEOUT){
+		__HAL_I2C_DISABLE_IT(bus->i2c, I2C_IT_EVT | I2C_IT_ERR | I2C_IT_BUF);
+		CLEAR_BIT(bus->i2c->Instance->CR2, I2C_CR2_DMAEN);
+		bus->recover = 1;
+		bus->timeouts++;
+		timeout = 1;
+	}
+
+	critical_section_exit(primask);
+
+	if(timeout){
+		finish(bus, I2C_BUS_TIMEOUT);
+	}
+
+	if(bus->recover && !bus->active){
+		recover_bus(bus);
+		bus->recover = 0;
+	}
+
+	start_next(bus);
+
+}
+
+/**
+ * @brief  End the running transaction
+ * @param  bus		pointer to i2c bus structure
+ * @param  result	transaction result
+ * @note   Called from the interrupts, so the next transaction is left to i2c_bus_process(): starting it here
+ * 		   would wait the address phase on a tick that cannot advance.
+ */
+void i2c_bus_complete(i2c_bus_t *bus, int8_t result){
+
+	finish(bus, result);
+
+}
+
+/**
+ * @brief 	I2C Memory Rx transfer completed callback redefinition
+ * @param 	hi2c 	pointer to the peripheral handler that has raised the interrupt
+ */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+
+	if(callback_bus != NULL && callback_bus->i2c == hi2c){
+		i2c_bus_complete(callback_bus, I2C_BUS_OK);
+	}
+
+}
+
+/**
+ * @brief 	I2C Memory Tx transfer completed callback redefinition
+ * @param 	hi2c 	pointer to the peripheral handler that has raised the interrupt
+ */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c){
+
+	if(callback_bus != NULL && callback_bus->i2c == hi2c){
+		i2c_bus_complete(callback_bus, I2C_BUS_OK);
+	}
+
+}
+
+/**
+ * @brief 	I2C error callback redefinition
+ * @param 	hi2c 	pointer to the peripheral handler that has raised the interrupt
+ * @note	The error code is pushed into the system log ring. A bus error or a lost arbitration, a device
+ * 			driving the bus out of turn, make the main loop recover the bus.
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+
+	if(system.system_log != NULL){
+		system_log_event(system.system_log, LOG_ID_I2C_ERROR, hi2c->ErrorCode, 0, 0);
+	}
+
+	if(callback_bus != NULL && callback_bus->i2c == hi2c){
+		if(hi2c->ErrorCode & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO)){
+			callback_bus->recover = 1;
+		}
+		i2c_bus_complete(callback_bus, I2C_BUS_ERR);
+	}
+
+}
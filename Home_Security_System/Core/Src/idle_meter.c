@@ -0,0 +1,72 @@
+/*
+ * idle_meter.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include "idle_meter.h"
+#include "critical_section.h"
+
+/**
+ * @brief  Initialize the idle meter
+ * @param  meter	pointer to the idle meter structure
+ * @note   SEVONPEND makes an interrupt wake the WFE of idle_meter_sleep() even while it is masked.
+ */
+void init_idle_meter(idle_meter_t *meter){
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+
+	meter->window_start = DWT->CYCCNT;
+	meter->idle_cycles = 0;
+	meter->idle_percent = 0;
+	meter->sleeps = 0;
+
+}
+
+/**
+ * @brief  Sleep until the next interrupt
+ * @param  meter	pointer to the idle meter structure
+ * @note   The interrupts are masked around the WFE, so the measure stops before the handler of the interrupt
+ * 		   that wakes the core runs. An interrupt handled since the last call has set the event register on its
+ * 		   return, so the WFE returns at once and the work it has queued is not left waiting for the next one.
+ */
+void idle_meter_sleep(idle_meter_t *meter){
+
+	uint32_t primask, start, now;
+
+	primask = critical_section_enter();
+
+	start = DWT->CYCCNT;
+	__WFE();
+	now = DWT->CYCCNT;
+
+	meter->idle_cycles += now - start;
+	meter->sleeps++;
+
+	critical_section_exit(primask); // the interrupt runs here
+
+	if(now - meter->window_start >= IDLE_METER_WINDOW){
+		meter->idle_percent = (uint64_t)meter->idle_cycles * 100 / (now - meter->window_start);
+		meter->window_start = now;
+		meter->idle_cycles = 0;
+	}
+
+}
+
+/**
+ * @brief  Get the idle share
+ * @param  meter	pointer to the idle meter structure
+ * @return share, in percent, of the last complete window spent sleeping
+ * @note   A window is closed by the first sleep after its end: while the main loop is busy the value
+ * 		   of the previous window is kept.
+ */
+uint8_t idle_meter_percent(idle_meter_t *meter){
+
+	return meter->idle_percent;
+
+}
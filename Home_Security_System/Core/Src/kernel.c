@@ -0,0 +1,508 @@
+/*
+ * kernel.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include "kernel.h"
+#include "kernel_port.h"
+#include "critical_section.h"
+#include "string.h"
+
+/**
+ * @brief Idle task: it runs when every task is blocked
+ */
+static kernel_task_t idle_task;
+
+/**
+ * @brief Stack of the idle task: the frame of an interrupt and the saved context
+ */
+static uint32_t idle_stack[KERNEL_IDLE_STACK_WORDS];
+
+/**
+ * @brief  Body of the idle task
+ */
+static void idle_entry(){
+
+	for(;;){
+		kernel_port_idle();
+	}
+
+}
+
+/**
+ * @brief  Insert a task into a list by priority
+ * @param  list		pointer to the head of the list
+ * @param  task		pointer to the task, not queued
+ * @note   A task is queued after the ones of the same priority, so they are woken in order of arrival.
+ */
+static void insert_waiter(kernel_task_t **list, kernel_task_t *task){
+
+	while(*list != NULL && (*list)->priority <= task->priority){
+		list = &(*list)->next_waiter;
+	}
+
+	task->next_waiter = *list;
+	*list = task;
+
+}
+
+/**
+ * @brief  Remove a task from the list it waits on
+ * @param  task		pointer to the task, queued
+ */
+static void remove_waiter(kernel_task_t *task){
+
+	kernel_task_t **list = task->wait_list;
+
+	while(*list != task){
+		list = &(*list)->next_waiter;
+	}
+
+	*list = task->next_waiter;
+	task->next_waiter = NULL;
+	task->wait_list = NULL;
+
+}
+
+/**
+ * @brief  Make a blocked task ready
+ * @param  task		pointer to the task
+ * @param  result	result of its wait
+ */
+static void wake_task(kernel_task_t *task, int8_t result){
+
+	if(task->wait_list != NULL){
+		remove_waiter(task);
+	}
+
+	task->result = result;
+	task->state = TASK_READY;
+
+}
+
+/**
+ * @brief  Select the highest priority ready task and request the switch to it
+ * @param  kernel	pointer to kernel structure
+ * @note   Called with the interrupts disabled. The idle task is always ready, so a task is always selected.
+ */
+static void schedule(kernel_t *kernel){
+
+	uint8_t i;
+
+	for(i = 0; kernel->tasks[i]->state != TASK_READY; i++);
+
+	kernel->next = kernel->tasks[i];
+
+	if(kernel->running && kernel->next != kernel->current){
+		kernel_port_request_switch();
+	}
+
+}
+
+/**
+ * @brief  Block the running task
+ * @param  kernel		pointer to kernel structure
+ * @param  list			list of the waited object, NULL for a sleep
+ * @param  timeout		ticks to the timeout, KERNEL_WAIT_FOREVER without limit
+ * @param  primask		value returned by the critical section entered by the caller
+ * @return result of the wait, KERNEL_TIMEOUT if the timeout is elapsed first
+ * @note   The switch happens at the exit of the critical section; the task goes on from there once woken.
+ */
+static int8_t block_current(kernel_t *kernel, kernel_task_t **list, uint32_t timeout, uint32_t primask){
+
+	kernel_task_t *task = kernel->current;
+
+	task->state = TASK_BLOCKED;
+	task->timeout = timeout;
+	task->result = KERNEL_TIMEOUT;
+	task->wait_list = list;
+	if(list != NULL){
+		insert_waiter(list, task);
+	}
+
+	schedule(kernel);
+
+	critical_section_exit(primask);
+
+	return task->result;
+}
+
+/**
+ * @brief  Initialize the kernel
+ * @param  kernel	pointer to kernel structure
+ * @note   The idle task is added with the lowest priority.
+ */
+void init_kernel(kernel_t *kernel){
+
+	memset(kernel, 0, sizeof(*kernel));
+
+	kernel_add_task(kernel, &idle_task, "IDLE", KERNEL_IDLE_PRIORITY, idle_entry, idle_stack, KERNEL_IDLE_STACK_WORDS);
+
+}
+
+/**
+ * @brief  Add a task
+ * @param  kernel		pointer to kernel structure
+ * @param  task			pointer to task structure
+ * @param  name			name reported by the diagnostics
+ * @param  priority		task priority, 0 is the highest, lower than KERNEL_IDLE_PRIORITY
+ * @param  entry		body of the task, it never returns
+ * @param  stack		static stack of the task
+ * @param  stack_words	size of the stack in words
+ * @return operation result
+ * @note   Called before the start. The tasks are kept by priority, a task is added after the ones of the same
+ * 		   priority: without time slicing the first one runs until it blocks.
+ */
+int8_t kernel_add_task(kernel_t *kernel, kernel_task_t *task, const char *name, uint8_t priority, kernel_task_entry_t entry, uint32_t *stack, uint16_t stack_words){
+
+	uint8_t i;
+
+	if(kernel->running || kernel->count == KERNEL_MAX_TASKS + 1){
+		return KERNEL_ERR;
+	}
+
+	task->stack = stack;
+	task->stack_words = stack_words;
+	task->priority = priority;
+	task->state = TASK_READY;
+	task->name = name;
+	task->timeout = KERNEL_WAIT_FOREVER;
+	task->wait_list = NULL;
+	task->next_waiter = NULL;
+	task->result = KERNEL_OK;
+
+	kernel_port_init_stack(task, entry);
+
+	for(i = kernel->count; i > 0 && kernel->tasks[i - 1]->priority > priority; i--){
+		kernel->tasks[i] = kernel->tasks[i - 1];
+	}
+
+	kernel->tasks[i] = task;
+	kernel->count++;
+
+	return KERNEL_OK;
+}
+
+/**
+ * @brief  Start the kernel
+ * @param  kernel	pointer to kernel structure
+ * @note   Called by the main once the tasks are added: the highest priority task is started and the stack of
+ * 		   the main is left to the interrupts.
+ */
+void kernel_start(kernel_t *kernel){
+
+	uint32_t primask = critical_section_enter();
+
+	schedule(kernel);
+	kernel->running = 1;
+
+	critical_section_exit(primask);
+
+	kernel_port_start(kernel);
+
+}
+
+/**
+ * @brief  Advance the timeouts of the blocked tasks
+ * @param  kernel	pointer to kernel structure
+ * @note   Called by the tick interrupt. A task whose timeout is elapsed is woken with KERNEL_TIMEOUT, a higher
+ * 		   priority one preempts the running task at the end of the interrupt.
+ */
+void kernel_tick(kernel_t *kernel){
+
+	kernel_task_t *task;
+	uint32_t primask;
+	uint8_t i;
+
+	if(!kernel->running){
+		return;
+	}
+
+	primask = critical_section_enter();
+
+	for(i = 0; i < kernel->count; i++){
+		task = kernel->tasks[i];
+		if(task->state == TASK_BLOCKED && task->timeout != KERNEL_WAIT_FOREVER && --task->timeout == 0){
+			wake_task(task, KERNEL_TIMEOUT);
+		}
+	}
+
+	schedule(kernel);
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief  Compute the first timeout
+ * @param  kernel	pointer to kernel structure
+ * @return ticks to the first timeout of the blocked tasks, KERNEL_WAIT_FOREVER if they all wait without limit
+ */
+uint32_t kernel_next_timeout(kernel_t *kernel){
+
+	kernel_task_t *task;
+	uint32_t next = KERNEL_WAIT_FOREVER;
+	uint32_t primask = critical_section_enter();
+	uint8_t i;
+
+	for(i = 0; i < kernel->count; i++){
+		task = kernel->tasks[i];
+		if(task->state == TASK_BLOCKED && task->timeout < next){
+			next = task->timeout;
+		}
+	}
+
+	critical_section_exit(primask);
+
+	return next;
+}
+
+/**
+ * @brief  Advance the timeouts by some ticks at once
+ * @param  kernel	pointer to kernel structure
+ * @param  ticks	ticks to advance
+ * @note   Same result of ticks calls of kernel_tick(): the tasks whose timeout is elapsed are woken.
+ */
+void kernel_skip(kernel_t *kernel, uint32_t ticks){
+
+	kernel_task_t *task;
+	uint32_t primask;
+	uint8_t i;
+
+	if(!kernel->running || ticks == 0){
+		return;
+	}
+
+	primask = critical_section_enter();
+
+	for(i = 0; i < kernel->count; i++){
+		task = kernel->tasks[i];
+		if(task->state == TASK_BLOCKED && task->timeout != KERNEL_WAIT_FOREVER){
+			if(task->timeout <= ticks){
+				task->timeout = 0;
+				wake_task(task, KERNEL_TIMEOUT);
+			}else{
+				task->timeout -= ticks;
+			}
+		}
+	}
+
+	schedule(kernel);
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief  Block the running task for some ticks
+ * @param  kernel	pointer to kernel structure
+ * @param  ticks	ticks to sleep, 0 returns at once
+ * @note   It must be called by a task, not by an interrupt.
+ */
+void kernel_sleep(kernel_t *kernel, uint32_t ticks){
+
+	uint32_t primask;
+
+	if(!kernel->running || ticks == 0){
+		return;
+	}
+
+	primask = critical_section_enter();
+
+	block_current(kernel, NULL, ticks, primask);
+
+}
+
+/**
+ * @brief  Get the running task
+ * @param  kernel	pointer to kernel structure
+ * @return running task, NULL before the start
+ */
+kernel_task_t *kernel_current(kernel_t *kernel){
+
+	return kernel->current;
+
+}
+
+/**
+ * @brief  Select the task to resume
+ * @param  kernel	pointer to kernel structure
+ * @return task to resume
+ * @note   Called by the context switch, once the context of the running task is saved.
+ */
+kernel_task_t *kernel_switch_context(kernel_t *kernel){
+
+	uint32_t primask = critical_section_enter();
+
+	if(kernel->current != kernel->next){
+		kernel->switches++;
+	}
+
+	kernel->current = kernel->next;
+
+	critical_section_exit(primask);
+
+	return kernel->current;
+}
+
+/**
+ * @brief  Get the unused stack of a task
+ * @param  task		pointer to task structure
+ * @return words from the lowest one of the stack to the deepest one ever written
+ * @note   The stack is filled with KERNEL_STACK_FILL when the task is added. A value of 0 means an overflow.
+ */
+uint16_t kernel_task_stack_free(kernel_task_t *task){
+
+	uint16_t free = 0;
+
+	while(free < task->stack_words && task->stack[free] == KERNEL_STACK_FILL){
+		free++;
+	}
+
+	return free;
+}
+
+/**
+ * @brief  Initialize a semaphore
+ * @param  semaphore	pointer to semaphore structure
+ * @param  count		initial count
+ * @param  limit		maximum count, 1 for a binary semaphore
+ */
+void init_kernel_semaphore(kernel_semaphore_t *semaphore, uint16_t count, uint16_t limit){
+
+	semaphore->count = count;
+	semaphore->limit = limit;
+	semaphore->waiters = NULL;
+
+}
+
+/**
+ * @brief  Take a semaphore
+ * @param  kernel		pointer to kernel structure
+ * @param  semaphore	pointer to semaphore structure
+ * @param  timeout		ticks to wait, 0 does not wait, KERNEL_WAIT_FOREVER without limit
+ * @return operation result, KERNEL_TIMEOUT if the count is still 0 at the timeout
+ * @note   It must be called by a task, not by an interrupt. Before the start it never waits.
+ */
+int8_t kernel_semaphore_take(kernel_t *kernel, kernel_semaphore_t *semaphore, uint32_t timeout){
+
+	uint32_t primask = critical_section_enter();
+
+	if(semaphore->count > 0){
+		semaphore->count--;
+		critical_section_exit(primask);
+		return KERNEL_OK;
+	}
+
+	if(timeout == 0 || !kernel->running){
+		critical_section_exit(primask);
+		return KERNEL_TIMEOUT;
+	}
+
+	return block_current(kernel, &semaphore->waiters, timeout, primask);
+}
+
+/**
+ * @brief  Give a semaphore
+ * @param  kernel		pointer to kernel structure
+ * @param  semaphore	pointer to semaphore structure
+ * @return operation result, KERNEL_ERR if the count is already at its limit
+ * @note   The count goes straight to the highest priority waiter, if any: it preempts the running task at the
+ * 		   end of the call, or at the end of the interrupt that gives.
+ */
+int8_t kernel_semaphore_give(kernel_t *kernel, kernel_semaphore_t *semaphore){
+
+	int8_t result = KERNEL_OK;
+	uint32_t primask = critical_section_enter();
+
+	if(semaphore->waiters != NULL){
+		wake_task(semaphore->waiters, KERNEL_OK);
+		schedule(kernel);
+	}else if(semaphore->count < semaphore->limit){
+		semaphore->count++;
+	}else{
+		result = KERNEL_ERR;
+	}
+
+	critical_section_exit(primask);
+
+	return result;
+}
+
+/**
+ * @brief  Initialize a message queue
+ * @param  queue		pointer to message queue structure
+ * @param  buffer		static buffer of capacity items
+ * @param  item_size	size of an item in bytes
+ * @param  capacity		number of items of the buffer
+ */
+void init_kernel_queue(kernel_queue_t *queue, void *buffer, uint16_t item_size, uint16_t capacity){
+
+	queue->buffer = buffer;
+	queue->item_size = item_size;
+	queue->capacity = capacity;
+	queue->head = 0;
+	queue->length = 0;
+
+	init_kernel_semaphore(&queue->items, 0, capacity);
+
+}
+
+/**
+ * @brief  Send an item
+ * @param  kernel	pointer to kernel structure
+ * @param  queue	pointer to message queue structure
+ * @param  item		item to copy
+ * @return operation result, KERNEL_ERR if the queue is full
+ */
+int8_t kernel_queue_send(kernel_t *kernel, kernel_queue_t *queue, const void *item){
+
+	uint32_t primask = critical_section_enter();
+	uint16_t tail;
+
+	if(queue->length == queue->capacity){
+		critical_section_exit(primask);
+		return KERNEL_ERR;
+	}
+
+	tail = (queue->head + queue->length) % queue->capacity;
+	memcpy(&queue->buffer[tail * queue->item_size], item, queue->item_size);
+	queue->length++;
+
+	kernel_semaphore_give(kernel, &queue->items); // nested, the switch waits for the outer exit
+
+	critical_section_exit(primask);
+
+	return KERNEL_OK;
+}
+
+/**
+ * @brief  Receive an item
+ * @param  kernel	pointer to kernel structure
+ * @param  queue	pointer to message queue structure
+ * @param  item		destination of the item
+ * @param  timeout	ticks to wait, 0 does not wait, KERNEL_WAIT_FOREVER without limit
+ * @return operation result, KERNEL_TIMEOUT if the queue is still empty at the timeout
+ * @note   It must be called by a task. Each queued item holds a count of the semaphore, so the item of a woken
+ * 		   task cannot be taken by another one.
+ */
+int8_t kernel_queue_receive(kernel_t *kernel, kernel_queue_t *queue, void *item, uint32_t timeout){
+
+	uint32_t primask;
+
+	if(kernel_semaphore_take(kernel, &queue->items, timeout) != KERNEL_OK){
+		return KERNEL_TIMEOUT;
+	}
+
+	primask = critical_section_enter();
+
+	memcpy(item, &queue->buffer[queue->head * queue->item_size], queue->item_size);
+	queue->head = (queue->head + 1) % queue->capacity;
+	queue->length--;
+
+	critical_section_exit(primask);
+
+	return KERNEL_OK;
+}
@@ -0,0 +1,135 @@
+/*
+ * kernel_port.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include "kernel_port.h"
+#include "stm32f4xx.h"
+
+/**
+ * Define the initial values of the frame of a task: Thumb state, thread mode on the process stack without
+ * floating point context
+ */
+#define INITIAL_XPSR (0x01000000)
+#define INITIAL_EXC_RETURN (0xFFFFFFFD)
+
+/**
+ * @brief Kernel switched by PendSV_Handler
+ */
+kernel_t *kernel_port_kernel = NULL;
+
+/**
+ * @brief  Return address of the task entries, they never return
+ */
+static void task_exit(){
+
+	for(;;);
+
+}
+
+/**
+ * @brief  Fill the stack of a task and build the frame of its first switch
+ * @param  task		pointer to task structure, with its stack
+ * @param  entry	body of the task
+ * @note   The frame is the one pushed by an interrupt, below it the registers saved by PendSV_Handler: the first
+ * 		   switch restores it as if the task had been interrupted at its entry.
+ */
+void kernel_port_init_stack(kernel_task_t *task, kernel_task_entry_t entry){
+
+	uint32_t *sp;
+	uint16_t i;
+
+	for(i = 0; i < task->stack_words; i++){
+		task->stack[i] = KERNEL_STACK_FILL;
+	}
+
+	sp = (uint32_t *)((uint32_t)(task->stack + task->stack_words) & ~7UL); // the frame is 8 byte aligned
+
+	*(--sp) = INITIAL_XPSR;
+	*(--sp) = (uint32_t)entry & ~1UL; // pc
+	*(--sp) = (uint32_t)task_exit; // lr
+	sp -= 5; // r12, r3, r2, r1, r0
+	*(--sp) = INITIAL_EXC_RETURN;
+	sp -= 8; // r11 - r4
+
+	task->sp = sp;
+
+}
+
+/**
+ * @brief  Request a context switch
+ * @note   PendSV has the lowest priority, so the switch happens once no other interrupt is running.
+ */
+void kernel_port_request_switch(){
+
+	SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+	__DSB();
+
+}
+
+/**
+ * @brief  Sleep until the next interrupt
+ */
+void kernel_port_idle(){
+
+	__WFI();
+
+}
+
+/**
+ * @brief  Switch from the main to the first task
+ * @param  kernel	pointer to kernel structure, its first task selected
+ * @note   No task is running, so the first switch saves no context. The main stack is left to the interrupts.
+ */
+void kernel_port_start(kernel_t *kernel){
+
+	kernel_port_kernel = kernel;
+
+	NVIC_SetPriority(PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1);
+
+	kernel_port_request_switch();
+	__ISB();
+
+	for(;;); // never reached
+
+}
+
+/**
+ * @brief  Context switch
+ * @note   It saves r4 - r11 and the exception return value on the process stack of the running task, and its
+ * 		   s16 - s31 if the task has a floating point context, then it restores the ones of the task selected by
+ * 		   kernel_switch_context(). The other registers are saved and restored by the exception entry and return.
+ */
+__attribute__((naked)) void PendSV_Handler(void){
+
+	__asm volatile(
+		"	ldr r3, =kernel_port_kernel		\n"
+		"	ldr r3, [r3]					\n"
+		"	ldr r2, [r3]					\n" // running task
+		"	cbz r2, 1f						\n" // first switch: no context to save
+		"	mrs r0, psp						\n"
+#if (__FPU_USED == 1)
+		"	tst lr, #0x10					\n"
+		"	it eq							\n"
+		"	vstmdbeq r0!, {s16-s31}			\n"
+#endif
+		"	stmdb r0!, {r4-r11, lr}			\n"
+		"	str r0, [r2]					\n"
+		"1:									\n"
+		"	mov r0, r3						\n"
+		"	bl kernel_switch_context		\n"
+		"	ldr r0, [r0]					\n"
+		"	ldmia r0!, {r4-r11, lr}			\n"
+#if (__FPU_USED == 1)
+		"	tst lr, #0x10					\n"
+		"	it eq							\n"
+		"	vldmiaeq r0!, {s16-s31}			\n"
+#endif
+		"	msr psp, r0						\n"
+		"	bx lr							\n"
+		"	.ltorg							\n"
+	);
+
+}
@@ -0,0 +1,231 @@
+/*
+ * log_format.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "log_format.h"
+
+/**
+ * @brief Maximum number of decimal digits of an uint32_t value
+ */
+#define UINT32_DIGITS (10)
+
+/**
+ * @brief  Initialize the log format structure on the given buffer
+ * @param  format	pointer to log format structure
+ * @param  buffer	caller-provided buffer, it must hold at least one character for the terminator
+ * @param  size		buffer capacity
+ * @note   The formatter never allocates memory, it only writes into buffer.
+ */
+void log_format_init(log_format_t *format, char *buffer, uint16_t size){
+
+	format->buffer = buffer;
+	format->size = size;
+	format->length = 0;
+	format->overflow = 0;
+
+}
+
+/**
+ * @brief  Append a character
+ * @param  format	pointer to log format structure
+ * @param  c		character to append
+ * @return operation result, LOG_FORMAT_ERR if the buffer is full
+ * @note   The last position of the buffer is always kept for the terminator.
+ */
+int8_t log_format_char(log_format_t *format, char c){
+
+	if(format->length + 1 >= format->size){
+		format->overflow = 1;
+		return LOG_FORMAT_ERR;
+	}
+
+	format->buffer[format->length++] = c;
+
+	return LOG_FORMAT_OK;
+}
+
+/**
+ * @brief  Append a null terminated string
+ * @param  format	pointer to log format structure
+ * @param  string	string to append
+ * @return operation result, LOG_FORMAT_ERR if the string has been truncated
+ */
+int8_t log_format_string(log_format_t *format, const char *string){
+
+	while(*string != '\0'){
+		if(log_format_char(format, *string++) != LOG_FORMAT_OK){
+			return LOG_FORMAT_ERR;
+		}
+	}
+
+	return LOG_FORMAT_OK;
+}
+
+/**
+ * @brief  Append size characters of the given buffer
+ * @param  format	pointer to log format structure
+ * @param  chars	characters to append, they have not to be null terminated
+ * @param  size		number of characters to append
+ * @return operation result, LOG_FORMAT_ERR if the characters have been truncated
+ */
+int8_t log_format_chars(log_format_t *format, const uint8_t *chars, uint16_t size){
+
+	for(uint16_t i = 0; i < size; i++){
+		if(log_format_char(format, (char)chars[i]) != LOG_FORMAT_OK){
+			return LOG_FORMAT_ERR;
+		}
+	}
+
+	return LOG_FORMAT_OK;
+}
+
+/**
+ * @brief  Append an unsigned decimal value
+ * @param  format	pointer to log format structure
+ * @param  value	value to append
+ * @param  width	minimum number of digits, the value is padded with zeros (0 for no padding)
+ * @return operation result, LOG_FORMAT_ERR if the value has been truncated
+ * @note   The digits are produced from the least significant one into a local buffer,
+ * 		   so no division by powers of ten and no library call are needed.
+ */
+int8_t log_format_uint(log_format_t *format, uint32_t value, uint8_t width){
+
+	char digits[UINT32_DIGITS];
+	uint8_t count = 0;
+
+	do{
+		digits[count++] = value%10 + '0';
+		value /= 10;
+	}while(value != 0);
+
+	for(; width > count; width--){
+		if(log_format_char(format, '0') != LOG_FORMAT_OK){
+			return LOG_FORMAT_ERR;
+		}
+	}
+
+	while(count > 0){
+		if(log_format_char(format, digits[--count]) != LOG_FORMAT_OK){
+			return LOG_FORMAT_ERR;
+		}
+	}
+
+	return LOG_FORMAT_OK;
+}
+
+/**
+ * @brief  Append a signed decimal value
+ * @param  format	pointer to log format structure
+ * @param  value	value to append
+ * @return operation result, LOG_FORMAT_ERR if the value has been truncated
+ */
+int8_t log_format_int(log_format_t *format, int32_t value){
+
+	if(value < 0){
+		if(log_format_char(format, '-') != LOG_FORMAT_OK){
+			return LOG_FORMAT_ERR;
+		}
+		return log_format_uint(format, -(uint32_t)value, 0);
+	}
+
+	return log_format_uint(format, value, 0);
+}
+
+/**
+ * @brief  Append the date and time fields, without brackets
+ * @param  format		pointer to log format structure
+ * @param  date_time	pointer to date time structure
+ */
+static void log_format_date_time_fields(log_format_t *format, date_time_t *date_time){
+
+	log_format_uint(format, date_time->date, 2);
+	log_format_char(format, '-');
+	log_format_uint(format, date_time->month, 2);
+	log_format_string(format, "-20");
+	log_format_uint(format, date_time->year, 2);
+	log_format_char(format, ' ');
+	log_format_uint(format, date_time->hours, 2);
+	log_format_char(format, ':');
+	log_format_uint(format, date_time->minutes, 2);
+	log_format_char(format, ':');
+	log_format_uint(format, date_time->seconds, 2);
+
+}
+
+/**
+ * @brief  Append the given date and time
+ * @param  format		pointer to log format structure
+ * @param  date_time	pointer to date time structure, as read from the rtc
+ * @return operation result, LOG_FORMAT_ERR if the field has been truncated
+ * @note   The field has a fixed width of LOG_FORMAT_DATE_TIME_SIZE characters: "[dd-mm-yyyy hh:mm:ss]"
+ */
+int8_t log_format_date_time(log_format_t *format, date_time_t *date_time){
+
+	log_format_char(format, '[');
+	log_format_date_time_fields(format, date_time);
+
+	return log_format_char(format, ']'); // it fails if any previous field has filled the buffer
+}
+
+/**
+ * @brief  Append the given date and time with milliseconds
+ * @param  format		pointer to log format structure
+ * @param  date_time	pointer to date time structure
+ * @param  milliseconds	milliseconds [0-999]
+ * @return operation result, LOG_FORMAT_ERR if the field has been truncated
+ * @note   The field has a fixed width of LOG_FORMAT_TIMESTAMP_SIZE characters: "[dd-mm-yyyy hh:mm:ss.mmm]"
+ */
+int8_t log_format_timestamp(log_format_t *format, date_time_t *date_time, uint16_t milliseconds){
+
+	log_format_char(format, '[');
+	log_format_date_time_fields(format, date_time);
+	log_format_char(format, '.');
+	log_format_uint(format, milliseconds, 3);
+
+	return log_format_char(format, ']'); // it fails if any previous field has filled the buffer
+}
+
+/**
+ * @brief  Append a message text replacing each "%u" or "%d" with the next argument
+ * @param  format	pointer to log format structure
+ * @param  text		message text
+ * @param  args		arguments, as many as the "%u" and "%d" in text
+ * @return operation result, LOG_FORMAT_ERR if the message has been truncated
+ * @note   Only "%u" (unsigned) and "%d" (signed) are recognized, any other character is copied as it is.
+ */
+int8_t log_format_message(log_format_t *format, const char *text, const uint32_t *args){
+
+	int8_t result = LOG_FORMAT_OK;
+
+	while(*text != '\0' && result == LOG_FORMAT_OK){
+
+		if(text[0] == '%' && text[1] == 'u'){
+			result = log_format_uint(format, *args++, 0);
+			text += 2;
+		}else if(text[0] == '%' && text[1] == 'd'){
+			result = log_format_int(format, (int32_t)*args++);
+			text += 2;
+		}else{
+			result = log_format_char(format, *text++);
+		}
+
+	}
+
+	return result;
+}
+
+/**
+ * @brief  Terminate the formatted string
+ * @param  format	pointer to log format structure
+ * @return number of characters written, terminator excluded
+ */
+uint16_t log_format_end(log_format_t *format){
+
+	format->buffer[format->length] = '\0';
+
+	return format->length;
+}
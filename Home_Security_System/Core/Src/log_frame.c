@@ -0,0 +1,101 @@
+/*
+ * log_frame.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "log_frame.h"
+#include <string.h>
+
+/**
+ * @brief CRC-16/CCITT-FALSE polynomial and initial value
+ */
+#define CRC16_POLYNOMIAL (0x1021)
+#define CRC16_INIT (0xFFFF)
+
+/**
+ * @brief Maximum COBS block: a code byte covers at most 254 data bytes
+ */
+#define COBS_MAX_CODE (0xFF)
+
+/**
+ * @brief  Compute the CRC-16/CCITT-FALSE of the given buffer
+ * @param  data		pointer to the buffer
+ * @param  size		number of bytes
+ * @return the computed CRC
+ * @note   The bitwise form is used: the records are a few bytes long, so a lookup table would cost
+ * 		   more flash than the cycles it saves.
+ */
+uint16_t log_frame_crc16(const uint8_t *data, uint16_t size){
+
+	uint16_t crc = CRC16_INIT;
+
+	for(uint16_t i = 0; i < size; i++){
+
+		crc ^= (uint16_t)data[i] << 8;
+
+		for(uint8_t bit = 0; bit < 8; bit++){
+			crc = (crc & 0x8000) ? (crc << 1) ^ CRC16_POLYNOMIAL : crc << 1;
+		}
+
+	}
+
+	return crc;
+}
+
+/**
+ * @brief  Build the frame carrying the given record
+ * @param  record	pointer to the record, its first byte is the record type
+ * @param  size		record size, at most LOG_FRAME_MAX_RECORD_SIZE
+ * @param  frame	pointer to the output buffer, at least LOG_FRAME_SIZE(size) bytes
+ * @return the frame size, 0 if the record is too long
+ * @note   The CRC is appended to the record, little endian, then the whole is COBS encoded.
+ * 		   The frame starts and ends with a delimiter, so a receiver can resynchronize at any
+ * 		   frame and skip the ASCII messages interleaved on the same UART.
+ */
+uint16_t log_frame_encode(const uint8_t *record, uint16_t size, uint8_t *frame){
+
+	uint8_t raw[LOG_FRAME_MAX_RECORD_SIZE + LOG_FRAME_CRC_SIZE];
+	uint16_t crc;
+	uint16_t code_index;
+	uint16_t length = 0;
+	uint8_t code = 1;
+
+	if(size > LOG_FRAME_MAX_RECORD_SIZE){
+		return 0;
+	}
+
+	memcpy(raw, record, size);
+	crc = log_frame_crc16(record, size);
+	raw[size] = crc & 0xFF;
+	raw[size + 1] = crc >> 8;
+	size += LOG_FRAME_CRC_SIZE;
+
+	frame[length++] = LOG_FRAME_DELIMITER;
+	code_index = length++;
+
+	for(uint16_t i = 0; i < size; i++){
+
+		if(raw[i] == LOG_FRAME_DELIMITER){ // close the current block, the delimiter is implied by the code
+			frame[code_index] = code;
+			code_index = length++;
+			code = 1;
+		}else{
+			frame[length++] = raw[i];
+			code++;
+			if(code == COBS_MAX_CODE && i + 1 < size){ // full block without delimiter
+				frame[code_index] = code;
+				code_index = length++;
+				code = 1;
+			}
+		}
+
+	}
+
+	frame[code_index] = code;
+	frame[length++] = LOG_FRAME_DELIMITER;
+
+	return length;
+}
@@ -0,0 +1,84 @@
+/*
+ * log_ring.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "log_ring.h"
+#include "critical_section.h"
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief  Initialize the log ring
+ * @param  ring		pointer to log ring structure
+ */
+void log_ring_init(log_ring_t *ring){
+
+	ring->head = 0;
+	ring->tail = 0;
+	ring->dropped = 0;
+
+}
+
+/**
+ * @brief  Push a record
+ * @param  ring		pointer to log ring structure
+ * @param  id		message identifier
+ * @param  arg0		first raw argument
+ * @param  arg1		second raw argument
+ * @param  arg2		third raw argument
+ * @return operation result, LOG_RING_ERR if the ring is full and the record has been dropped
+ * @note   Only the identifier, the tick and the raw arguments are copied: the formatting is done by the
+ * 		   consumer, so the call is short and bounded and it can be used from any interrupt.
+ */
+int8_t log_ring_push(log_ring_t *ring, log_id_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2){
+
+	log_record_t *record;
+	uint32_t primask = critical_section_enter();
+	uint16_t head = ring->head;
+
+	if(((head + 1) & (LOG_RING_SIZE - 1)) == ring->tail){
+		ring->dropped++;
+		critical_section_exit(primask);
+		return LOG_RING_ERR;
+	}
+
+	record = &ring->records[head];
+	record->tick = HAL_GetTick();
+	record->args[0] = arg0;
+	record->args[1] = arg1;
+	record->args[2] = arg2;
+	record->sequence = ring->sequence++;
+	record->id = id;
+
+	ring->head = (head + 1) & (LOG_RING_SIZE - 1);
+
+	critical_section_exit(primask);
+
+	return LOG_RING_OK;
+}
+
+/**
+ * @brief  Pop the oldest record
+ * @param  ring		pointer to log ring structure
+ * @param  record	pointer where copy the record
+ * @return operation result, LOG_RING_ERR if the ring is empty
+ * @note   The record is copied before releasing its slot, so no critical section is needed with a single consumer.
+ * 		   The slot content is kept until it is overwritten, so a memory dump shows the latest records.
+ */
+int8_t log_ring_pop(log_ring_t *ring, log_record_t *record){
+
+	uint16_t tail = ring->tail;
+
+	if(tail == ring->head){
+		return LOG_RING_ERR;
+	}
+
+	*record = ring->records[tail];
+
+	ring->tail = (tail + 1) & (LOG_RING_SIZE - 1);
+
+	return LOG_RING_OK;
+}
@@ -35,7 +35,6 @@
 #include "system_log.h"
 #include "system_led.h"
 #include "string.h"
-#include "stdio.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -49,6 +48,10 @@
  * @brief waiting time for user inserting START
  */
 #define WAITING_TIME (30000)
+/**
+ * @brief waiting time for START at each attempt when the saved baud rate is not the default one
+ */
+#define ALTERNATE_WAITING_TIME (10000)
 /**
  * @brief buffer size for waiting procedure
  */
@@ -70,7 +73,6 @@
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
-int8_t check_putty();
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -122,18 +124,16 @@ int main(void)
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
 
-  while(check_putty() != 0){}
+  init_system_idle(); // the waits of the boot sleep too
 
-  if(init_system() == SYS_OK)
-	  run_system();
+  init_system(); // the boot stages are run by the background task
 
+  start_system_tasks(); // it never returns: the alarm task and the background task share the core
 
-  while (1)
-  {
-    /* USER CODE END WHILE */
+  /* USER CODE END WHILE */
+
+  /* USER CODE BEGIN 3 */
 
-    /* USER CODE BEGIN 3 */
-  }
   /* USER CODE END 3 */
 }
 
@@ -178,19 +178,38 @@ void SystemClock_Config(void)
 /* USER CODE BEGIN 4 */
 /**
  * @brief wait for user, that must insert START before the system boots.
+ * @param baud_rate saved console baud rate
  * @retval operation result, 0 if START has been inserted or -1 if not
+ * @note  If the saved baud rate is not the default one, the attempts alternate it with the default one,
+ * 		  so a terminal that does not match the saved baud rate can still start the system at 9600.
+ * 		  The system keeps the baud rate of the attempt that received START.
  */
-int8_t check_putty(){
+int8_t check_putty(uint32_t baud_rate){
+
+	static uint8_t attempt = 0;
+	uint32_t waiting_time = WAITING_TIME;
+
+	if(baud_rate != UART_DEFAULT_BAUD_RATE){
+		waiting_time = ALTERNATE_WAITING_TIME;
+		if(attempt++ % 2 != 0)
+			baud_rate = UART_DEFAULT_BAUD_RATE;
+	}
+
+	if(huart2.Init.BaudRate != baud_rate){
+		huart2.Init.BaudRate = baud_rate;
+		HAL_UART_Init(&huart2);
+	}
 
 	uint8_t buffer[BUFFER_WAITING_SIZE];
-	sprintf((char *)buffer,"\n\r");
+	strcpy((char *)buffer,"\n\r");
 	HAL_UART_Transmit(&huart2, buffer, strlen((char *)buffer), HAL_MAX_DELAY);
-	HAL_StatusTypeDef retr_val = HAL_UART_Receive(&huart2, buffer, strlen(START_STRING), WAITING_TIME); // wait 30 seconds for START
+	HAL_StatusTypeDef retr_val = HAL_UART_Receive(&huart2, buffer, strlen(START_STRING), waiting_time); // wait for START
+	buffer[strlen(START_STRING)] = '\0';
 	if(retr_val == HAL_OK && strcmp(START_STRING, (char *)buffer) == 0){
 		HAL_UART_Transmit(&huart2, buffer, strlen((char *)buffer), HAL_MAX_DELAY); // send back the inserted START string
 		return 0;
 	}else{
-		sprintf((char*)buffer, "ERROR");
+		strcpy((char*)buffer, "ERROR");
 		HAL_UART_Transmit(&huart2, buffer, strlen((char *)buffer), HAL_MAX_DELAY); // send error string
 	}
 		return -1;
@@ -28,10 +28,8 @@ uint32_t counter;
  * @param  delay		   alarm delay value
  * @param  pulse		   ringtone value
  * @param  stable_signal   number of conversions under the threshold to consider the signal stable
- * @note   The module sets its threshold:
- * 		   		-  the threshold_up is the value without laser
- * 		   		-  the treshold_down is the value with laser
- * 		   		-  the final threshold is the mean of the above values
+ * @note   The threshold is kept: it is set before by set_threshold(), by start_threshold() and
+ * 		   complete_threshold(), or by restore_threshold().
  */
 void init_module_barrier(module_barrier_t *module_barrier,module_state_t state, photoresistor_t *photoresistor, laser_t *laser, uint8_t delay, uint16_t pulse, uint32_t stable_signal){
 
@@ -45,8 +43,6 @@ void init_module_barrier(module_barrier_t *module_barrier,module_state_t state,
 
 	module_barrier->delay = delay;
 
-	set_threshold(module_barrier);
-
 	module_barrier->stable_signal = stable_signal;
 
 	if(state == SENSOR_INACTIVE)
@@ -63,15 +59,61 @@ void init_module_barrier(module_barrier_t *module_barrier,module_state_t state,
  */
 void set_threshold(module_barrier_t *module_barrier){
 
+	start_threshold(module_barrier);
+
+	HAL_Delay(BARRIER_CALIBRATION_TIME);
+
+	complete_threshold(module_barrier);
+}
+
+/**
+ * @brief  Start the threshold calibration
+ * @param  module_barrier  pointer to module barrier structure, with its photoresistor and laser
+ * @note   It reads the threshold_up and switches the laser on, then it returns: the laser must be on for
+ * 		   BARRIER_CALIBRATION_TIME before the threshold_down reading of complete_threshold().
+ */
+void start_threshold(module_barrier_t *module_barrier){
+
 	module_barrier->threshold_up = read_value(module_barrier->photoresistor); //threshold without laser
 
 	set_laser(module_barrier->laser);
 
-	HAL_Delay(1000);
+	module_barrier->calibration_start = HAL_GetTick();
+}
+
+/**
+ * @brief  Complete the threshold calibration started by start_threshold()
+ * @param  module_barrier  pointer to module barrier structure
+ * @return BARRIER_CALIBRATION_PENDING until the laser has been on for BARRIER_CALIBRATION_TIME, then BARRIER_CALIBRATION_DONE
+ * @note   The laser is left on, init_module_barrier() switches it off for an inactive barrier.
+ */
+int8_t complete_threshold(module_barrier_t *module_barrier){
+
+	if(HAL_GetTick() - module_barrier->calibration_start < BARRIER_CALIBRATION_TIME){
+		return BARRIER_CALIBRATION_PENDING;
+	}
 
 	module_barrier->threshold_down = read_value(module_barrier->photoresistor); //threshold with laser
 
 	module_barrier->threshold = (module_barrier->threshold_down + module_barrier->threshold_up)/2;
+
+	return BARRIER_CALIBRATION_DONE;
+}
+
+/**
+ * @brief  Restore a threshold measured at a previous boot
+ * @param  module_barrier  pointer to module barrier structure
+ * @param  threshold_up	   value without laser
+ * @param  threshold_down  value with laser
+ * @note   It skips the measure of set_threshold(), which keeps the laser on for a second.
+ */
+void restore_threshold(module_barrier_t *module_barrier, uint16_t threshold_up, uint16_t threshold_down){
+
+	module_barrier->threshold_up = threshold_up;
+
+	module_barrier->threshold_down = threshold_down;
+
+	module_barrier->threshold = (threshold_down + threshold_up)/2;
 }
 
 /**
@@ -131,8 +173,11 @@ void stop_barrier_sensor(module_barrier_t *barrier){
  * @param  hadc adc handler
  * @note   Read the raw value and compare it with the threshold.
  * 		   Increment the counter if the rawvalue is over the threshold:
- * 		   	 -	if the number are over the stability value (stable_signal), it starts the alarm
+ * 		   	 -	if the number are over the stability value (stable_signal), it posts the crossing and stops the
+ * 		   	 	conversions, the alarm starts from the alarm task; if the post fails the conversions go on and
+ * 		   	 	the next one posts again, so the barrier is never left stopped without its event
  * 		   	 -  else it resets the counter
+ * 		   The conversion is also passed to the telemetry, which streams it only if started.
  */
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc){
 
@@ -142,15 +187,16 @@ void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc){
 		rawValue = HAL_ADC_GetValue(&hadc1);;
 		if((rawValue > system.barrier->threshold) && get_state_barrier(system.barrier) != SENSOR_ALARMED){
 			counter+=1;
-			if(counter > system.barrier->stable_signal){ // check the barrier signal stability:
+			if(counter > system.barrier->stable_signal && post_system_event(EVENT_BARRIER_CROSSED, rawValue) == SYS_OK){ // alarm barrier sensor
 				counter = 0;
 				stop_read_value_IT(system.barrier->photoresistor);
-				alarm_barrier(system.barrier); // alarm barrier sensor
-
 			}
 		}else if(counter != 0){
 			counter = 0;
 		}
+		if(system.telemetry != NULL){
+			telemetry_sample(system.telemetry, rawValue, counter);
+		}
 
 	}
 
@@ -16,6 +16,15 @@
 #include "keypad_handler.h"
 #include "uart_handler.h"
 #include "string.h"
+#include "critical_section.h"
+#include "boot_pipeline.h"
+#include "event_queue.h"
+#include "kernel.h"
+
+/**
+ * @brief Size of the buffer for the boot time breakdown
+ */
+#define BOOT_MSG_SIZE (384)
 
 /**
  * @brief String for wrong configuration
@@ -37,6 +46,13 @@
  */
 #define COMMAND_REJECTED_MESSAGE ("COMMAND REJECTED\n\r")
 
+/**
+ * @brief Strings for the alarm notifications
+ */
+#define ALARM_AREA_MESSAGE ("\n\rALARM: AREA\n\r")
+#define ALARM_BARRIER_MESSAGE ("\n\rALARM: BARRIER\n\r")
+#define ALARM_BOTH_MESSAGE ("\n\rALARM: AREA - BARRIER\n\r")
+
 /**
  * @brief Length of wrong user pin message
  */
@@ -72,6 +88,21 @@
  */
 #define LASER_PIN (GPIO_PIN_1)
 
+/**
+ * @brief GPIO Pin of the rtc square wave, on port C
+ */
+#define RTC_SQW_PIN (GPIO_PIN_8)
+
+/**
+ * @brief GPIO Pin of the console reception, on port A: its falling edge wakes the core from the stop mode
+ */
+#define CONSOLE_RX_PIN (GPIO_PIN_3)
+
+/**
+ * @brief ms of console silence before the stop mode: a console session keeps the core running
+ */
+#define CONSOLE_QUIET (30000)
+
 /**
  * @brief minimum time value in milliseconds for the pir signal stability
  */
@@ -122,11 +153,69 @@ buzzer_t buzzer;
  */
 uart_handler_t uart_handler;
 
+/**
+ * @brief Global i2c bus variable
+ */
+i2c_bus_t i2c_bus;
+
 /**
  * @brief Global rtc variable
  */
 rtc_t rtc;
 
+/**
+ * @brief Global config store variable
+ */
+config_store_t config_store;
+
+/**
+ * @brief Global idle meter variable
+ */
+idle_meter_t idle_meter;
+
+/**
+ * @brief Global event queue variable: the interrupts post, the alarm task dispatches
+ */
+event_queue_t event_queue;
+
+/**
+ * @brief Global kernel variable
+ */
+kernel_t kernel;
+
+/**
+ * @brief Global tickless variable: the stop mode of the background task idle time
+ */
+tickless_t tickless;
+
+/**
+ * @brief Alarm task and its stack
+ */
+kernel_task_t alarm_task;
+uint32_t alarm_stack[ALARM_STACK_WORDS];
+
+/**
+ * @brief Background task and its stack
+ */
+kernel_task_t background_task;
+uint32_t background_stack[BACKGROUND_STACK_WORDS];
+
+/**
+ * @brief Given by each posted event, it wakes the alarm task
+ */
+kernel_semaphore_t event_semaphore;
+
+/**
+ * @brief Held by the alarm task while it dispatches and by the commands while they change the system state
+ */
+kernel_semaphore_t system_lock;
+
+/**
+ * @brief Keypad buttons, sent by the EXTI interrupt to the background task
+ */
+kernel_queue_t keypad_queue;
+KEYPAD_button_t keypad_buffer[KEYPAD_QUEUE_SIZE];
+
 /**
  * @brief Global system log variable
  */
@@ -134,6 +223,7 @@ system_log_t system_log;
 
 /**
  * @brief Global system configuration variable
+ * @note  Copy of the newest record of the config store, rebuilt by the protocol only if there is none
  */
 system_configuration_t configuration;
 
@@ -142,22 +232,335 @@ system_configuration_t configuration;
  */
 configuration_protocol_t protocol;
 
+/**
+ * @brief Global console variable
+ */
+console_t console;
+
+/**
+ * @brief Global barrier telemetry variable
+ */
+telemetry_t telemetry;
+
+/**
+ * @brief Global system clock variable
+ */
+system_clock_t system_clock;
+
+/**
+ * @brief Global timer wheel variable, advanced by the HAL tick
+ */
+timer_wheel_t timer_wheel;
+
+/**
+ * @brief Alarm timers: the delay of each sensor and the alarm duration
+ */
+virtual_timer_t pir_delay_timer;
+virtual_timer_t barrier_delay_timer;
+virtual_timer_t duration_timer;
+
+/**
+ * @brief Callbacks of the alarm timers
+ */
+static void pir_delay_elapsed();
+static void barrier_delay_elapsed();
+static void duration_elapsed();
+
+/**
+ * @brief Handlers of the alarm timer events
+ */
+static void pir_delay_alarm();
+static void barrier_delay_alarm();
+static void duration_dealarm();
+
+/**
+ * @brief Dispatcher of the events posted by the interrupts
+ */
+static void dispatch_system_events();
+
+/**
+ * @brief Handler of the keypad buttons
+ */
+static void keypad_button(KEYPAD_button_t button);
+
+/**
+ * @brief Bodies of the tasks
+ */
+static void alarm_task_entry();
+static void background_task_entry();
+
 /**
  * @brief Global cnt variable: #inserted character in command buffer
  */
 uint8_t cnt=0;
 
+/**
+ * @brief  Advance the log timebase at each second of the internal rtc
+ * @note   Called by the wakeup interrupt, it replaces the square wave of the DS1307.
+ */
+static void clock_second(){
+
+	if(system.system_log != NULL)
+		system_log_second(system.system_log);
+
+}
+
+/**
+ * @brief Boot stages, by their index into boot_stages
+ */
+typedef enum{
+	BOOT_OSCILLATOR,
+	BOOT_RTC,
+	BOOT_CONFIGURATION,
+	BOOT_HANDSHAKE,
+	BOOT_CALIBRATION,
+	BOOT_ELEMENTS,
+	BOOT_PROTOCOL,
+	BOOT_SENSORS,
+	BOOT_ARMED,
+	BOOT_CLOCK
+} boot_stage_id_t;
+
+/**
+ * @brief Global boot pipeline variable
+ */
+boot_pipeline_t boot_pipeline;
+
+/**
+ * @brief Buffer for the boot time breakdown, sent once at the end of the boot
+ */
+char boot_msg[BOOT_MSG_SIZE];
+
+/**
+ * @brief Console baud rate read by the configuration stage
+ */
+uint32_t boot_baud_rate = UART_DEFAULT_BAUD_RATE;
+
+/**
+ * @brief Result of the DS1307 probe of the rtc stage
+ */
+int8_t rtc_status = DS1307_ERR;
+
+/**
+ * @brief  Oscillator stage: switch the crystal on, its startup overlaps the other stages
+ * @return stage result
+ */
+static int8_t boot_oscillator_start(){
+
+	system_clock_start_oscillator(&system_clock);
+
+	return BOOT_STAGE_PENDING;
+}
+
+/**
+ * @brief  Oscillator stage: wait the crystal startup, or its timeout for a board without it
+ * @return stage result
+ */
+static int8_t boot_oscillator_poll(){
+
+	return system_clock_oscillator_settled(&system_clock) ? BOOT_STAGE_DONE : BOOT_STAGE_PENDING;
+}
+
+/**
+ * @brief  Rtc stage: probe the DS1307
+ * @return stage result
+ * @note   A missing rtc is reported by the elements stage, after the handshake.
+ */
+static int8_t boot_rtc_start(){
+
+	init_i2c_bus(&i2c_bus, &hi2c1); // initialize i2c bus;
+
+	system.i2c_bus = &i2c_bus;
+
+	rtc_status = ds1307rtc_init(&rtc, &i2c_bus);
+
+	return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief  Configuration stage: read the newest record of the config store and its console baud rate
+ * @return stage result
+ */
+static int8_t boot_configuration_start(){
+
+	load_configuration();
+
+	boot_baud_rate = load_baud_rate();
+
+	return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief  Handshake stage: one attempt of the boot handshake
+ * @return stage result
+ * @note   Each attempt waits START for a while, the other stages are polled between two attempts.
+ */
+static int8_t boot_handshake_poll(){
+
+	return check_putty(boot_baud_rate) == 0 ? BOOT_STAGE_DONE : BOOT_STAGE_PENDING;
+}
+
+/**
+ * @brief  Handshake stage: a saved configuration boots without waiting for START
+ * @return stage result
+ */
+static int8_t boot_handshake_start(){
+
+	if(!config_store.loaded){
+		return boot_handshake_poll();
+	}
+
+	if(huart2.Init.BaudRate != boot_baud_rate){
+		huart2.Init.BaudRate = boot_baud_rate;
+		HAL_UART_Init(&huart2);
+	}
+
+	return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief  Calibration stage: restore the saved barrier threshold, or start its measure
+ * @return stage result
+ * @note   The measure keeps the laser on for BARRIER_CALIBRATION_TIME: the configuration protocol, which
+ * 		   waits for the user, runs meanwhile instead of after it.
+ */
+static int8_t boot_calibration_start(){
+
+	init_laser(&laser, LASER_PORT, LASER_PIN, GPIO_PIN_RESET);
+	init_photoresistor(&photoresistor, &hadc1);
+
+	barrier.laser = &laser;
+	barrier.photoresistor = &photoresistor;
+
+	if(config_store.loaded){ // measured at a previous boot, saved with the configuration
+		restore_threshold(&barrier, config_store.threshold_up, config_store.threshold_down);
+		return BOOT_STAGE_DONE;
+	}
+
+	start_threshold(&barrier);
+
+	return BOOT_STAGE_PENDING;
+}
+
+/**
+ * @brief  Calibration stage: read the threshold with the laser, once it has been on long enough
+ * @return stage result
+ */
+static int8_t boot_calibration_poll(){
+
+	return complete_threshold(&barrier) == BARRIER_CALIBRATION_DONE ? BOOT_STAGE_DONE : BOOT_STAGE_PENDING;
+}
+
+/**
+ * @brief  Elements stage: initialize all the support elements
+ * @return stage result
+ */
+static int8_t boot_elements_start(){
+
+	return init_elements() == SYS_OK ? BOOT_STAGE_DONE : BOOT_STAGE_ERR;
+}
+
+/**
+ * @brief  Protocol stage: configure the protocol, unless a configuration has been loaded from the flash
+ * @return stage result
+ * @note   The protocol waits for the user with its own loop, the laser of the calibration stays on meanwhile.
+ */
+static int8_t boot_protocol_start(){
+
+	if(config_store.loaded){ // saved at a previous boot, the protocol is skipped
+		system_log_send_message(&system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)SYSTEM_BOOT, strlen(SYSTEM_BOOT));
+		system_log_send_message(&system_log, UART_CHANNEL_FEEDBACK, (uint8_t *)STORED_CONFIGURATION_LOADED, strlen(STORED_CONFIGURATION_LOADED));
+	}else{
+		configuration_protocol(&protocol); // start configuration protocol
+	}
+
+	system.system_configuration = &configuration; // assign the configuration produced
+
+	return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief  Sensors stage: initialize all the sensors, then save a configuration accepted by the protocol
+ * @return stage result
+ */
+static int8_t boot_sensors_start(){
+
+	init_sensor(&pir, &sensor_pir, &barrier, &laser, &photoresistor, &buzzer); // initilize all the sensors
+
+	system.pir = &pir;
+	system.buzzer = &buzzer;
+	system.barrier = &barrier;
+
+	if(!config_store.loaded && protocol.state == END_CUSTOM){ // the default configuration is not saved, so the next boot asks again
+		config_store_save(&config_store, &configuration, barrier.threshold_up, barrier.threshold_down);
+	}
+
+	return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief  Armed stage: the keypad and the console accept the commands, the sensors can be activated
+ * @return stage result
+ */
+static int8_t boot_armed_start(){
+
+	run_system();
+
+	return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief  Clock stage: start the internal rtc and reconcile it with the DS1307
+ * @return stage result
+ * @note   It follows the crystal startup, so a cold crystal delays the timestamps of the log, not the armed
+ * 		   system; and the protocol, which can set the date time of the DS1307.
+ */
+static int8_t boot_clock_start(){
+
+	if(init_system_clock(&system_clock, &rtc) == SYSTEM_CLOCK_OK){ // the internal rtc keeps the time, the DS1307 is its backup
+		ds1307rtc_set_square_wave(&rtc, 0);
+	}else{
+		ds1307rtc_set_square_wave(&rtc, 1); // its 1 Hz edges advance the log timebase, without it the rtc is read for each record
+	}
+
+	system_clock_reconcile(&system_clock);
+
+	system_clock_start_seconds(&system_clock, clock_second);
+
+	return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief Boot stages: each one starts as soon as the stages it depends on are done
+ */
+const boot_stage_t boot_stages[] = {
+	{"OSCILLATOR", 0, boot_oscillator_start, boot_oscillator_poll},
+	{"RTC", 0, boot_rtc_start, NULL},
+	{"CONFIGURATION", 0, boot_configuration_start, NULL},
+	{"HANDSHAKE", BOOT_STAGE(BOOT_RTC) | BOOT_STAGE(BOOT_CONFIGURATION), boot_handshake_start, boot_handshake_poll},
+	{"CALIBRATION", BOOT_STAGE(BOOT_HANDSHAKE), boot_calibration_start, boot_calibration_poll},
+	{"ELEMENTS", BOOT_STAGE(BOOT_HANDSHAKE), boot_elements_start, NULL},
+	{"PROTOCOL", BOOT_STAGE(BOOT_ELEMENTS), boot_protocol_start, NULL},
+	{"SENSORS", BOOT_STAGE(BOOT_PROTOCOL) | BOOT_STAGE(BOOT_CALIBRATION), boot_sensors_start, NULL},
+	{"ARMED", BOOT_STAGE(BOOT_SENSORS), boot_armed_start, NULL},
+	{"CLOCK", BOOT_STAGE(BOOT_OSCILLATOR) | BOOT_STAGE(BOOT_ARMED), boot_clock_start, NULL},
+};
+
 /**
  * @brief  Initialize the system
- * @return operation result
  * @note   It is called by the main at the start of the system
  * 				-  set system state to SYSTEM_INACTIVE,
  * 		   		-  turn on the system led,
- * 		   		-  initialize all the support elements (uart, rtc, system log, protocol),
- * 		   		-  configure the protocol,
- * 		   		-  initialize all the sensor (pir, barrier, laser, photoresistor, buzzer)
+ * 		   		-  prepare the boot stages, run by process_system():
+ * 		   			-  switch the crystal on, probe the rtc and read the saved configuration,
+ * 		   			-  wait START, unless a configuration has been loaded from the flash,
+ * 		   			-  calibrate the barrier, or restore its saved calibration,
+ * 		   			-  initialize all the support elements (uart, system log, protocol, console, telemetry),
+ * 		   			-  configure the protocol, unless a configuration has been loaded from the flash,
+ * 		   			-  initialize all the sensor (pir, barrier, buzzer) and save the configuration,
+ * 		   			-  run the system, then start the internal rtc once the crystal is ready
  */
-int8_t init_system(){
+void init_system(){
 
 	system.state = SYSTEM_INACTIVE;
 
@@ -166,29 +569,34 @@ int8_t init_system(){
 	HAL_NVIC_DisableIRQ(EXTI9_5_IRQn);
 	HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
 
-	if(init_elements() == SYS_OK){ // initialize all the support elements
+	init_event_queue(&event_queue); // before the interrupts that post
 
-		configuration_protocol(&protocol); // start configuration protocol
+	system.event_queue = &event_queue;
 
-		system.system_configuration = &configuration; // assign the configuration produced
+	init_kernel(&kernel);
+	init_kernel_semaphore(&event_semaphore, 0, 1);
+	init_kernel_semaphore(&system_lock, 1, 1);
+	init_kernel_queue(&keypad_queue, keypad_buffer, sizeof(KEYPAD_button_t), KEYPAD_QUEUE_SIZE);
+	kernel_add_task(&kernel, &alarm_task, "ALARM", ALARM_TASK_PRIORITY, alarm_task_entry, alarm_stack, ALARM_STACK_WORDS);
+	kernel_add_task(&kernel, &background_task, "BACKGROUND", BACKGROUND_TASK_PRIORITY, background_task_entry, background_stack, BACKGROUND_STACK_WORDS);
 
-		init_sensor(&pir, &sensor_pir, &barrier, &laser, &photoresistor, &buzzer); // initilize all the sensors
+	system.kernel = &kernel;
 
-		system.pir = &pir;
-		system.buzzer = &buzzer;
-		system.barrier = &barrier;
+	init_timer_wheel(&timer_wheel); // the virtual timers of the protocol, of the log and of the alarm
+	init_virtual_timer(&pir_delay_timer, pir_delay_elapsed);
+	init_virtual_timer(&barrier_delay_timer, barrier_delay_elapsed);
+	init_virtual_timer(&duration_timer, duration_elapsed);
 
-		return SYS_OK; // return System OK
-	}else
-		return SYS_ERR; // return System error
+	init_boot_pipeline(&boot_pipeline, boot_stages, sizeof(boot_stages) / sizeof(boot_stages[0]));
 
 }
 
 /**
  * @brief Run the system
- * @note  It is called by the main at the end of initialization
+ * @note  It is called by the armed boot stage, once the sensors are initialized
  * 			 -  initialize the keypad,
- * 			 -  start the system log
+ * 			 -  start the system log,
+ * 			 -  start the serial console
  */
 void run_system(){
 
@@ -197,37 +605,327 @@ void run_system(){
 
 	KEYPAD_init();
 	start_system_log(&system_log);
+	start_console(&console);
+
+}
+
+/**
+ * @brief  Run the boot stages
+ * @note   Called by process_system() until the boot is finished, then the start and the length of each stage
+ * 		   are queued on the diagnostic channel; a failed boot queues them after its error message.
+ */
+static void process_boot(){
+
+	if(boot_pipeline_process(&boot_pipeline) != BOOT_RUNNING){
+		uart_handler_enqueue_message(&uart_handler, UART_CHANNEL_DIAGNOSTIC, (uint8_t *)boot_msg, boot_pipeline_format(&boot_pipeline, boot_msg, BOOT_MSG_SIZE));
+	}
+
+}
+
+/**
+ * @brief Process the deferred work of the system
+ * @note  It is called by the background task: it runs the boot stages, executes the keypad commands, supervises the i2c bus,
+ * 		  formats and sends the log records pushed by the interrupts and the barrier telemetry, then it applies the baud rate changes
+ * 		  requested by the console.
+ */
+void process_system(){
+
+	KEYPAD_button_t button;
+
+	if(boot_pipeline.state == BOOT_RUNNING){
+		process_boot();
+	}
+
+	while(kernel_queue_receive(&kernel, &keypad_queue, &button, 0) == KERNEL_OK){
+		keypad_button(button);
+	}
+
+	if(system.i2c_bus != NULL){
+		i2c_bus_process(system.i2c_bus);
+	}
+
+	if(system.system_log != NULL && system.system_log->state == START_L){
+		system_log_process(system.system_log);
+	}
+
+	if(system.telemetry != NULL){
+		telemetry_process(system.telemetry);
+	}
+
+	if(system.uart != NULL){
+		uart_handler_process(system.uart);
+	}
+
+	if(system.console != NULL){
+		console_process(system.console);
+	}
+
+}
+
+/**
+ * @brief  Body of the alarm task
+ * @note   It waits for the events posted by the interrupts and it dispatches them, preempting the background task.
+ */
+static void alarm_task_entry(){
+
+	for(;;){
+
+		kernel_semaphore_take(&kernel, &event_semaphore, KERNEL_WAIT_FOREVER);
+
+		kernel_semaphore_take(&kernel, &system_lock, KERNEL_WAIT_FOREVER); // a command is changing the system state
+		dispatch_system_events();
+		kernel_semaphore_give(&kernel, &system_lock);
+
+	}
+
+}
+
+/**
+ * @brief  Body of the background task
+ * @note   The old main loop: it processes the deferred work, then it sleeps until an interrupt brings new work.
+ */
+static void background_task_entry(){
+
+	for(;;){
+
+		process_system();
+		system_idle();
+
+	}
+
+}
+
+/**
+ * @brief  Start the tasks of the system
+ * @note   It is called by the main after init_system(), it never returns: the alarm task runs first and waits
+ * 		   for the first event, then the background task starts the boot stages.
+ */
+void start_system_tasks(){
+
+	kernel_start(&kernel);
+
+}
+
+/**
+ * @brief  Compensate the led blink for the ms spent in stop mode
+ * @param  elapsed	ms spent in stop mode
+ * @note   Called by tickless_stop(): TIM2 counts the ms of the blink and it stops with the core, so its counter is
+ * 		   advanced and the led is toggled once for each update lost.
+ */
+static void compensate_blink(uint32_t elapsed){
+
+	uint32_t period, count;
+
+	if(!(htim2.Instance->CR1 & TIM_CR1_CEN)){
+		return;
+	}
+
+	period = __HAL_TIM_GET_AUTORELOAD(&htim2) + 1;
+	count = __HAL_TIM_GET_COUNTER(&htim2) + elapsed;
+
+	if((count / period) % 2 == 1 && system.state == SYSTEM_ACTIVE){
+		toggle_system_led();
+	}
+
+	__HAL_TIM_SET_COUNTER(&htim2, count % period);
+
+}
+
+/**
+ * @brief  Compute how long the core can stay in stop mode
+ * @return ms to the first deadline, 0 if the core must keep running
+ * @note   The stop mode stops all the clocks but the rtc one, so it is entered once the boot is finished, while no
+ * 		   alarm sounds, the barrier is inactive, the pir signal is not under its stability check, the uart, the
+ * 		   i2c bus and the telemetry are idle and the console has been quiet for CONSOLE_QUIET ms: the system is
+ * 		   inactive or armed with the pir only. The next toggle of the led blink is a deadline too.
+ */
+static uint32_t stop_deadline(){
+
+	uint32_t deadline, blink;
+
+	if(boot_pipeline.state != BOOT_FINISHED || system.state == SYSTEM_ALARMED || get_state_barrier(system.barrier) != SENSOR_INACTIVE ||
+	   get_state_buzzer(system.buzzer) == BUZZER_ACTIVE || (htim1.Instance->CR1 & TIM_CR1_CEN) || system.telemetry->active ||
+	   !i2c_bus_idle(system.i2c_bus) || !uart_handler_tx_idle(system.uart) || system.uart->pending_baud_rate != 0 ||
+	   HAL_GetTick() - system.uart->rx_tick < CONSOLE_QUIET){
+		return 0;
+	}
+
+	deadline = tickless_deadline(&tickless);
+
+	if(htim2.Instance->CR1 & TIM_CR1_CEN){
+		blink = __HAL_TIM_GET_AUTORELOAD(&htim2) + 1 - __HAL_TIM_GET_COUNTER(&htim2); // ms to the next toggle
+		if(blink < deadline){
+			deadline = blink;
+		}
+	}
+
+	return deadline;
+}
+
+/**
+ * @brief  Start the measure of the idle time and prepare the stop mode
+ * @note   It is called by the main before the first wait, the blocking i2c transfers at boot included.
+ * 		   The pir and the keypad rows interrupt at their edges, so they wake the core from the stop mode; the console
+ * 		   reception line is unmasked only during the stops, it would interrupt at each byte.
+ */
+void init_system_idle(){
+
+	init_idle_meter(&idle_meter);
+
+	system.idle_meter = &idle_meter;
+
+	SYSCFG->EXTICR[0] = (SYSCFG->EXTICR[0] & ~SYSCFG_EXTICR1_EXTI3) | SYSCFG_EXTICR1_EXTI3_PA;
+	EXTI->FTSR |= CONSOLE_RX_PIN; // the start bit
+	HAL_NVIC_SetPriority(EXTI3_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+
+	init_tickless(&tickless, &system_clock, &timer_wheel, &kernel, CONSOLE_RX_PIN, compensate_blink);
+
+	system.tickless = &tickless;
 
 }
 
+/**
+ * @brief  Sleep until the next interrupt
+ * @note   The waits of the background task, of the configuration protocol and of the blocking transfers end with an
+ * 		   interrupt, the HAL tick included, so the core sleeps instead of polling their state.
+ * 		   A wait of the alarm task sleeps for a tick instead, so the background task can run meanwhile.
+ * 		   When the background task waits and no peripheral needs the clocks, the core stops with the tick until the
+ * 		   first deadline of the timers, or until a sensor, the keypad or the console wakes it.
+ */
+void system_idle(){
+
+	uint32_t primask;
+	uint8_t stopped;
+
+	if(kernel_current(&kernel) == &alarm_task){
+		kernel_sleep(&kernel, 1);
+		return;
+	}
+
+	primask = critical_section_enter();
+	stopped = (tickless_stop(&tickless, stop_deadline()) == TICKLESS_OK);
+	tickless_wake_end(&tickless);
+	critical_section_exit(primask); // the interrupt that has ended the stop runs here
+
+	if(!stopped){
+		idle_meter_sleep(&idle_meter);
+	}
+
+}
+
+/**
+ * @brief  Redefinition of the HAL delay
+ * @param  Delay	delay in ms
+ * @note   Same timing of the HAL one, it sleeps between the ticks.
+ */
+void HAL_Delay(uint32_t Delay){
+
+	uint32_t start = HAL_GetTick();
+	uint32_t wait = Delay;
+
+	if(wait < HAL_MAX_DELAY){
+		wait += (uint32_t)uwTickFreq; // at least one full tick
+	}
+
+	while(HAL_GetTick() - start < wait){
+		system_idle();
+	}
+
+}
+
+/**
+ * @brief  Read the console baud rate saved into the flash
+ * @return saved baud rate, UART_DEFAULT_BAUD_RATE if the newest record does not hold a valid one
+ * @note   It is called by the configuration boot stage, after the config store is initialized, before the boot
+ * 		   handshake. The baud rate is kept by the cleared records too.
+ */
+uint32_t load_baud_rate(){
+
+	if(config_store.baud_index >= UART_BAUD_RATES){
+		return UART_DEFAULT_BAUD_RATE;
+	}
+
+	return uart_baud_rates[config_store.baud_index];
+}
+
+/**
+ * @brief  Save the console baud rate into the flash
+ * @param  baud_rate	one of the supported baud rates
+ * @return operation result
+ * @note   It appends a record, so it must be called from the main loop.
+ */
+int8_t store_baud_rate(uint32_t baud_rate){
+
+	int8_t index = uart_handler_baud_rate_index(baud_rate);
+
+	if(index < 0 || config_store_save_baud_rate(&config_store, index) != CONFIG_STORE_OK){
+		return SYS_ERR;
+	}
+
+	return SYS_OK;
+}
+
+/**
+ * @brief  Load the configuration saved into the flash
+ * @return SYS_OK if a valid configuration has been loaded
+ * @note   It is called by the configuration boot stage. Only the newest record, with the barrier
+ * 		   calibration, is read: when it is valid the boot handshake and the configuration protocol are skipped.
+ */
+int8_t load_configuration(){
+
+	init_config_store(&config_store);
+
+	system.config_store = &config_store;
+
+	if(config_store_load(&config_store, &configuration) != CONFIG_STORE_OK){ // nothing saved, or cleared
+		return SYS_ERR;
+	}
+
+	return SYS_OK;
+}
+
 /**
  * @brief  Initialize all the support elements
  * @return operation result
- * @note   It is called by init_system(). It initializes:
+ * @note   It is called by the elements boot stage, after the rtc probe and the handshake. It initializes:
  * 				-  uart handler,
- * 				-  rtc,
  * 				-  system log,
- * 				-  protocol
+ * 				-  protocol,
+ * 				-  console,
+ * 				-  telemetry
  */
 int8_t init_elements(){
 
 	uart_handler_init(&uart_handler, &huart2); // initialize uart_handler;
 
-	if(ds1307rtc_init(&rtc, &hi2c1) != DS1307_ERR){// initialize rtc;
+	if(rtc_status != DS1307_ERR){// rtc probed by the rtc boot stage
+
+		init_system_log(&system_log, &rtc, &uart_handler, &timer_wheel); // initialize system_log module;
 
-		init_system_log(&system_log, &rtc, &uart_handler, &htim10); // initialize system_log module;
+		init_protocol(&protocol, &configuration, &timer_wheel, &rtc); // initialize configuration protocol module;
 
-		init_protocol(&protocol, &configuration, &htim10, &rtc); // initialize configuration protocol module;
+		init_console(&console, &system_log, &kernel); // initialize serial console;
+
+		init_telemetry(&telemetry, &uart_handler); // initialize barrier telemetry;
 
 		system.rtc = &rtc;
 
+		system.uart = &uart_handler;
+
 		system.system_log = &system_log;
 
 		system.protocol = &protocol;
 
+		system.console = &console;
+
+		system.telemetry = &telemetry;
+
+		system.clock = &system_clock;
+
 		return SYS_OK;
 	}else{
-		uart_handler_send_message(&uart_handler, (uint8_t *)INITIALIZATION_ERROR, strlen(INITIALIZATION_ERROR));
+		uart_handler_enqueue_message(&uart_handler, UART_CHANNEL_DIAGNOSTIC, (uint8_t *)INITIALIZATION_ERROR, strlen(INITIALIZATION_ERROR));
 		return SYS_ERR;
 	}
 
@@ -242,21 +940,17 @@ int8_t init_elements(){
  * @param  laser			pointer to laser structure
  * @param  photoresistor	pointer to photoresistor structure
  * @param  buzzer			pointer to buzzer structure
- * @note   It is called by init_system(). It initializes:
+ * @note   It is called by the sensors boot stage. It initializes:
  * 				-  pir
  * 				-  buzzer
- * 				-  laser
- * 				-  photoresistor
- * 				-  barrier
+ * 				-  barrier, whose laser, photoresistor and threshold are set by the calibration stage
  */
 void init_sensor(module_pir_t *pir, digital_sensor_t* sensor_pir,module_barrier_t *barrier, laser_t *laser, photoresistor_t *photoresistor, buzzer_t *buzzer){
 
 	GPIO_PinState pir_state = HAL_GPIO_ReadPin(PIR_SENSOR_PORT, PIR_SENSOR_PIN); // read the sensor state
 	init_pir(pir, sensor_pir, pir_state, PIR_SENSOR_PORT, PIR_SENSOR_PIN, SENSOR_INACTIVE, system.system_configuration->sensor_delay_1, &htim1, PIR_PULSE);
 	init_buzzer(buzzer, BUZZER_INACTIVE, &htim3);
-	init_laser(laser, LASER_PORT, LASER_PIN, GPIO_PIN_RESET);
-	init_photoresistor(photoresistor, &hadc1);
-	init_module_barrier(barrier, SENSOR_INACTIVE, photoresistor, laser, system.system_configuration->sensor_delay_2, BARRIER_PULSE, SIGNAL_STABILITY_B);
+	init_module_barrier(barrier, SENSOR_INACTIVE, photoresistor, laser, system.system_configuration->sensor_delay_2, BARRIER_PULSE, SIGNAL_STABILITY_B); // switches the laser off
 
 }
 
@@ -294,6 +988,90 @@ int8_t deactivate_system(system_t *system){
 	return COMMAND_ERROR;
 }
 
+/**
+ * @brief  Send the alarm notification corresponding to the given pulse
+ * @param  pulse    pulse value of the alarmed module
+ * @note   The notification is queued on the alarm channel, so it precedes any pending status or diagnostic message
+ */
+static void send_alarm_message(uint16_t pulse){
+
+	char *message = ALARM_BOTH_MESSAGE;
+
+	if(pulse == PIR_PULSE){
+		message = ALARM_AREA_MESSAGE;
+	}else if(pulse == BARRIER_PULSE){
+		message = ALARM_BARRIER_MESSAGE;
+	}
+
+	system_log_send_message(system.system_log, UART_CHANNEL_ALARM, (uint8_t *)message, strlen(message));
+
+}
+
+/**
+ * @brief  Post the end of the pir delay
+ * @note   Called by the pir delay timer, from the tick interrupt.
+ */
+static void pir_delay_elapsed(){
+
+	post_system_event(EVENT_PIR_DELAY, 0);
+
+}
+
+/**
+ * @brief  Post the end of the barrier delay
+ * @note   Called by the barrier delay timer, from the tick interrupt.
+ */
+static void barrier_delay_elapsed(){
+
+	post_system_event(EVENT_BARRIER_DELAY, 0);
+
+}
+
+/**
+ * @brief  Post the end of the alarm duration
+ * @note   Called by the duration timer, from the tick interrupt.
+ */
+static void duration_elapsed(){
+
+	post_system_event(EVENT_ALARM_DURATION, 0);
+
+}
+
+/**
+ * @brief  Alarm the system at the end of the pir delay
+ * @note   Dispatched after the pir delay timer, or called at once by a pir without delay. A timer restarted
+ * 		   since its expiry makes the event stale. A barrier already alarmed makes it an alarm of both the sensors.
+ */
+static void pir_delay_alarm(){
+
+	if(get_state_pir(system.pir) == SENSOR_ALARMED && !timer_wheel_is_running(&pir_delay_timer))
+		alarm_system(&system, get_state_barrier(system.barrier) == SENSOR_ALARMED ? BOTH_PULSE : system.pir->pulse);
+
+}
+
+/**
+ * @brief  Alarm the system at the end of the barrier delay
+ * @note   Dispatched after the barrier delay timer, or called at once by a barrier without delay. A timer restarted
+ * 		   since its expiry makes the event stale. A pir already alarmed makes it an alarm of both the sensors.
+ */
+static void barrier_delay_alarm(){
+
+	if(get_state_barrier(system.barrier) == SENSOR_ALARMED && !timer_wheel_is_running(&barrier_delay_timer))
+		alarm_system(&system, get_state_pir(system.pir) == SENSOR_ALARMED ? BOTH_PULSE : system.barrier->pulse);
+
+}
+
+/**
+ * @brief  Stop the alarm at the end of its duration
+ * @note   Dispatched after the duration timer, a duration restarted since its expiry makes the event stale.
+ */
+static void duration_dealarm(){
+
+	if(system.state == SYSTEM_ALARMED && !timer_wheel_is_running(&duration_timer))
+		dealarm_system(&system); // call dealarm procedure
+
+}
+
 /**
  * @brief  Alarm the system
  * @param  system	pointer to system structure
@@ -308,30 +1086,33 @@ void alarm_system(system_t *system, uint16_t pulse){
 	if(system->state == SYSTEM_ACTIVE){ // the system is not emitting any sound and the delay time is elapsed.
 		// the system sets the duration timer, when its state is ACTIVE.
 		system->state = SYSTEM_ALARMED;
-		reset_timer_counter(&htim11);
-		set_timer_period(&htim11, (system->system_configuration->duration *1000)-1); // duration time
-		start_timer_IT(&htim11);
+		timer_wheel_start(&timer_wheel, &duration_timer, system->system_configuration->duration * 1000, 0); // duration time
 		activate_buzzer(system->buzzer, pulse);
+		send_alarm_message(pulse);
 
 	} // the function is called by another module, while the system is emitting the alarm for the other one.
 	else if(system->state == SYSTEM_ALARMED && pulse == BOTH_PULSE){ // the system is emitting the sound for one of the two modules
 
-		reset_timer_counter(&htim11); // reset duration timer
-		set_timer_period(&htim11, (system->system_configuration->duration *1000)-1); // set duration period
-		start_timer_IT(&htim11); // restart timer
+		timer_wheel_start(&timer_wheel, &duration_timer, system->system_configuration->duration * 1000, 0); // restart duration timer
 		activate_buzzer(system->buzzer, BOTH_PULSE); // active buzzer with BOTH_PULSE
+		send_alarm_message(BOTH_PULSE);
 
 	}
+
+	system_log_check_state(system->system_log);
 }
 
 /**
  * @brief  Dealarm the system
  * @param  system	pointer to system structure
  * @note   Set the system state in SYSTEM_ACTIVE and deactivate the buzzer.
- * 		   Set SENSOR_ACTIVE state if a module is alarmed.
+ * 		   Set SENSOR_ACTIVE state if a module is alarmed, a delay still running is dropped with its alarm.
  */
 void dealarm_system(system_t *system){
 
+	timer_wheel_stop(&pir_delay_timer);
+	timer_wheel_stop(&barrier_delay_timer);
+
 	deactivate_buzzer(&buzzer); // stop buzzer
 
 	activate_system(system); // set the system state to active
@@ -348,6 +1129,8 @@ void dealarm_system(system_t *system){
 
 	}
 
+	system_log_check_state(system->system_log);
+
 }
 
 
@@ -376,7 +1159,8 @@ int8_t deactivate_module_pir(system_t *system){
 	if(system->state != SYSTEM_INACTIVE){ // the system is ACTIVE or ALARMED
 
 		if(get_state_pir(system->pir) == SENSOR_ALARMED && get_state_barrier(system->barrier) != SENSOR_ALARMED){ // the sensor is waiting for delay or the buzzer is emitting the alarm
-			stop_timer_IT(&htim11); // stop delay/duration timer
+			timer_wheel_stop(&pir_delay_timer); // stop delay timer
+			timer_wheel_stop(&duration_timer); // stop duration timer
 
 			if(get_state_buzzer(system->buzzer) == BUZZER_ACTIVE){
 				deactivate_buzzer(&buzzer); // stop alarm
@@ -405,20 +1189,14 @@ void alarm_pir(module_pir_t *pir){
 
 	set_state_pir(pir, SENSOR_ALARMED);
 
-	if(get_state_barrier(system.barrier) != SENSOR_ALARMED){ // check if the barrier isn't waiting for delay or the barrier alarm isn't been emitting
-		// The barrier is INACTIVE or ACTIVE.
-		// It's possible to command delay timer
-		// set the delay timer or alarm the system if any delay has been set.
-		if(pir->delay > 0){
-			reset_timer_counter(&htim11);
-			set_timer_period(&htim11, (pir->delay * 1000)-1); //delay sensor
-			start_timer_IT(&htim11);
-		}
-		else
-			alarm_system(&system,system.pir->pulse);
-
-	}else if (system.state == SYSTEM_ALARMED) // the alarm is been emitting.
+	if(system.state == SYSTEM_ALARMED) // the barrier alarm is been emitting.
 		alarm_system(&system,BOTH_PULSE);
+	else if(pir->delay > 0) // the pir waits its own delay, also while the barrier waits its one
+		timer_wheel_start(&timer_wheel, &pir_delay_timer, pir->delay * 1000, 0);
+	else
+		pir_delay_alarm();
+
+	system_log_check_state(system.system_log);
 
 }
 
@@ -447,7 +1225,8 @@ int8_t deactivate_module_barrier(system_t *system){
 	if(system->state != SYSTEM_INACTIVE){ // the system is ACTIVE or ALARMED
 
 		if(get_state_barrier(system->barrier) == SENSOR_ALARMED && get_state_pir(system->pir) != SENSOR_ALARMED){ // the sensor is waiting for delay or the buzzer is emitting the alarm
-			stop_timer_IT(&htim11); // stop delay/duration timer
+			timer_wheel_stop(&barrier_delay_timer); // stop delay timer
+			timer_wheel_stop(&duration_timer); // stop duration timer
 			if(get_state_buzzer(system->buzzer) == BUZZER_ACTIVE){
 				deactivate_buzzer(&buzzer); // stop alarm
 			}
@@ -477,21 +1256,14 @@ void alarm_barrier(module_barrier_t *barrier){
 
 	set_state_barrier(barrier, SENSOR_ALARMED);
 
-	if(get_state_pir(system.pir) != SENSOR_ALARMED){ // check if the barrier isn't waiting for delay or the barrier alarm isn't been emitting
-		// The barrier is INACTIVE or ACTIVE.
-		// It's possible to command delay timer
-		// set the delay timer or alarm the system if any delay has been set.
-		if(barrier->delay > 0){
-			reset_timer_counter(&htim11);
-			set_timer_period(&htim11, (barrier->delay * 1000)-1); //delay sensor
-			start_timer_IT(&htim11);
-		}
-		else
-			alarm_system(&system, system.barrier->pulse);
-
-	}
-	else if (system.state == SYSTEM_ALARMED) // the alarm is been emiting.
+	if(system.state == SYSTEM_ALARMED) // the pir alarm is been emitting.
 		alarm_system(&system,BOTH_PULSE);
+	else if(barrier->delay > 0) // the barrier waits its own delay, also while the pir waits its one
+		timer_wheel_start(&timer_wheel, &barrier_delay_timer, barrier->delay * 1000, 0);
+	else
+		barrier_delay_alarm();
+
+	system_log_check_state(system.system_log);
 
 }
 
@@ -506,7 +1278,9 @@ int8_t deactivate_both(system_t *system){
 
 		if(get_state_barrier(system->barrier) == SENSOR_ALARMED || get_state_pir(system->pir) == SENSOR_ALARMED){ //both alarms are alarmed
 
-			stop_timer_IT(&htim11); //stop delay/duration timer
+			timer_wheel_stop(&pir_delay_timer); //stop delay/duration timers
+			timer_wheel_stop(&barrier_delay_timer);
+			timer_wheel_stop(&duration_timer);
 
 			if(get_state_buzzer(system->buzzer) == BUZZER_ACTIVE){
 
@@ -581,69 +1355,267 @@ int8_t execute_command(uint8_t *command){
 	return COMMAND_REJECTED;
 }
 
+/**
+ * @brief   Check the user pin, execute the command and send the feedback
+ * @param   buffer	 pointer to command buffer: '#', user pin and command
+ * @return  command status
+ * @note    It is shared by the keypad and by the serial console: their interrupts queue the buttons and the
+ * 			lines, which the background task executes, so it can wait the system lock.
+ * 			The alarm task is kept out by the system lock while the command changes the system state.
+ * 			An accepted command is notified with a short beep too.
+ */
+int8_t run_user_command(uint8_t *buffer){
+
+	int8_t result;
+
+	if(check_user_pin(buffer) == WRONG_USER_PIN){ // check the inserted pin
+		system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *) WRONG_USER_PIN_MESSAGE, WRONG_USER_PIN_LENGTH);
+		return WRONG_USER_PIN;
+	}
+
+	kernel_semaphore_take(&kernel, &system_lock, KERNEL_WAIT_FOREVER); // the alarm task waits for the end of the command
+
+	result = execute_command(buffer+1+PIN_SIZE);
+
+	if(result != COMMAND_ACCEPTED){
+		system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *) COMMAND_REJECTED_MESSAGE, COMMAND_REJECTED_LENGTH);
+		system_log_check_state(system.system_log); // a rejected command may have been partially executed
+		result = COMMAND_REJECTED;
+	}else{
+		system_log_check_state(system.system_log);
+
+		system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *) COMMAND_ACCEPTED_MESSAGE, COMMAND_ACCEPTED_LENGTH);
+		if(get_state_buzzer(system.buzzer) != BUZZER_ACTIVE){
+			activate_buzzer(system.buzzer, COMMAND_PULSE);
+		}
+	}
+
+	kernel_semaphore_give(&kernel, &system_lock);
+
+	return result;
+}
+
+/**
+ * @brief   Check the user pin and change a field of the configuration in use
+ * @param   buffer	 pointer to the pin buffer: '#' and user pin, as the keypad commands
+ * @param   field	 pointer to the field to change
+ * @param   text	 width characters of the new value
+ * @return  command status
+ * @note    The value is converted into a copy of the configuration, then the copy and the sensor delays are
+ * 			committed with the interrupts disabled: a pir or barrier callback sees either the old or the new
+ * 			values, never a mix. The system and sensor states are not touched, so an active system stays
+ * 			armed; a delay or duration timer already running keeps its period, the new value is used by the
+ * 			next alarm. The caller saves the configuration into the flash from the main loop.
+ */
+int8_t update_configuration(uint8_t *buffer, const config_field_t *field, const uint8_t *text){
+
+	system_configuration_t updated;
+	uint32_t primask;
+
+	if(check_user_pin(buffer) == WRONG_USER_PIN){ // check the inserted pin
+		system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *) WRONG_USER_PIN_MESSAGE, WRONG_USER_PIN_LENGTH);
+		return WRONG_USER_PIN;
+	}
+
+	updated = *system.system_configuration;
+
+	if(config_schema_set(&updated, field, text) != CONFIG_SCHEMA_OK){
+		system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *) COMMAND_REJECTED_MESSAGE, COMMAND_REJECTED_LENGTH);
+		return COMMAND_REJECTED;
+	}
+
+	primask = critical_section_enter();
+	*system.system_configuration = updated;
+	system.pir->delay = updated.sensor_delay_1;
+	system.barrier->delay = updated.sensor_delay_2;
+	critical_section_exit(primask);
+
+	system_log_send_message(system.system_log, UART_CHANNEL_FEEDBACK, (uint8_t *) COMMAND_ACCEPTED_MESSAGE, COMMAND_ACCEPTED_LENGTH);
+	if(get_state_buzzer(system.buzzer) != BUZZER_ACTIVE){
+		activate_buzzer(system.buzzer, COMMAND_PULSE);
+	}
+
+	return COMMAND_ACCEPTED;
+}
+
+/**
+ * @brief   Get the system state and convert it into string
+ * @param   state	 system state
+ * @retval  return the correspondent string
+ */
+char* get_system_state_string(system_state_t state){
+
+	if(state == SYSTEM_ACTIVE){
+		return ACTIVE_STRING;
+	}else if(state == SYSTEM_INACTIVE){
+		return INACTIVE_STRING;
+	}
+
+	return ALLARMED_STRING;
+}
+
+/**
+ * @brief  Post an event to the alarm task
+ * @param  event	event identifier
+ * @param  arg		event argument, sampled by the interrupt
+ * @return operation result, SYS_ERR if the queue is full and the event has been dropped
+ * @note   Called by the interrupts: only the identifier and the argument are copied, the state machine runs
+ * 		   later from dispatch_system_events(), in the alarm task. A full queue drops the event and counts it.
+ * 		   The pir edges are frequent and the next one carries the new level, so they cannot take the reserved
+ * 		   slots; the alarm events can, each sensor and timer has at most one of them queued.
+ */
+int8_t post_system_event(system_event_t event, uint16_t arg){
+
+	int8_t result = event_queue_post(&event_queue, event, arg, event != EVENT_PIR_EDGE);
+
+	kernel_semaphore_give(&kernel, &event_semaphore); // already given if the task has not run yet
+
+	return result == EVENT_QUEUE_OK ? SYS_OK : SYS_ERR;
+}
+
+/**
+ * @brief  Handle an edge of the pir signal
+ * @param  level	pin level read by the interrupt
+ * @note   A rising edge starts the stability timer, a falling edge before its expiry stops it.
+ */
+static void pir_edge(GPIO_PinState level){
+
+	if((system.state == SYSTEM_ACTIVE || system.state == SYSTEM_ALARMED) && get_state_pir(system.pir) == SENSOR_ACTIVE){
+		//check if system is alarmed or active and pir is active
+		if(level == GPIO_PIN_SET){ // rising edge
+			set_pir_pin_state(system.pir, GPIO_PIN_SET); // update pin state
+			set_timer_period(system.pir->timer, SIGNAL_STABILITY_S); // set period for checking signal stability
+			reset_timer_counter(system.pir->timer); // reset timer counter
+			start_timer_IT(system.pir->timer);
+		}else{ // falling edge and timer update event not fired
+			set_pir_pin_state(system.pir, GPIO_PIN_RESET); // update pin state
+			stop_timer_IT(system.pir->timer);
+			reset_timer_counter(system.pir->timer);
+		}
+
+	}
+
+}
+
+/**
+ * @brief  Handle the end of the pir stability time
+ * @note   A falling edge dispatched after the expiry of the timer, but before this event, cancels the alarm.
+ */
+static void pir_stable(){
+
+	if(get_state_pir(system.pir) == SENSOR_ACTIVE && get_pir_pin_state(system.pir) == GPIO_PIN_SET){
+		alarm_pir(system.pir); // call the alarm pir procedure
+	}
+
+}
+
+/**
+ * @brief  Handle a stable crossing of the barrier
+ * @note   The barrier can have been deactivated since the interrupt.
+ */
+static void barrier_crossed(){
+
+	if(get_state_barrier(system.barrier) == SENSOR_ACTIVE){
+		alarm_barrier(system.barrier); // alarm barrier sensor
+	}
+
+}
+
+/**
+ * @brief  Handle a button of the keypad
+ * @param  button	button read by the interrupt
+ * @note   Called by the background task. The command starts with #, a complete command is executed.
+ */
+static void keypad_button(KEYPAD_button_t button){
+
+	if(button == KEYPAD_button_HASH && cnt == 0){ // first valid character
+
+		command_buffer[cnt] = button; // insert the first valid character into the buffer
+		cnt +=1 ;
+
+	}else if(command_buffer[0] == KEYPAD_button_HASH && cnt < COMMAND_BUFFER_SIZE && cnt > 0){ // successive command characters
+
+		command_buffer[cnt] = button; // insert the character into the buffer
+		cnt += 1;
+		if(cnt == COMMAND_BUFFER_SIZE){
+			cnt = 0;
+			run_user_command(command_buffer); // check the pin and execute the command inserted
+		}
+
+	}
+
+}
+
+/**
+ * @brief  Dispatch the events posted by the interrupts
+ * @note   Called by the alarm task. Each event runs to completion before the next one, so the state machine
+ * 		   of the system only runs from the tasks and it is never preempted by itself.
+ */
+static void dispatch_system_events(){
+
+	event_t event;
+
+	while(event_queue_pop(&event_queue, &event) == EVENT_QUEUE_OK){
+
+		switch(event.id){
+		case EVENT_PIR_EDGE:
+			pir_edge((GPIO_PinState)event.arg);
+			break;
+		case EVENT_PIR_STABLE:
+			pir_stable();
+			break;
+		case EVENT_BARRIER_CROSSED:
+			barrier_crossed();
+			break;
+		case EVENT_PIR_DELAY:
+			pir_delay_alarm();
+			break;
+		case EVENT_BARRIER_DELAY:
+			barrier_delay_alarm();
+			break;
+		case EVENT_ALARM_DURATION:
+			duration_dealarm();
+			break;
+		default:
+			break;
+		}
+
+	}
+
+}
+
 /**
  * @brief  Redefinition of EXTI Callback
  * @Param  GPIO_Pin		The GPIO_Pin that generates interrupt
- * @note   It manages the Keypad interrupt and the pir interrupt
+ * @note   It manages the Keypad interrupt, the pir interrupt and the rtc square wave.
+ * 		   The square wave advances the log timebase at once; the pir level and the keypad button are read
+ * 		   here, the keypad scan clears the interrupts raised by its own column changes, then the level is
+ * 		   posted to the alarm task and the button is sent to the background task.
  */
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
 
-	if(GPIO_Pin == PIR_SENSOR_PIN){  //system.pir->sensor.GPIO_Pin
-
-		if((system.state == SYSTEM_ACTIVE || system.state == SYSTEM_ALARMED) && get_state_pir(system.pir) == SENSOR_ACTIVE){
-			//check if system is alarmed or active and pir is active
-				if(HAL_GPIO_ReadPin(PIR_SENSOR_PORT, PIR_SENSOR_PIN)){ // rising edge
-					//pir_rising_edge();
-					set_pir_pin_state(system.pir, GPIO_PIN_SET); // update pin state
-					set_timer_period(system.pir->timer, SIGNAL_STABILITY_S); // set period for checking signal stability
-					reset_timer_counter(system.pir->timer); // reset timer counter
-					start_timer_IT(system.pir->timer);
-				}else if(!HAL_GPIO_ReadPin(PIR_SENSOR_PORT, PIR_SENSOR_PIN) && get_state_pir(system.pir) != SENSOR_ALARMED){ // falling edge and timer update event not fired
-					set_pir_pin_state(system.pir, GPIO_PIN_RESET); // update pin state
-					stop_timer_IT(system.pir->timer);
-					reset_timer_counter(system.pir->timer);
-				}else
-					set_pir_pin_state(system.pir, GPIO_PIN_RESET);
+	if(GPIO_Pin == RTC_SQW_PIN){
 
-		}
+		if(system.system_log != NULL && !system_clock_is_internal(&system_clock)) // before the clock boot stage the square wave of a previous boot can be on
+			system_log_second(system.system_log);
+
+	}
+	else if(GPIO_Pin == PIR_SENSOR_PIN){  //system.pir->sensor.GPIO_Pin
+
+		post_system_event(EVENT_PIR_EDGE, HAL_GPIO_ReadPin(PIR_SENSOR_PORT, PIR_SENSOR_PIN));
+
+	}
+	else if(GPIO_Pin == CONSOLE_RX_PIN){ // the console has woken the core from the stop mode
+
+		if(system.uart != NULL)
+			uart_handler_rx_wakeup(system.uart);
 
 	}
 	else if((GPIO_Pin == R1_PIN || GPIO_Pin == R2_PIN || GPIO_Pin == R3_PIN || GPIO_Pin == R4_PIN)){
 
 		if(read_pin(GPIO_Pin) == GPIO_PIN_SET){
 			KEYPAD_button_t button = KEYPAD_Update(GPIO_Pin);
-			//HAL_UART_Transmit(&huart2, &button, 1, HAL_MAX_DELAY);
-			if(button == KEYPAD_button_HASH && cnt == 0){ // first valid character
-
-				command_buffer[cnt] = button; // insert the first valid character into the buffer
-				cnt +=1 ;
-
-			}else if(command_buffer[0] == KEYPAD_button_HASH && cnt < COMMAND_BUFFER_SIZE && cnt > 0){ // successive command characters
-
-				command_buffer[cnt] = button; // insert the character into the buffer
-				cnt += 1;
-				if(cnt == COMMAND_BUFFER_SIZE){
-					cnt = 0;
-					//HAL_UART_Transmit(&huart2, command_buffer, 7, HAL_MAX_DELAY);
-					//HAL_UART_Transmit(&huart2, system.system_configuration->pin, PIN_SIZE, HAL_MAX_DELAY);
-					if(check_user_pin(command_buffer) != WRONG_USER_PIN){// check the command inserted
-						if(execute_command(command_buffer+1+PIN_SIZE) == COMMAND_ACCEPTED){
-							system_log_send_message(system.system_log, (uint8_t *) COMMAND_ACCEPTED_MESSAGE, COMMAND_ACCEPTED_LENGTH);
-							if(get_state_buzzer(system.buzzer) != BUZZER_ACTIVE){
-								activate_buzzer(system.buzzer, COMMAND_PULSE);
-							}
-
-						}else{
-							system_log_send_message(system.system_log, (uint8_t *) COMMAND_REJECTED_MESSAGE, COMMAND_REJECTED_LENGTH);
-						}
-					}else{
-						system_log_send_message(system.system_log, (uint8_t *) WRONG_USER_PIN_MESSAGE, WRONG_USER_PIN_LENGTH);
-					}
-
-				}
-
-			}
-
+			kernel_queue_send(&kernel, &keypad_queue, &button); // parsed by the background task
 		}
 	}
 }
@@ -0,0 +1,669 @@
+/*
+ * system_clock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "system_clock.h"
+#include "system.h"
+#include "epoch.h"
+
+/**
+ * @brief Asynchronous prescaler: 32768 Hz or 32 kHz / 128 gives the 256 Hz or 250 Hz sub-second clock
+ */
+#define PREDIV_A (127)
+
+/**
+ * @brief Synchronous prescalers of the two oscillators: the sub-second clock / (PREDIV_S + 1) gives 1 Hz
+ */
+#define PREDIV_S_LSE (255)
+#define PREDIV_S_LSI (249)
+
+/**
+ * @brief EXTI lines of the rtc interrupts
+ */
+#define WAKEUP_EXTI_LINE (EXTI_IMR_MR22)
+#define ALARM_EXTI_LINE (EXTI_IMR_MR17)
+
+/**
+ * @brief  Convert a decimal value into BCD
+ * @param  value	decimal value [0-99]
+ * @return BCD value
+ */
+static uint32_t to_bcd(uint8_t value){
+
+	return ((value/10) << 4) | (value%10);
+
+}
+
+/**
+ * @brief  Convert a BCD field into decimal
+ * @param  bcd		BCD value
+ * @return decimal value
+ */
+static uint8_t from_bcd(uint32_t bcd){
+
+	return ((bcd >> 4) & 0x0F)*10 + (bcd & 0x0F);
+
+}
+
+/**
+ * @brief  Wait until the given ISR flag is set
+ * @param  flag		RTC_ISR flag
+ * @return operation result, SYSTEM_CLOCK_ERR on timeout
+ */
+static int8_t wait_flag(uint32_t flag){
+
+	uint32_t start = HAL_GetTick();
+
+	while((RTC->ISR & flag) == 0){
+		if(HAL_GetTick() - start > SYSTEM_CLOCK_TIMEOUT){
+			return SYSTEM_CLOCK_ERR;
+		}
+	}
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Poll the given ISR flag
+ * @param  flag		RTC_ISR flag
+ * @return operation result, SYSTEM_CLOCK_ERR if the flag is still clear after SYSTEM_CLOCK_POLLS reads
+ * @note   The wait of the stop mode paths, which run with the interrupts masked: the rtc sets its flags
+ * 		   within two periods of its 32 kHz clock, far fewer than the polls.
+ */
+static int8_t poll_flag(uint32_t flag){
+
+	uint32_t polls;
+
+	for(polls = 0; polls < SYSTEM_CLOCK_POLLS; polls++){
+		if(RTC->ISR & flag){
+			return SYSTEM_CLOCK_OK;
+		}
+	}
+
+	return SYSTEM_CLOCK_ERR;
+}
+
+/**
+ * @brief  Remove the write protection of the rtc registers
+ */
+static void unlock_registers(){
+
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+
+}
+
+/**
+ * @brief  Restore the write protection of the rtc registers
+ */
+static void lock_registers(){
+
+	RTC->WPR = 0xFF;
+
+}
+
+/**
+ * @brief  Stop the calendar in order to write it, the registers must be unlocked
+ * @return operation result
+ */
+static int8_t enter_init_mode(){
+
+	RTC->ISR = 0xFFFFFFFF; // the flags are cleared by writing 0, so only INIT changes
+
+	return wait_flag(RTC_ISR_INITF);
+}
+
+/**
+ * @brief  Restart the calendar and wait the shadow registers synchronization
+ * @return operation result
+ */
+static int8_t exit_init_mode(){
+
+	RTC->ISR &= ~RTC_ISR_INIT;
+
+	RTC->ISR &= ~RTC_ISR_RSF;
+	return wait_flag(RTC_ISR_RSF);
+}
+
+/**
+ * @brief  Start the oscillator and select it as rtc clock
+ * @param  clock	pointer to system clock structure
+ * @return operation result
+ * @note   The crystal is preferred, the RC oscillator is the fallback of a board without it. Changing
+ * 		   oscillator needs a reset of the backup domain, which clears the calendar. The crystal has been
+ * 		   switched on by system_clock_start_oscillator(), so only the rest of its startup is waited here.
+ */
+static int8_t start_oscillator(system_clock_t *clock){
+
+	uint32_t start;
+	uint32_t rtcsel;
+
+	while(!system_clock_oscillator_settled(clock));
+
+	if(RCC->BDCR & RCC_BDCR_LSERDY){
+		clock->source = SYSTEM_CLOCK_LSE;
+		clock->prediv_s = PREDIV_S_LSE;
+		rtcsel = RCC_BDCR_RTCSEL_0;
+	}else{
+		RCC->BDCR &= ~RCC_BDCR_LSEON;
+		RCC->CSR |= RCC_CSR_LSION; // the RC oscillator is stopped by any reset
+		start = HAL_GetTick();
+		while((RCC->CSR & RCC_CSR_LSIRDY) == 0){
+			if(HAL_GetTick() - start > SYSTEM_CLOCK_TIMEOUT){
+				return SYSTEM_CLOCK_ERR;
+			}
+		}
+		clock->source = SYSTEM_CLOCK_LSI;
+		clock->prediv_s = PREDIV_S_LSI;
+		rtcsel = RCC_BDCR_RTCSEL_1;
+	}
+
+	if((RCC->BDCR & RCC_BDCR_RTCSEL) != rtcsel){
+		if(RCC->BDCR & RCC_BDCR_RTCSEL){ // selected by a previous boot, only a backup domain reset changes it
+			RCC->BDCR |= RCC_BDCR_BDRST;
+			RCC->BDCR &= ~RCC_BDCR_BDRST;
+			if(clock->source == SYSTEM_CLOCK_LSE){
+				RCC->BDCR |= RCC_BDCR_LSEON;
+				start = HAL_GetTick();
+				while((RCC->BDCR & RCC_BDCR_LSERDY) == 0){
+					if(HAL_GetTick() - start > LSE_STARTUP_TIMEOUT){
+						return SYSTEM_CLOCK_ERR;
+					}
+				}
+			}
+		}
+		RCC->BDCR |= rtcsel;
+	}
+
+	RCC->BDCR |= RCC_BDCR_RTCEN;
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Switch the crystal on, without waiting its startup
+ * @param  clock	pointer to system clock structure
+ * @note   A cold crystal needs up to a few seconds to start: it is switched on at the beginning of the boot,
+ * 		   so its startup overlaps the other boot stages and init_system_clock() finds it running.
+ */
+void system_clock_start_oscillator(system_clock_t *clock){
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR |= PWR_CR_DBP; // write access to the backup domain
+
+	RCC->BDCR |= RCC_BDCR_LSEON;
+	clock->oscillator_start = HAL_GetTick();
+
+}
+
+/**
+ * @brief  Check the startup of the crystal
+ * @param  clock	pointer to system clock structure
+ * @return 1 if the crystal is ready or LSE_STARTUP_TIMEOUT has elapsed since system_clock_start_oscillator()
+ */
+uint8_t system_clock_oscillator_settled(system_clock_t *clock){
+
+	return (RCC->BDCR & RCC_BDCR_LSERDY) != 0 || HAL_GetTick() - clock->oscillator_start >= LSE_STARTUP_TIMEOUT;
+
+}
+
+/**
+ * @brief  Initialize the system clock
+ * @param  clock	pointer to system clock structure
+ * @param  backup	pointer to the DS1307 rtc structure, it keeps the time across the power losses
+ * @return operation result, SYSTEM_CLOCK_ERR if the internal rtc does not start: the time is read from the backup
+ * @note   The calendar survives the resets: it is kept if the backup register marks it as set and the
+ * 		   prescalers match the oscillator; otherwise it waits system_clock_reconcile().
+ * 		   system_clock_start_oscillator() must have been called before.
+ */
+int8_t init_system_clock(system_clock_t *clock, rtc_t *backup){
+
+	uint32_t prer;
+
+	clock->backup = backup;
+	clock->source = SYSTEM_CLOCK_NONE;
+	clock->reconcile = SYSTEM_CLOCK_UNSET;
+	clock->second_callback = NULL;
+	clock->alarm_callback = NULL;
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR |= PWR_CR_DBP; // write access to the backup domain
+
+	if(start_oscillator(clock) != SYSTEM_CLOCK_OK){
+		clock->source = SYSTEM_CLOCK_NONE;
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	prer = (PREDIV_A << RTC_PRER_PREDIV_A_Pos) | clock->prediv_s;
+	if(RTC->BKP0R == SYSTEM_CLOCK_MARKER && RTC->PRER == prer){
+		return SYSTEM_CLOCK_OK;
+	}
+
+	unlock_registers();
+	if(enter_init_mode() != SYSTEM_CLOCK_OK){
+		lock_registers();
+		clock->source = SYSTEM_CLOCK_NONE;
+		return SYSTEM_CLOCK_ERR;
+	}
+	RTC->PRER = prer & RTC_PRER_PREDIV_S; // the synchronous prescaler must be written first
+	RTC->PRER = prer;
+	RTC->CR &= ~RTC_CR_FMT; // 24 hours
+	exit_init_mode();
+	lock_registers();
+
+	RTC->BKP0R = 0; // calendar not set
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Check if the internal rtc keeps the time
+ * @param  clock	pointer to system clock structure
+ * @return 1 if the time is read from the internal rtc, 0 if it is read from the backup
+ */
+uint8_t system_clock_is_internal(system_clock_t *clock){
+
+	return clock->source != SYSTEM_CLOCK_NONE && RTC->BKP0R == SYSTEM_CLOCK_MARKER;
+
+}
+
+/**
+ * @brief  Read the date time and the milliseconds from the internal rtc registers
+ * @param  clock		pointer to system clock structure
+ * @param  date_time	pointer where store the date time
+ * @param  milliseconds	pointer where store the milliseconds [0-999]
+ * @return operation result, SYSTEM_CLOCK_ERR if the internal rtc does not keep the time
+ * @note   No bus transaction, it can be called from any interrupt. Reading the sub-seconds freezes time
+ * 		   and date until the date is read, so the three registers are coherent.
+ */
+int8_t system_clock_get(system_clock_t *clock, date_time_t *date_time, uint16_t *milliseconds){
+
+	uint32_t ssr;
+	uint32_t tr;
+	uint32_t dr;
+
+	if(!system_clock_is_internal(clock)){
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	ssr = RTC->SSR;
+	tr = RTC->TR;
+	dr = RTC->DR;
+
+	date_time->seconds = from_bcd(tr & (RTC_TR_ST | RTC_TR_SU));
+	date_time->minutes = from_bcd((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos);
+	date_time->hours = from_bcd((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos);
+	date_time->day = (dr & RTC_DR_WDU) >> RTC_DR_WDU_Pos;
+	date_time->date = from_bcd(dr & (RTC_DR_DT | RTC_DR_DU));
+	date_time->month = from_bcd((dr & (RTC_DR_MT | RTC_DR_MU)) >> RTC_DR_MU_Pos);
+	date_time->year = from_bcd((dr & (RTC_DR_YT | RTC_DR_YU)) >> RTC_DR_YU_Pos);
+
+	if(ssr > clock->prediv_s){
+		ssr = clock->prediv_s;
+	}
+	*milliseconds = ((clock->prediv_s - ssr)*1000)/(clock->prediv_s + 1);
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Write the calendar of the internal rtc
+ * @param  date_time	date time to write
+ * @return operation result
+ */
+static int8_t write_calendar(date_time_t *date_time){
+
+	uint8_t day = (date_time->day >= 1 && date_time->day <= 7) ? date_time->day : 1; // 0 is not a valid week day
+
+	unlock_registers();
+	if(enter_init_mode() != SYSTEM_CLOCK_OK){
+		lock_registers();
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	RTC->TR = (to_bcd(date_time->hours) << RTC_TR_HU_Pos) | (to_bcd(date_time->minutes) << RTC_TR_MNU_Pos) | to_bcd(date_time->seconds);
+	RTC->DR = (to_bcd(date_time->year) << RTC_DR_YU_Pos) | (day << RTC_DR_WDU_Pos) | (to_bcd(date_time->month) << RTC_DR_MU_Pos) | to_bcd(date_time->date);
+
+	if(exit_init_mode() != SYSTEM_CLOCK_OK){
+		lock_registers();
+		return SYSTEM_CLOCK_ERR;
+	}
+	lock_registers();
+
+	RTC->BKP0R = SYSTEM_CLOCK_MARKER;
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Check if a date time read from the DS1307 is plausible
+ * @param  date_time	date time to check
+ * @return 1 if all the fields are in range
+ */
+static uint8_t is_valid(date_time_t *date_time){
+
+	return date_time->year <= 99 && date_time->date >= 1 && date_time->date <= epoch_days_in_month(date_time->year, date_time->month) &&
+		   date_time->hours < 24 && date_time->minutes < 60 && date_time->seconds < 60;
+
+}
+
+/**
+ * @brief  Check if two date times are within SYSTEM_CLOCK_TOLERANCE seconds
+ * @param  a	first date time
+ * @param  b	second date time
+ * @return 1 if they agree
+ */
+static uint8_t agree(date_time_t *a, date_time_t *b){
+
+	int32_t difference = (int32_t)(epoch_from_date_time(a) - epoch_from_date_time(b));
+
+	return difference <= SYSTEM_CLOCK_TOLERANCE && difference >= -SYSTEM_CLOCK_TOLERANCE;
+
+}
+
+/**
+ * @brief  Reconcile the internal rtc and the backup
+ * @param  clock	pointer to system clock structure
+ * @return what has been done
+ * @note   Called once at boot, after the configuration protocol has possibly set the backup. The DS1307 has
+ * 		   its own battery, so it is the reference: the internal rtc is set from it when they disagree. If the
+ * 		   DS1307 has lost the time and the internal rtc kept it, across a reset, the DS1307 is restored; a
+ * 		   failed restore is reported as SYSTEM_CLOCK_RESTORE_FAILED, the internal rtc is still used.
+ */
+system_clock_reconcile_t system_clock_reconcile(system_clock_t *clock){
+
+	date_time_t internal;
+	uint16_t milliseconds;
+	uint8_t backup_valid = (ds1307rtc_update_date_time(clock->backup) == DS1307_OK && is_valid(&clock->backup->date_time));
+	uint8_t internal_valid = (system_clock_get(clock, &internal, &milliseconds) == SYSTEM_CLOCK_OK);
+
+	if(clock->source == SYSTEM_CLOCK_NONE){
+		clock->reconcile = backup_valid ? SYSTEM_CLOCK_KEPT : SYSTEM_CLOCK_UNSET;
+	}else if(backup_valid && internal_valid && agree(&internal, &clock->backup->date_time)){
+		clock->reconcile = SYSTEM_CLOCK_KEPT;
+	}else if(backup_valid){
+		clock->reconcile = write_calendar(&clock->backup->date_time) == SYSTEM_CLOCK_OK ? SYSTEM_CLOCK_SEEDED : SYSTEM_CLOCK_UNSET;
+	}else if(internal_valid){
+		clock->backup->date_time = internal;
+		clock->reconcile = ds1307rtc_set_date_time(clock->backup) == DS1307_OK ? SYSTEM_CLOCK_RESTORED : SYSTEM_CLOCK_RESTORE_FAILED;
+	}else{
+		clock->reconcile = SYSTEM_CLOCK_UNSET;
+	}
+
+	return clock->reconcile;
+}
+
+/**
+ * @brief  Set the date time of the internal rtc and of the backup
+ * @param  clock		pointer to system clock structure
+ * @param  date_time	date time to set
+ * @return operation result
+ * @note   Blocking I2C write, it must be called from the main loop.
+ */
+int8_t system_clock_set(system_clock_t *clock, date_time_t *date_time){
+
+	if(clock->source != SYSTEM_CLOCK_NONE && write_calendar(date_time) != SYSTEM_CLOCK_OK){
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	clock->backup->date_time = *date_time;
+	if(ds1307rtc_set_date_time(clock->backup) != DS1307_OK){
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Start the wakeup interrupt each second
+ * @param  clock		pointer to system clock structure
+ * @param  callback		called by the interrupt
+ * @return operation result
+ * @note   The wakeup timer counts the 1 Hz calendar clock, so the interrupt comes at the increment of the seconds.
+ */
+int8_t system_clock_start_seconds(system_clock_t *clock, system_clock_callback_t callback){
+
+	if(!system_clock_is_internal(clock)){
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	clock->second_callback = callback;
+
+	unlock_registers();
+	RTC->CR &= ~RTC_CR_WUTE;
+	if(wait_flag(RTC_ISR_WUTWF) != SYSTEM_CLOCK_OK){
+		lock_registers();
+		return SYSTEM_CLOCK_ERR;
+	}
+	RTC->WUTR = 0; // WUTR + 1 periods of the 1 Hz clock
+	RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUCKSEL_2;
+	RTC->CR |= RTC_CR_WUTIE | RTC_CR_WUTE;
+	lock_registers();
+
+	EXTI->IMR |= WAKEUP_EXTI_LINE;
+	EXTI->RTSR |= WAKEUP_EXTI_LINE;
+	HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Start the alarm A interrupt each day
+ * @param  clock		pointer to system clock structure
+ * @param  date_time	hours, minutes and seconds of the alarm, the date is ignored
+ * @param  callback		called by the interrupt
+ * @return operation result
+ */
+int8_t system_clock_set_alarm(system_clock_t *clock, date_time_t *date_time, system_clock_callback_t callback){
+
+	if(!system_clock_is_internal(clock)){
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	clock->alarm_callback = callback;
+
+	unlock_registers();
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	if(wait_flag(RTC_ISR_ALRAWF) != SYSTEM_CLOCK_OK){
+		lock_registers();
+		return SYSTEM_CLOCK_ERR;
+	}
+	RTC->ALRMAR = RTC_ALRMAR_MSK4 | (to_bcd(date_time->hours) << RTC_ALRMAR_HU_Pos) | (to_bcd(date_time->minutes) << RTC_ALRMAR_MNU_Pos) | to_bcd(date_time->seconds);
+	RTC->CR |= RTC_CR_ALRAIE | RTC_CR_ALRAE;
+	lock_registers();
+
+	EXTI->IMR |= ALARM_EXTI_LINE;
+	EXTI->RTSR |= ALARM_EXTI_LINE;
+	HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Stop the alarm A interrupt
+ * @param  clock	pointer to system clock structure
+ */
+void system_clock_stop_alarm(system_clock_t *clock){
+
+	if(clock->source == SYSTEM_CLOCK_NONE){
+		return;
+	}
+
+	unlock_registers();
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	lock_registers();
+
+	clock->alarm_callback = NULL;
+
+}
+
+/**
+ * @brief  Read the sub-second periods elapsed since midnight
+ * @param  clock	pointer to system clock structure
+ * @return periods since midnight, prediv_s + 1 each second
+ * @note   The time of the day only: the date register is read to unlock the shadow registers.
+ */
+uint32_t system_clock_periods(system_clock_t *clock){
+
+	uint32_t ssr = RTC->SSR;
+	uint32_t tr = RTC->TR;
+	uint32_t seconds;
+
+	(void)RTC->DR;
+
+	seconds = from_bcd((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos)*3600 +
+			  from_bcd((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos)*60 +
+			  from_bcd(tr & (RTC_TR_ST | RTC_TR_SU));
+
+	if(ssr > clock->prediv_s){
+		ssr = clock->prediv_s;
+	}
+
+	return seconds*(clock->prediv_s + 1) + clock->prediv_s - ssr;
+}
+
+/**
+ * @brief  Compute the sub-second periods between two readings
+ * @param  clock	pointer to system clock structure
+ * @param  from		first value of system_clock_periods()
+ * @param  to		later value of system_clock_periods(), less than a day later
+ * @return periods elapsed, the midnight wrap included
+ */
+uint32_t system_clock_elapsed(system_clock_t *clock, uint32_t from, uint32_t to){
+
+	if(to >= from){
+		return to - from;
+	}
+
+	return to + EPOCH_SECONDS_PER_DAY*(clock->prediv_s + 1) - from;
+}
+
+/**
+ * @brief  Start the alarm B interrupt within the next second
+ * @param  clock	pointer to system clock structure
+ * @param  periods	value of system_clock_periods() to wake at, less than a second ahead
+ * @return operation result
+ * @note   Only the sub-second counter is compared, so the alarm comes at the first match; it is stopped by
+ * 		   system_clock_stop_timeout() before the next one. It can be called with the interrupts masked.
+ */
+int8_t system_clock_start_timeout(system_clock_t *clock, uint32_t periods){
+
+	if(!system_clock_is_internal(clock)){
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	unlock_registers();
+	RTC->CR &= ~(RTC_CR_ALRBE | RTC_CR_ALRBIE);
+	if(poll_flag(RTC_ISR_ALRBWF) != SYSTEM_CLOCK_OK){
+		lock_registers();
+		return SYSTEM_CLOCK_ERR;
+	}
+	RTC->ALRMBR = RTC_ALRMBR_MSK4 | RTC_ALRMBR_MSK3 | RTC_ALRMBR_MSK2 | RTC_ALRMBR_MSK1; // date and time ignored
+	RTC->ALRMBSSR = (15UL << RTC_ALRMBSSR_MASKSS_Pos) | (clock->prediv_s - periods % (clock->prediv_s + 1));
+	RTC->ISR = ~(RTC_ISR_ALRBF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+	RTC->CR |= RTC_CR_ALRBIE | RTC_CR_ALRBE;
+	lock_registers();
+
+	EXTI->IMR |= ALARM_EXTI_LINE;
+	EXTI->RTSR |= ALARM_EXTI_LINE;
+	HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+
+	return SYSTEM_CLOCK_OK;
+}
+
+/**
+ * @brief  Stop the alarm B interrupt
+ * @param  clock	pointer to system clock structure
+ * @note   A flag already set is cleared by the alarm interrupt.
+ */
+void system_clock_stop_timeout(system_clock_t *clock){
+
+	if(clock->source == SYSTEM_CLOCK_NONE){
+		return;
+	}
+
+	unlock_registers();
+	RTC->CR &= ~(RTC_CR_ALRBE | RTC_CR_ALRBIE);
+	lock_registers();
+
+}
+
+/**
+ * @brief  Wait for the update of the calendar shadow registers
+ * @param  clock	pointer to system clock structure
+ * @return operation result
+ * @note   The bus clock is stopped by the stop mode, so the shadow registers keep the time of its entry until
+ * 		   the next copy from the calendar, two periods of the rtc clock later. It runs with the interrupts masked.
+ */
+int8_t system_clock_resync(system_clock_t *clock){
+
+	if(!system_clock_is_internal(clock)){
+		return SYSTEM_CLOCK_ERR;
+	}
+
+	unlock_registers();
+	RTC->ISR = ~(RTC_ISR_RSF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+	lock_registers();
+
+	return poll_flag(RTC_ISR_RSF);
+}
+
+/**
+ * @brief  Get the name of the clock source
+ * @param  clock	pointer to system clock structure
+ * @return source name
+ */
+char* get_system_clock_source_string(system_clock_t *clock){
+
+	if(!system_clock_is_internal(clock)){
+		return "DS1307";
+	}
+
+	return clock->source == SYSTEM_CLOCK_LSE ? "LSE" : "LSI";
+}
+
+/**
+ * @brief  Handle the wakeup interrupt
+ * @note   Called by RTC_WKUP_IRQHandler: the flag of the rtc and the one of the EXTI line are cleared.
+ */
+void system_clock_wakeup_IRQHandler(){
+
+	if(RTC->ISR & RTC_ISR_WUTF){
+		RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+		if(system.clock != NULL && system.clock->second_callback != NULL){
+			system.clock->second_callback();
+		}
+	}
+
+	EXTI->PR = WAKEUP_EXTI_LINE;
+
+}
+
+/**
+ * @brief  Handle the alarm interrupt
+ * @note   Called by RTC_Alarm_IRQHandler: the flags of the rtc and the one of the EXTI line are cleared.
+ * 		   Alarm B only wakes the core from the stop mode, it has no callback.
+ */
+void system_clock_alarm_IRQHandler(){
+
+	if(RTC->ISR & RTC_ISR_ALRAF){
+		RTC->ISR = ~(RTC_ISR_ALRAF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+		if(system.clock != NULL && system.clock->alarm_callback != NULL){
+			system.clock->alarm_callback();
+		}
+	}
+
+	if(RTC->ISR & RTC_ISR_ALRBF){
+		RTC->ISR = ~(RTC_ISR_ALRBF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+	}
+
+	EXTI->PR = ALARM_EXTI_LINE;
+
+}
@@ -15,62 +15,195 @@
 #include "module_barrier.h"
 #include "module_pir.h"
 #include "stm32f4xx_hal_uart.h"
-#include "stdio.h"
-
-#define RTC_COMUNICATION_PROBLEM ("RTC PROBLEM: CHECK CONNECTIONS AND RESTART THE BOARD\n\r")
+#include "log_format.h"
+#include "log_frame.h"
+#include "critical_section.h"
+#include "epoch.h"
 
 /**
- * @brief buffer where insert system log message
+ * @brief System log message size
  */
-char msg[100];
+#define LOG_MESSAGE_SIZE (96)
 
 /**
- * @brief Output date time buffer size
+ * @brief text of the deferred log messages, indexed by identifier
  */
-#define DATE_TIME_OUTPUT_BUFFER_SIZE (21)
+#define LOG_MESSAGE(id, text) text,
+const char *log_messages[LOG_IDS] = { "", LOG_MESSAGES };
+#undef LOG_MESSAGE
 
 /**
- * @brief output date_time buffer
+ * @brief  Send the status message, at each heartbeat period
+ * @note   Called by the heartbeat timer, from the tick interrupt.
  */
-uint8_t output_date_time_buffer[DATE_TIME_OUTPUT_BUFFER_SIZE];
+static void heartbeat_elapsed(){
 
-/**
- * @brief Char variable for dash char
- */
-uint8_t dash = '-';
+	if(system.system_log->state == START_L)
+		start_send_log_message(system.system_log); // start the system_log send message procedure
 
-/**
- * @brief Buffer to carriage return
- */
-char* carriage_return = "\n\r";
+}
 
 /**
  * @brief  Initialize the system log
  * @param  system_log 		pointer to system log structure
  * @param  rtc				pointer to rtc structure
  * @param  uart_handler		pointer to uart handler structure
- * @param  timer			pointer to timer
+ * @param  wheel			pointer to the timer wheel of the heartbeat timer
  */
-void init_system_log(system_log_t *system_log, rtc_t *rtc, uart_handler_t *uart_handler, TIM_HandleTypeDef *timer){
+void init_system_log(system_log_t *system_log, rtc_t *rtc, uart_handler_t *uart_handler, timer_wheel_t *wheel){
 
 	system_log->state = IDLE_L;
+	system_log->mode = SYSTEM_LOG_DEFAULT_MODE;
+	system_log->heartbeat = SYSTEM_LOG_HEARTBEAT;
+	system_log->heartbeat_pending = 0;
+	system_log->event_pending = 0;
+	system_log->reported_dropped = 0;
+	log_ring_init(&system_log->ring);
+	timebase_init(&system_log->timebase);
+	system_log->resync_elapsed = 0;
+	system_log->reads = 0;
 	system_log->rtc = rtc;
 	system_log->uart = uart_handler;
-	system_log->timer = timer;
+	system_log->wheel = wheel;
+	init_virtual_timer(&system_log->heartbeat_timer, heartbeat_elapsed);
+
+}
+
+/**
+ * @brief  Get the current system and sensors states, packed as in the binary records
+ * @return packed states
+ */
+static uint8_t get_packed_states(){
+
+	return LOG_FRAME_PACK_STATES(get_state_pir(system.pir), get_state_barrier(system.barrier), system.state);
+
+}
+
+/**
+ * @brief  Start the heartbeat timer with the configured period
+ * @param  system_log	pointer to system log structure
+ */
+static void start_heartbeat(system_log_t *system_log){
+
+	if(system_log->heartbeat > 0){
+		timer_wheel_start(system_log->wheel, &system_log->heartbeat_timer, system_log->heartbeat * 1000, system_log->heartbeat * 1000);
+	}else{
+		timer_wheel_stop(&system_log->heartbeat_timer);
+	}
+
+}
+
+/**
+ * @brief  Push a status or state change record with the given timestamp
+ * @param  system_log	pointer to system log structure
+ * @param  id			LOG_ID_STATUS or LOG_ID_EVENT
+ * @param  seconds		epoch seconds of the record
+ * @param  milliseconds	milliseconds of the record
+ */
+static void push_state_record(system_log_t *system_log, log_id_t id, epoch_t seconds, uint16_t milliseconds){
+
+	system_log_event(system_log, id, seconds, milliseconds, get_packed_states());
+
+}
+
+/**
+ * @brief  Push a status or state change record dated by the timebase
+ * @param  system_log	pointer to system log structure
+ * @param  id			LOG_ID_STATUS or LOG_ID_EVENT
+ * @return SYSTEM_LOG_ERR if the square wave does not keep the timebase in phase: the rtc must be read
+ */
+static int8_t push_timebase_record(system_log_t *system_log, log_id_t id){
+
+	uint32_t tick = HAL_GetTick();
+	epoch_t seconds;
+	uint16_t milliseconds;
+
+	if(!timebase_locked(&system_log->timebase, tick) || timebase_get_epoch(&system_log->timebase, tick, &seconds, &milliseconds) != TIMEBASE_OK){
+		return SYSTEM_LOG_ERR;
+	}
+
+	push_state_record(system_log, id, seconds, milliseconds);
+
+	return SYSTEM_LOG_OK;
+}
+
+/**
+ * @brief  Anchor the timebase to a clock reading and push the pending records
+ * @param  system_log	pointer to system log structure
+ * @param  date_time	date time read from the clock
+ * @param  tick			HAL tick of the reading
+ */
+static void date_time_ready(system_log_t *system_log, date_time_t *date_time, uint32_t tick){
+
+	timebase_t *timebase = &system_log->timebase;
+	int32_t correction;
+	epoch_t seconds;
+	uint16_t milliseconds;
+
+	correction = timebase_sync(timebase, date_time, tick);
+	if(correction != 0){
+		system_log_event(system_log, LOG_ID_TIMEBASE_RESYNC, correction, timebase->drift, timebase->drift_interval);
+	}
+	system_log->resync_elapsed = 0;
+
+	timebase_get_epoch(timebase, HAL_GetTick(), &seconds, &milliseconds); // synced, it cannot fail
+
+	if(system_log->event_pending){
+		system_log->event_pending = 0;
+		push_state_record(system_log, LOG_ID_EVENT, seconds, milliseconds);
+	}
+
+	if(system_log->heartbeat_pending){
+		system_log->heartbeat_pending = 0;
+		push_state_record(system_log, LOG_ID_STATUS, seconds, milliseconds);
+	}
+
+}
+
+/**
+ * @brief  Request the current date and time to the rtc
+ * @param  system_log	pointer to system log structure
+ * @note   If the internal rtc keeps the time its registers are read at once, without any bus transaction.
+ * 		   Otherwise the DS1307 reading is queued on the i2c bus. If a reading is already queued nothing is done:
+ * 		   its completion sends all the pending records.
+ * 		   If the bus queue is full the request is repeated by system_log_process(). If the reading fails the
+ * 		   pending records are discarded by log_callback_error(), so the error is reported once.
+ */
+static void request_date_time(system_log_t *system_log){
+
+	date_time_t date_time;
+	uint16_t milliseconds;
+
+	if(system.clock != NULL && system_clock_get(system.clock, &date_time, &milliseconds) == SYSTEM_CLOCK_OK){
+		system_log->reads++;
+		date_time_ready(system_log, &date_time, HAL_GetTick() - milliseconds);
+		return;
+	}
+
+	if(system_log->rtc->reading){
+		return;
+	}
+
+	if(ds1307rtc_update_date_time_DMA(system_log->rtc) == DS1307_OK){
+		system_log->reads++;
+	}
 
 }
 
 /**
  * @brief  Start system log protocol
  * @param  system_log	pointer to system log structure
- * @note   Start the protocol starting the timer that counts each period
+ * @note   Start the protocol starting the heartbeat timer, if enabled, and take the initial states
+ * 		   used for detecting the state changes. The date and time are read once, in order to anchor
+ * 		   the timebase before the first record.
  */
 void start_system_log(system_log_t *system_log){
 
 	system_log->state = START_L;
+	system_log->states = get_packed_states();
 
-	set_timer_period(system_log->timer, SYSTEM_LOG_PERIOD);
-	start_timer_IT(system_log->timer);
+	start_heartbeat(system_log);
+	request_date_time(system_log);
 
 }
 
@@ -82,20 +215,108 @@ void start_system_log(system_log_t *system_log){
 void stop_system_log(system_log_t *system_log){
 
 	system_log->state = STOP_L;
-	stop_timer_IT(system_log->timer);
+	timer_wheel_stop(&system_log->heartbeat_timer);
+
+}
+
+/**
+ * @brief  Select the output format of the log messages
+ * @param  system_log	pointer to system log structure
+ * @param  mode			LOG_MODE_ASCII or LOG_MODE_BINARY
+ * @note   The new format is used from the next log message. The other messages are always ASCII.
+ */
+void set_system_log_mode(system_log_t *system_log, log_mode_t mode){
+
+	system_log->mode = mode;
+
+}
+
+/**
+ * @brief  Set the heartbeat period
+ * @param  system_log	pointer to system log structure
+ * @param  heartbeat	period of the status message in seconds, 0 disables it
+ * @return operation result, SYSTEM_LOG_ERR if the period is greater than SYSTEM_LOG_MAX_HEARTBEAT
+ * @note   The state changes are always sent, independently from the heartbeat.
+ */
+int8_t set_system_log_heartbeat(system_log_t *system_log, uint16_t heartbeat){
+
+	if(heartbeat > SYSTEM_LOG_MAX_HEARTBEAT){
+		return SYSTEM_LOG_ERR;
+	}
+
+	system_log->heartbeat = heartbeat;
+
+	if(system_log->state == START_L){
+		start_heartbeat(system_log);
+	}
+
+	return SYSTEM_LOG_OK;
+}
+
+/**
+ * @brief  Check the system and sensors states
+ * @param  system_log	pointer to system log structure
+ * @note   Called after any procedure that can change the states (commands, alarms, dealarms).
+ * 		   If the states differ from the last seen ones, a state change record is sent without waiting
+ * 		   for the heartbeat: it is dated by the timebase, or, if the square wave is missing, as soon as
+ * 		   the date and time have been read.
+ */
+void system_log_check_state(system_log_t *system_log){
+
+	uint8_t states = get_packed_states();
+
+	if(system_log->state != START_L || states == system_log->states){
+		return;
+	}
+
+	system_log->states = states;
+
+	if(push_timebase_record(system_log, LOG_ID_EVENT) == SYSTEM_LOG_OK){
+		return;
+	}
+
+	system_log->event_pending = 1;
+	request_date_time(system_log);
 
 }
 
 /**
  * @brief  Start the procedure to send the new system log message
  * @param  system_log	pointer to system_log structure
- * @note   called by TIM10 ElapsedPeriod_Callback.
- * 		   Perform a rtc update request
+ * @note   called by the heartbeat timer, from the tick interrupt.
+ * 		   The status record is dated by the timebase; a rtc update request is performed only if the
+ * 		   square wave is missing.
  */
 void start_send_log_message(system_log_t *system_log){
 
-	if( ds1307rtc_update_date_time_DMA(system_log->rtc) != DS1307_OK)
-		system_log_send_message(system_log, (uint8_t *)RTC_COMUNICATION_PROBLEM, strlen(RTC_COMUNICATION_PROBLEM));
+	if(push_timebase_record(system_log, LOG_ID_STATUS) == SYSTEM_LOG_OK){
+		return;
+	}
+
+	system_log->heartbeat_pending = 1;
+	request_date_time(system_log);
+
+}
+
+/**
+ * @brief  Advance the log timebase by one second
+ * @param  system_log	pointer to system_log structure
+ * @note   Called by the EXTI callback of the rtc square wave. Every SYSTEM_LOG_RESYNC seconds the rtc
+ * 		   is read, in order to check the count of the edges; the reading is retried on the next edges
+ * 		   while the bus is busy.
+ */
+void system_log_second(system_log_t *system_log){
+
+	if(system_log->state != START_L){
+		return;
+	}
+
+	timebase_second(&system_log->timebase, HAL_GetTick());
+
+	if(++system_log->resync_elapsed >= SYSTEM_LOG_RESYNC){
+		request_date_time(system_log);
+	}
+
 }
 
 /**
@@ -142,15 +363,17 @@ int8_t system_log_send_message_DMA(system_log_t *system_log, uint8_t *buffer, in
 
 
 /**
- * @brief   Send the given buffer over uart, in blocking mode
+ * @brief   Queue the given buffer for the transmission over uart
  * @param   system_log		pointer to system_log structure
+ * @param	channel			transmission channel, it sets the message priority
  * @param	buffer			pointer to message buffer
  * @param	buffer_size		buffer size
  * @retval  operation result
+ * @note	The buffer is copied into the uart transmission queue, so the function never waits for the uart
  */
-int8_t system_log_send_message(system_log_t *system_log, uint8_t *buffer, int16_t buffer_size){
+int8_t system_log_send_message(system_log_t *system_log, uart_channel_t channel, uint8_t *buffer, int16_t buffer_size){
 
-	return uart_handler_send_message(system_log->uart, buffer, buffer_size);
+	return uart_handler_enqueue_message(system_log->uart, channel, buffer, buffer_size);
 
 }
 
@@ -193,61 +416,238 @@ int8_t system_log_receive_message(system_log_t *system_log, uint8_t *buffer, int
 	return uart_handler_receive_message_IT(system_log->uart, buffer, buffer_size);
 }
 
+
+/**
+ * @brief	Queue the binary status or event record
+ * @param	type		LOG_FRAME_STATUS or LOG_FRAME_EVENT
+ * @param	channel		uart channel
+ * @param	date_time	pointer to the record date time
+ * @param	milliseconds	milliseconds of the record timestamp
+ * @param	states		packed states
+ * @note	The record is composed by the type, the timestamp fields in binary and the packed states,
+ * 			12 bytes with the CRC and 15 bytes on the wire, against about 60 bytes of the ASCII line.
+ */
+static void send_log_frame(uint8_t type, uart_channel_t channel, date_time_t *date_time, uint16_t milliseconds, uint8_t states){
+
+	uint8_t record[LOG_FRAME_STATUS_SIZE];
+	uint8_t frame[LOG_FRAME_SIZE(LOG_FRAME_STATUS_SIZE)];
+
+	record[0] = type;
+	record[1] = date_time->date;
+	record[2] = date_time->month;
+	record[3] = date_time->year;
+	record[4] = date_time->hours;
+	record[5] = date_time->minutes;
+	record[6] = date_time->seconds;
+	record[7] = states;
+	record[8] = milliseconds & 0xFF;
+	record[9] = milliseconds >> 8;
+
+	system_log_send_message(system.system_log, channel, frame, log_frame_encode(record, LOG_FRAME_STATUS_SIZE, frame));
+
+}
+
+/**
+ * @brief	Queue the ASCII state change message
+ * @param	date_time	pointer to the record date time
+ * @param	milliseconds	milliseconds of the record timestamp
+ * @param	states		packed states
+ * @note	The message is composed by timestamp, system state and sensors name and state
+ */
+static void send_log_event(date_time_t *date_time, uint16_t milliseconds, uint8_t states){
+
+	log_format_t format;
+	char msg[LOG_MESSAGE_SIZE];
+
+	log_format_init(&format, msg, LOG_MESSAGE_SIZE);
+	log_format_timestamp(&format, date_time, milliseconds);
+	log_format_string(&format, " EVENT SYSTEM");
+	log_format_string(&format, get_system_state_string(LOG_FRAME_SYSTEM_STATE(states)));
+	log_format_string(&format, "- AREA");
+	log_format_string(&format, get_state_string(LOG_FRAME_AREA_STATE(states)));
+	log_format_string(&format, "- BARRIER");
+	log_format_string(&format, get_state_string(LOG_FRAME_BARRIER_STATE(states)));
+	log_format_string(&format, "\n\r");
+	system_log_send_message(system.system_log, UART_CHANNEL_ALARM, (uint8_t *)msg, log_format_end(&format));
+
+}
+
 /**
- * @brief	Convert the given decimal value to the corresponding ASCII decimal representation
- * @param	value	decimal value
- * @param	buffer	pointer to an uint8_t array where stored the ASCII decimal representation
+ * @brief	Queue the ASCII status message
+ * @param	date_time	pointer to the record date time
+ * @param	milliseconds	milliseconds of the record timestamp
+ * @param	states		packed states
+ * @note	The message is composed by timestamp and sensors name and state
  */
-void convert_uint8_to_output_buffer(uint8_t value, uint8_t *buffer){
+static void send_log_status(date_time_t *date_time, uint16_t milliseconds, uint8_t states){
+
+	log_format_t format;
+	char msg[LOG_MESSAGE_SIZE];
+
+	log_format_init(&format, msg, LOG_MESSAGE_SIZE);
+	log_format_timestamp(&format, date_time, milliseconds);
+	log_format_string(&format, " AREA ");
+	log_format_string(&format, get_state_string(LOG_FRAME_AREA_STATE(states)));
+	log_format_string(&format, " - BARRIER ");
+	log_format_string(&format, get_state_string(LOG_FRAME_BARRIER_STATE(states)));
+	log_format_string(&format, " \n\r");
+	system_log_send_message(system.system_log, UART_CHANNEL_STATUS, (uint8_t *)msg, log_format_end(&format));// queue the system log message, msg can be reused as soon as it is copied
+
+}
 
-	buffer[0] = value/10 + '0';
-	buffer[1] = value%10 + '0' ;
+/**
+ * @brief	Queue a diagnostic message
+ * @param	record		pointer to the log record
+ * @note	The message is composed by the timestamp of the record tick and the message text with its arguments.
+ * 			Before the first rtc reading the raw tick is sent instead of the timestamp.
+ */
+static void send_log_message(log_record_t *record){
+
+	log_format_t format;
+	date_time_t date_time;
+	uint16_t milliseconds;
+	char msg[LOG_MESSAGE_SIZE];
+
+	log_format_init(&format, msg, LOG_MESSAGE_SIZE);
+	if(timebase_get(&system.system_log->timebase, record->tick, &date_time, &milliseconds) == TIMEBASE_OK){
+		log_format_timestamp(&format, &date_time, milliseconds);
+	}else{
+		log_format_char(&format, '[');
+		log_format_uint(&format, record->tick, 0);
+		log_format_char(&format, ']');
+	}
+	log_format_char(&format, ' ');
+	log_format_message(&format, log_messages[record->id], record->args);
+	log_format_string(&format, "\n\r");
+	system_log_send_message(system.system_log, UART_CHANNEL_DIAGNOSTIC, (uint8_t *)msg, log_format_end(&format));
 
 }
 
 /**
- * @brief Format the output_date_time_buffer in order to be sent over uart.
+ * @brief	Push a record into the log ring
+ * @param	system_log	pointer to system log structure
+ * @param	id			message identifier
+ * @param	arg0		first argument
+ * @param	arg1		second argument
+ * @param	arg2		third argument
+ * @return	operation result, SYSTEM_LOG_ERR if the ring is full
+ * @note	It can be called from any interrupt: the message is formatted and sent by system_log_process().
  */
-void prepare_date_time_buffer(){
+int8_t system_log_event(system_log_t *system_log, log_id_t id, uint32_t arg0, uint32_t arg1, uint32_t arg2){
 
-	output_date_time_buffer[0] = '[';
-	convert_uint8_to_output_buffer(get_date(system.rtc), output_date_time_buffer+1);
-	output_date_time_buffer[3] = '-';
-	convert_uint8_to_output_buffer(get_month(system.rtc), output_date_time_buffer+4);
-	output_date_time_buffer[6] = '-';
-	output_date_time_buffer[7] = '2';
-	output_date_time_buffer[8] = '0';
-	convert_uint8_to_output_buffer(get_year(system.rtc), output_date_time_buffer+9);
-	output_date_time_buffer[11] = ' ';
-	convert_uint8_to_output_buffer(get_hour(system.rtc), output_date_time_buffer+12);
-	output_date_time_buffer[14] = ':';
-	convert_uint8_to_output_buffer(get_minute(system.rtc), output_date_time_buffer+15);
-	output_date_time_buffer[17] = ':';
-	convert_uint8_to_output_buffer(get_second(system.rtc), output_date_time_buffer+18);
-	output_date_time_buffer[20] = ']';
+	if(log_ring_push(&system_log->ring, id, arg0, arg1, arg2) != LOG_RING_OK){
+		return SYSTEM_LOG_ERR;
+	}
 
+	return SYSTEM_LOG_OK;
 }
 
+/**
+ * @brief	Format and send the records pushed into the log ring
+ * @param	system_log	pointer to system log structure
+ * @note	Called by the main loop. The records dropped because the ring was full are reported
+ * 			before the next records. A state change or heartbeat whose reading was skipped, because
+ * 			the bus was busy, is requested again.
+ */
+void system_log_process(system_log_t *system_log){
+
+	log_record_t record;
+	date_time_t date_time;
+	uint16_t milliseconds;
+	uint32_t dropped = system_log->ring.dropped;
+	uint32_t primask;
+	uint8_t internal;
+	uint8_t submit = 0;
+
+	if(system_log->event_pending || system_log->heartbeat_pending){
+
+		// the registers of the internal rtc are read before masking, the DS1307 reading is only claimed under the mask
+		internal = system.clock != NULL && system_clock_get(system.clock, &date_time, &milliseconds) == SYSTEM_CLOCK_OK;
+
+		primask = critical_section_enter();
+		if(internal){
+			system_log->reads++;
+			date_time_ready(system_log, &date_time, HAL_GetTick() - milliseconds);
+		}else if(!system_log->rtc->reading){
+			system_log->rtc->reading = 1; // the interrupts do not queue a second reading
+			submit = 1;
+		}
+		critical_section_exit(primask);
+
+		if(submit && ds1307rtc_update_date_time_DMA(system_log->rtc) == DS1307_OK){
+			system_log->reads++;
+		}
+
+	}
+
+	if(dropped != system_log->reported_dropped){
+		record.tick = HAL_GetTick();
+		record.id = LOG_ID_RING_OVERFLOW;
+		record.args[0] = dropped - system_log->reported_dropped;
+		system_log->reported_dropped = dropped;
+		send_log_message(&record);
+	}
+
+	while(log_ring_pop(&system_log->ring, &record) == LOG_RING_OK){
+
+		if(record.id == LOG_ID_STATUS || record.id == LOG_ID_EVENT){
+
+			epoch_to_date_time(record.args[0], &date_time);
+			milliseconds = record.args[1];
+
+			if(system_log->mode == LOG_MODE_BINARY && record.id == LOG_ID_EVENT)
+				send_log_frame(LOG_FRAME_EVENT, UART_CHANNEL_ALARM, &date_time, milliseconds, record.args[2]);
+			else if(system_log->mode == LOG_MODE_BINARY)
+				send_log_frame(LOG_FRAME_STATUS, UART_CHANNEL_STATUS, &date_time, milliseconds, record.args[2]);
+			else if(record.id == LOG_ID_EVENT)
+				send_log_event(&date_time, milliseconds, record.args[2]);
+			else
+				send_log_status(&date_time, milliseconds, record.args[2]);
+
+		}else if(record.id < LOG_IDS){
+			send_log_message(&record);
+		}
+
+	}
+
+}
 
 /**
  * @brief	Implement the system log procedure
- * @note	Based on the system log state. It takes the buffer corresponding to the state and then transmit it over UART
- * 			It transmits, following this order:
- * 				- Date & Time
- * 				- Sensors name and state
+ * @note	Called when the rtc date and time have been updated, in the I2C interrupt. The reading anchors the
+ * 			timebase, then the pending state change and heartbeat, if any, are pushed into the log ring with the epoch
+ * 			timestamp and states, the messages are formatted and queued for the transmission over UART by
+ * 			system_log_process():
+ * 				- the state change record, on the alarm channel so that it precedes any other message
+ * 				- the heartbeat status message, on the status channel
  */
 void log_callback_tx(){
 
-	if(system.system_log->state == START_L){
-
-		prepare_date_time_buffer(); // format output_date_time_buffer
-		sprintf(msg, "%s AREA %s - BARRIER %s \n\r",(char *)output_date_time_buffer, get_state_string(get_state_pir(system.pir)), get_state_string(get_state_barrier(system.barrier)));
-		system.system_log->state = SYSTEM_STATE_T; // set the DATE_TIME_T state
-		system_log_send_message_DMA(system.system_log, (uint8_t *)msg, strlen(msg));// send the system log message
+	system_log_t *system_log = system.system_log;
 
+	if(system_log->state != START_L){
+		return;
 	}
-	else if((system.system_log->state == SYSTEM_STATE_T)){
-		system.system_log->state = START_L;
+
+	date_time_ready(system_log, &system.rtc->date_time, system.rtc->read_tick);
+
+}
+
+/**
+ * @brief	Discard the pending records after a failed rtc reading
+ * @note	Called by the rtc, in interrupt or in the main loop. The error is reported instead of the records,
+ * 			the next state change or heartbeat tries again.
+ */
+void log_callback_error(){
+
+	system_log_t *system_log = system.system_log;
+
+	if(system_log == NULL || system_log->state != START_L){
+		return;
 	}
 
+	system_log->event_pending = 0;
+	system_log->heartbeat_pending = 0;
+	system_log_event(system_log, LOG_ID_RTC_ERROR, 0, 0, 0);
+
 }
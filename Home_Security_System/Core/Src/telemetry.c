@@ -0,0 +1,199 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "telemetry.h"
+#include "system.h"
+#include "log_frame.h"
+
+/**
+ * @brief Buffer for a batch of encoded telemetry frames
+ */
+uint8_t telemetry_frames[TELEMETRY_BATCH*LOG_FRAME_SIZE(TELEMETRY_RECORD_SIZE)];
+
+/**
+ * @brief  Compute the decimation that fits the stream into the link
+ * @param  baud_rate	uart baud rate
+ * @return conversions averaged into a sample, at least 1
+ * @note   Each byte takes 10 bits; TELEMETRY_LINK_SHARE percent of them carries the frames.
+ */
+static uint16_t telemetry_decimation(uint32_t baud_rate){
+
+	uint32_t frame_rate = TELEMETRY_ADC_RATE*LOG_FRAME_SIZE(TELEMETRY_RECORD_SIZE)*10*100; // bits*100 per second without decimation
+	uint32_t link_rate = TELEMETRY_SAMPLES*baud_rate*TELEMETRY_LINK_SHARE;
+	uint32_t decimation = (frame_rate + link_rate - 1)/link_rate;
+
+	return decimation > 0 ? decimation : 1;
+}
+
+/**
+ * @brief  Write a 16 bit value, little endian
+ * @param  buffer	pointer where write the value
+ * @param  value	value to write
+ */
+static void telemetry_put_uint16(uint8_t *buffer, uint16_t value){
+
+	buffer[0] = value & 0xFF;
+	buffer[1] = value >> 8;
+
+}
+
+/**
+ * @brief  Initialize the telemetry
+ * @param  telemetry	pointer to telemetry structure
+ * @param  uart			pointer to the uart handler used to send the frames
+ */
+void init_telemetry(telemetry_t *telemetry, uart_handler_t *uart){
+
+	telemetry->active = 0;
+	telemetry->uart = uart;
+	telemetry->sequence = 0;
+	telemetry->overruns = 0;
+
+}
+
+/**
+ * @brief  Start streaming the barrier samples
+ * @param  telemetry	pointer to telemetry structure
+ * @note   The samples are produced only while the barrier converts, i.e. while it is active.
+ */
+void start_telemetry(telemetry_t *telemetry){
+
+	telemetry->active = 0;
+
+	telemetry->baud_rate = telemetry->uart->huart->Init.BaudRate;
+	telemetry->decimation = telemetry_decimation(telemetry->baud_rate);
+	telemetry->head = 0;
+	telemetry->tail = 0;
+	telemetry->count = 0;
+	telemetry->sum = 0;
+	telemetry->accumulated = 0;
+	telemetry->max_counter = 0;
+
+	telemetry->active = 1; // the ADC callback reads the fields above only when active
+
+}
+
+/**
+ * @brief  Stop streaming the barrier samples
+ * @param  telemetry	pointer to telemetry structure
+ * @note   The frames already queued are still sent.
+ */
+void stop_telemetry(telemetry_t *telemetry){
+
+	telemetry->active = 0;
+
+}
+
+/**
+ * @brief  Add a barrier conversion
+ * @param  telemetry	pointer to telemetry structure
+ * @param  value		raw conversion
+ * @param  counter		stability counter after the conversion
+ * @note   Called by HAL_ADC_ConvCpltCallback(). Every decimation conversions a sample is written into the
+ * 		   filling block; a full block is handed to the main loop and the next one of the ring is filled. If the
+ * 		   ring is full, the filled block is overwritten and counted as overrun. Nothing is sent from here.
+ */
+void telemetry_sample(telemetry_t *telemetry, uint16_t value, uint32_t counter){
+
+	telemetry_sample_t *sample;
+
+	if(!telemetry->active){
+		return;
+	}
+
+	telemetry->sum += value;
+	if(counter > telemetry->max_counter){
+		telemetry->max_counter = counter;
+	}
+
+	if(++telemetry->accumulated < telemetry->decimation){
+		return;
+	}
+
+	sample = &telemetry->blocks[telemetry->head & (TELEMETRY_BLOCKS - 1)][telemetry->count];
+	sample->value = telemetry->sum/telemetry->accumulated;
+	sample->counter = telemetry->max_counter > UINT16_MAX ? UINT16_MAX : telemetry->max_counter;
+	telemetry->sum = 0;
+	telemetry->accumulated = 0;
+	telemetry->max_counter = 0;
+
+	if(++telemetry->count < TELEMETRY_SAMPLES){
+		return;
+	}
+
+	telemetry->count = 0;
+
+	if((uint8_t)(telemetry->head - telemetry->tail) == TELEMETRY_BLOCKS - 1){ // the next block is not sent yet
+		telemetry->overruns++;
+		return;
+	}
+
+	telemetry->head++;
+
+}
+
+/**
+ * @brief  Encode a sample block
+ * @param  telemetry	pointer to telemetry structure
+ * @param  block		samples of the block
+ * @param  frame		destination, LOG_FRAME_SIZE(TELEMETRY_RECORD_SIZE) bytes
+ * @return frame size
+ */
+static uint16_t telemetry_encode(telemetry_t *telemetry, const telemetry_sample_t *block, uint8_t *frame){
+
+	uint8_t record[TELEMETRY_RECORD_SIZE];
+	uint8_t i;
+
+	record[0] = LOG_FRAME_TELEMETRY;
+	record[1] = telemetry->sequence++;
+	telemetry_put_uint16(&record[2], telemetry->decimation);
+	telemetry_put_uint16(&record[4], system.barrier->threshold);
+	telemetry_put_uint16(&record[6], system.barrier->stable_signal > UINT16_MAX ? UINT16_MAX : system.barrier->stable_signal);
+	record[8] = TELEMETRY_SAMPLES;
+	for(i = 0; i < TELEMETRY_SAMPLES; i++){
+		telemetry_put_uint16(&record[9 + 4*i], block[i].value);
+		telemetry_put_uint16(&record[11 + 4*i], block[i].counter);
+	}
+
+	return log_frame_encode(record, TELEMETRY_RECORD_SIZE, frame);
+}
+
+/**
+ * @brief  Send the filled sample blocks
+ * @param  telemetry	pointer to telemetry structure
+ * @note   Called by the main loop. The blocks are sent only once TELEMETRY_BATCH of them are filled: their frames
+ * 		   are queued together on the telemetry channel, the lowest priority one, so they leave in one DMA transfer
+ * 		   and the stream never delays the log; a batch that does not fit is counted by the channel.
+ * 		   The decimation follows the baud rate changes.
+ */
+void telemetry_process(telemetry_t *telemetry){
+
+	uint16_t size = 0;
+	uint8_t i;
+
+	if(!telemetry->active){
+		return;
+	}
+
+	if(telemetry->baud_rate != telemetry->uart->huart->Init.BaudRate){
+		start_telemetry(telemetry);
+		return;
+	}
+
+	if((uint8_t)(telemetry->head - telemetry->tail) < TELEMETRY_BATCH){
+		return;
+	}
+
+	for(i = 0; i < TELEMETRY_BATCH; i++){
+		size += telemetry_encode(telemetry, telemetry->blocks[telemetry->tail & (TELEMETRY_BLOCKS - 1)], telemetry_frames + size);
+		telemetry->tail++; // the block can be filled again
+	}
+
+	uart_handler_enqueue_message(telemetry->uart, UART_CHANNEL_TELEMETRY, telemetry_frames, size);
+
+}
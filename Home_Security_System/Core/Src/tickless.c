@@ -0,0 +1,216 @@
+/*
+ * tickless.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include "tickless.h"
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief  Initialize the tickless idle
+ * @param  tickless		pointer to tickless structure
+ * @param  clock		internal rtc, it times the stops and ends the ones shorter than a second
+ * @param  wheel		timer wheel advanced by the tick
+ * @param  kernel		kernel advanced by the tick
+ * @param  wake_lines	EXTI lines of the wakeup sources that do not interrupt while the core runs
+ * @param  compensate	compensation of the caller, NULL if none
+ * @note   The stop mode keeps the low power regulator on. The DWT cycle counter, started by the idle meter,
+ * 		   measures the wake latency.
+ */
+void init_tickless(tickless_t *tickless, system_clock_t *clock, timer_wheel_t *wheel, kernel_t *kernel, uint32_t wake_lines, tickless_callback_t compensate){
+
+	tickless->clock = clock;
+	tickless->wheel = wheel;
+	tickless->kernel = kernel;
+	tickless->wake_lines = wake_lines;
+	tickless->compensate = compensate;
+
+	tickless->carry = 0;
+	tickless->stops = 0;
+	tickless->stopped = 0;
+	tickless->wake = 0;
+	tickless->waking = 0;
+	tickless->wake_cycles = 0;
+	tickless->wake_cycles_max = 0;
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR = (PWR->CR & ~PWR_CR_FPDS) | PWR_CR_LPDS; // the wakeup time of TICKLESS_STOP_WAKEUP_US
+
+	EXTI->IMR &= ~wake_lines;
+
+}
+
+/**
+ * @brief  Compute the first deadline
+ * @param  tickless		pointer to tickless structure
+ * @return ms to the first expiry of the virtual timers and to the first timeout of the tasks
+ */
+uint32_t tickless_deadline(tickless_t *tickless){
+
+	uint32_t wheel = timer_wheel_next_expiry(tickless->wheel);
+	uint32_t kernel = kernel_next_timeout(tickless->kernel);
+
+	return wheel < kernel ? wheel : kernel;
+}
+
+/**
+ * @brief  Advance the timer wheel by the ticks lost
+ * @param  wheel	pointer to timer wheel structure
+ * @param  ticks	ticks lost
+ * @note   The ticks before the first expiry are skipped at once. A stop ends at the deadline, so only the
+ * 		   ticks of its wakeup overshoot run one at a time and call the callbacks they expire.
+ */
+static void compensate_wheel(timer_wheel_t *wheel, uint32_t ticks){
+
+	uint32_t next = timer_wheel_next_expiry(wheel);
+
+	if(ticks < next){
+		timer_wheel_skip(wheel, ticks);
+		return;
+	}
+
+	timer_wheel_skip(wheel, next - 1);
+	for(ticks -= next - 1; ticks > 0; ticks--){
+		timer_wheel_tick(wheel);
+	}
+
+}
+
+/**
+ * @brief  Stop the core up to the deadline
+ * @param  tickless		pointer to tickless structure
+ * @param  deadline		ms the core can stay stopped
+ * @return TICKLESS_OK if the core has stopped, TICKLESS_ERR if the deadline is too close or the rtc can not end the stop
+ * @note   Called with the interrupts masked, so the stop is left before the handler of the wakeup source runs.
+ * 		   The wakeup timer of the rtc ends the stop at each second, alarm B ends a shorter one and the EXTI lines
+ * 		   end it at the edges of the sensors, of the keypad and of the wake lines. The registers are written here
+ * 		   instead of calling HAL_PWR_EnterSTOPMode(): its SEV and double WFE clear the event of an interrupt
+ * 		   already pending, so the core would stop with work queued. Such an event ends the stop at once.
+ * 		   The SysTick is frozen from the first rtc reading to the last one, then the ms elapsed, with the fraction
+ * 		   carried by the previous stops, are added to the HAL tick, to the timer wheel, to the kernel and to the
+ * 		   compensation of the caller. The resolution is one period of the sub-second counter, 1/256 s.
+ * 		   The cycle counter is stopped with the clocks, so the wake latency is counted from the first
+ * 		   instruction after the stop to tickless_wake_end(), called by the caller before it enables the interrupts:
+ * 		   the handler of the wakeup source, pending, is entered then.
+ */
+int8_t tickless_stop(tickless_t *tickless, uint32_t deadline){
+
+	system_clock_t *clock = tickless->clock;
+	uint32_t second = clock->prediv_s + 1; // sub-second periods in a second
+	uint32_t start, end, periods, elapsed, fraction;
+	int8_t timeout = 0;
+
+	if(deadline < TICKLESS_MIN_STOP || !system_clock_is_internal(clock)){
+		return TICKLESS_ERR;
+	}
+
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+	start = system_clock_periods(clock);
+
+	if(deadline < 1000){ // a longer stop is ended by the wakeup timer, at the next second
+		periods = deadline*second/1000;
+		if(periods < second - start % second){
+			if(system_clock_start_timeout(clock, start + periods) != SYSTEM_CLOCK_OK){
+				SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+				return TICKLESS_ERR;
+			}
+			timeout = 1;
+		}
+	}
+
+	EXTI->PR = tickless->wake_lines; // edges seen while the core was running
+	EXTI->IMR |= tickless->wake_lines;
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+	__DSB();
+	__WFE();
+
+	tickless->wake = DWT->CYCCNT;
+
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+	EXTI->IMR &= ~tickless->wake_lines; // a pending edge is handled once the interrupts are enabled
+
+	if(timeout){
+		system_clock_stop_timeout(clock);
+	}
+
+	if(system_clock_resync(clock) == SYSTEM_CLOCK_OK){
+		end = system_clock_periods(clock);
+		elapsed = system_clock_elapsed(clock, start, end);
+	}else{
+		elapsed = 0; // the shadow registers still hold the time of the stop entry
+	}
+
+	fraction = (elapsed % second)*1000 + tickless->carry;
+	elapsed = (elapsed / second)*1000 + fraction / second;
+	tickless->carry = fraction % second;
+
+	uwTick += elapsed;
+	compensate_wheel(tickless->wheel, elapsed);
+	kernel_skip(tickless->kernel, elapsed);
+	if(tickless->compensate != NULL){
+		tickless->compensate(elapsed);
+	}
+
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+	tickless->stops++;
+	tickless->stopped += elapsed;
+	tickless->waking = 1;
+
+	return TICKLESS_OK;
+}
+
+/**
+ * @brief  End the measure of the wake latency
+ * @param  tickless		pointer to tickless structure
+ * @note   Called with the interrupts still masked, as the last step before they are enabled: the exception entry
+ * 		   of the pending handler follows. Nothing is measured if no stop has ended since the previous call.
+ */
+void tickless_wake_end(tickless_t *tickless){
+
+	if(!tickless->waking){
+		return;
+	}
+
+	tickless->waking = 0;
+	tickless->wake_cycles = DWT->CYCCNT - tickless->wake + TICKLESS_EXCEPTION_ENTRY_CYCLES;
+	if(tickless->wake_cycles > tickless->wake_cycles_max){
+		tickless->wake_cycles_max = tickless->wake_cycles;
+	}
+
+}
+
+/**
+ * @brief  Get the wake latency of the last stop
+ * @param  tickless		pointer to tickless structure
+ * @return latency in us, from the wakeup event to the entry of its handler, 0 before the first stop
+ * @note   The measured cycles are added to TICKLESS_STOP_WAKEUP_US, the part the cycle counter cannot see.
+ */
+uint32_t tickless_wake_us(tickless_t *tickless){
+
+	if(tickless->stops == 0){
+		return 0;
+	}
+
+	return TICKLESS_STOP_WAKEUP_US + tickless->wake_cycles / (SystemCoreClock / 1000000);
+
+}
+
+/**
+ * @brief  Get the highest wake latency
+ * @param  tickless		pointer to tickless structure
+ * @return latency in us, from the wakeup event to the entry of its handler, 0 before the first stop
+ */
+uint32_t tickless_wake_max_us(tickless_t *tickless){
+
+	if(tickless->stops == 0){
+		return 0;
+	}
+
+	return TICKLESS_STOP_WAKEUP_US + tickless->wake_cycles_max / (SystemCoreClock / 1000000);
+
+}
@@ -0,0 +1,192 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+
+#include "timebase.h"
+#include "critical_section.h"
+#include "epoch.h"
+
+/**
+ * @brief  Initialize the timebase
+ * @param  timebase		pointer to timebase structure
+ */
+void timebase_init(timebase_t *timebase){
+
+	timebase->valid = 0;
+	timebase->square_wave = 0;
+	timebase->edges = 0;
+	timebase->drift = 0;
+	timebase->drift_interval = 0;
+	timebase->last_correction = 0;
+	timebase->resyncs = 0;
+
+}
+
+/**
+ * @brief  Anchor the timebase to a rtc reading
+ * @param  timebase		pointer to timebase structure
+ * @param  date_time	date time read from the rtc
+ * @param  tick			HAL tick of the reading start, when the rtc latches its registers
+ * @return correction applied to the anchor, in seconds
+ * @note   Called on each rtc reading, in interrupt. If the rtc agrees with the second predicted by the tick,
+ * 		   the anchor keeps its millisecond phase; otherwise it is moved to the reading, and the next square
+ * 		   wave edge restores the phase. The reading can precede the last edge, so the prediction is rounded
+ * 		   toward the past. The drift between the tick and the rtc is measured from the first reading, so its
+ * 		   resolution of one second becomes a smaller error as the interval grows.
+ */
+int32_t timebase_sync(timebase_t *timebase, date_time_t *date_time, uint32_t tick){
+
+	epoch_t rtc_seconds = epoch_from_date_time(date_time);
+	int32_t delta;
+	int32_t elapsed;
+	int32_t correction;
+
+	if(!timebase->valid){
+		timebase->anchor_seconds = rtc_seconds;
+		timebase->anchor_tick = tick;
+		epoch_to_date_time(rtc_seconds, &timebase->date_time);
+		timebase->reference_seconds = rtc_seconds;
+		timebase->reference_tick = tick;
+		timebase->valid = 1;
+		return 0;
+	}
+
+	delta = (int32_t)(tick - timebase->anchor_tick);
+	elapsed = delta/1000 - (delta%1000 < 0);
+	correction = (int32_t)(rtc_seconds - (timebase->anchor_seconds + elapsed));
+
+	if(correction == 0 && elapsed > 0){
+		timebase->anchor_seconds += elapsed; // move the anchor forward, keeping the phase
+		timebase->anchor_tick += elapsed*1000;
+		epoch_to_date_time(timebase->anchor_seconds, &timebase->date_time);
+	}else if(correction != 0){
+		timebase->anchor_seconds = rtc_seconds;
+		timebase->anchor_tick = tick;
+		epoch_to_date_time(rtc_seconds, &timebase->date_time);
+		timebase->square_wave = 0;
+		timebase->resyncs++;
+	}
+
+	timebase->last_correction = correction;
+	timebase->drift_interval = rtc_seconds - timebase->reference_seconds;
+	timebase->drift = (int32_t)((tick - timebase->reference_tick) - timebase->drift_interval*1000);
+
+	return correction;
+}
+
+/**
+ * @brief  Advance the timebase by one second
+ * @param  timebase		pointer to timebase structure
+ * @param  tick			HAL tick of the square wave edge
+ * @note   Called in the EXTI interrupt of the rtc square wave, at the edge where the rtc increments its
+ * 		   seconds: the anchor follows the rtc without any I2C transaction, and the date time of the
+ * 		   current second is kept ready. Nothing is done before the first reading.
+ */
+void timebase_second(timebase_t *timebase, uint32_t tick){
+
+	if(!timebase->valid){
+		return;
+	}
+
+	timebase->anchor_seconds++;
+	timebase->anchor_tick = tick;
+	epoch_to_date_time(timebase->anchor_seconds, &timebase->date_time);
+	timebase->square_wave = 1;
+	timebase->edges++;
+
+}
+
+/**
+ * @brief  Check if the square wave keeps the timebase in phase with the rtc
+ * @param  timebase		pointer to timebase structure
+ * @param  tick			current HAL tick
+ * @return 1 if the last edge is recent, 0 if the timebase is extrapolated from the tick
+ */
+uint8_t timebase_locked(timebase_t *timebase, uint32_t tick){
+
+	return timebase->valid && timebase->square_wave && (tick - timebase->anchor_tick) < TIMEBASE_SQW_TIMEOUT;
+
+}
+
+/**
+ * @brief  Convert a tick into date time and milliseconds
+ * @param  timebase		pointer to timebase structure
+ * @param  tick			HAL tick, it can precede the anchor
+ * @param  date_time	pointer where store the date time
+ * @param  milliseconds	pointer where store the milliseconds [0-999]
+ * @return operation result, TIMEBASE_ERR if the timebase has never been synced
+ * @note   A tick inside the anchor second, the common case, is a copy of the kept date time.
+ * 		   The anchor is copied with the interrupts disabled, because the interrupts move it.
+ */
+int8_t timebase_get(timebase_t *timebase, uint32_t tick, date_time_t *date_time, uint16_t *milliseconds){
+
+	uint32_t primask;
+	epoch_t anchor_seconds;
+	int32_t delta;
+	int32_t seconds;
+	int32_t remainder;
+
+	if(!timebase->valid){
+		return TIMEBASE_ERR;
+	}
+
+	primask = critical_section_enter();
+	anchor_seconds = timebase->anchor_seconds;
+	delta = (int32_t)(tick - timebase->anchor_tick);
+	*date_time = timebase->date_time;
+	critical_section_exit(primask);
+
+	seconds = delta/1000;
+	remainder = delta%1000;
+	if(remainder < 0){ // round toward the past for the ticks preceding the anchor
+		seconds--;
+		remainder += 1000;
+	}
+
+	if(seconds != 0){
+		epoch_to_date_time(anchor_seconds + seconds, date_time);
+	}
+	*milliseconds = remainder;
+
+	return TIMEBASE_OK;
+}
+
+/**
+ * @brief  Convert a tick into epoch seconds and milliseconds
+ * @param  timebase		pointer to timebase structure
+ * @param  tick			HAL tick, it can precede the anchor
+ * @param  seconds		pointer where store the epoch seconds
+ * @param  milliseconds	pointer where store the milliseconds [0-999]
+ * @return operation result, TIMEBASE_ERR if the timebase has never been synced
+ * @note   No calendar conversion: it is the timestamp of the log records pushed in interrupt.
+ */
+int8_t timebase_get_epoch(timebase_t *timebase, uint32_t tick, epoch_t *seconds, uint16_t *milliseconds){
+
+	uint32_t primask;
+	epoch_t anchor_seconds;
+	int32_t delta;
+	int32_t remainder;
+
+	if(!timebase->valid){
+		return TIMEBASE_ERR;
+	}
+
+	primask = critical_section_enter();
+	anchor_seconds = timebase->anchor_seconds;
+	delta = (int32_t)(tick - timebase->anchor_tick);
+	critical_section_exit(primask);
+
+	remainder = delta%1000;
+	*seconds = anchor_seconds + delta/1000;
+	if(remainder < 0){ // round toward the past for the ticks preceding the anchor
+		(*seconds)--;
+		remainder += 1000;
+	}
+	*milliseconds = remainder;
+
+	return TIMEBASE_OK;
+}
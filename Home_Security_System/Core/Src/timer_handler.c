@@ -61,49 +61,18 @@ void reset_timer_counter(TIM_HandleTypeDef *timer){
 }
 
 
-int pending_bit=0;
-
 /**
  * @brief   Period Elpased callback redefinition
  * @param   timer pointer to the HAL timer peripheral structure
  * @return  void
+ * @note    The protocol timeout, the log heartbeat, the sensor delays and the alarm duration are virtual
+ * 			timers of the timer wheel, TIM10 and TIM11 are free.
  */
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim){
 
-	if(htim->Instance == TIM10 && system.protocol->state != END_CUSTOM && system.protocol->state != END_DEFAULT){ // check if the protocol is running
-		HAL_UART_Abort_IT(&huart2); // abort uart transmission and receiving operations
-		system.protocol->state = END_DEFAULT; // set the protocol' state to END_DEFAULT
-		stop_timer_IT(system.protocol->timer); // stop the timer
-	}
-	else if(htim->Instance == TIM10 && system.system_log->state == START_L ){
-		// check if the system_log is running
-		start_send_log_message(system.system_log); // start the system_log send message procedure
-
-	}
-	else if(htim->Instance == TIM11){
-		if(pending_bit==1){
-			if(system.state != SYSTEM_ALARMED && (get_state_pir(system.pir) == SENSOR_ALARMED || get_state_barrier(system.barrier) == SENSOR_ALARMED)){ // delay time elapsed
-				// check if the system is not alarmed and one of the two sensor is alarmed, this represent delay time elapsed
-				stop_timer_IT(&htim11); // stop time
-				if(get_state_pir(system.pir) == SENSOR_ALARMED && get_state_barrier(system.barrier) == SENSOR_ALARMED)// delay time is elapsed and both modules are alarmed
-					alarm_system(&system, BOTH_PULSE);
-				else if(get_state_pir(system.pir) == SENSOR_ALARMED) // delay time for pir elapsed
-					alarm_system(&system, system.pir->pulse);
-				else if(get_state_barrier(system.barrier) == SENSOR_ALARMED)// delay time for barrier elapsed
-					alarm_system(&system, system.barrier->pulse);
-
-			}
-			else if(system.state == SYSTEM_ALARMED){ // duration time elapsed
-				// check if the system state is ALARMED
-				stop_timer_IT(&htim11);
-				dealarm_system(&system); // call dealarm procedure
-			}
-			//pending_bit=0;
-		}else pending_bit=1;
-	}
-	else if(htim->Instance == TIM1 && get_state_pir(system.pir) == SENSOR_ACTIVE){ // pir stability signal timer elapsed
+	if(htim->Instance == TIM1){ // pir stability signal timer elapsed
 		stop_timer_IT(&htim1);
-		alarm_pir(system.pir); // call the alarm pir procedure
+		post_system_event(EVENT_PIR_STABLE, 0); // the alarm pir procedure runs from the alarm task
 	}
 	else if(htim->Instance == TIM2 && system.state == SYSTEM_ACTIVE){ // toggle led if the system is active
 		toggle_system_led();
@@ -0,0 +1,227 @@
+/*
+ * timer_wheel.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: 2017
+ */
+
+#include "timer_wheel.h"
+#include "critical_section.h"
+#include "string.h"
+
+/**
+ * @brief  Queue a timer at the head of a list
+ * @param  list		pointer to the head of the list
+ * @param  timer	pointer to the timer, not queued
+ */
+static void link_timer(virtual_timer_t **list, virtual_timer_t *timer){
+
+	timer->next = *list;
+	if(timer->next != NULL){
+		timer->next->link = &timer->next;
+	}
+	timer->link = list;
+	*list = timer;
+
+}
+
+/**
+ * @brief  Remove a timer from its list
+ * @param  timer	pointer to the timer, queued
+ */
+static void unlink_timer(virtual_timer_t *timer){
+
+	*timer->link = timer->next;
+	if(timer->next != NULL){
+		timer->next->link = timer->link;
+	}
+	timer->link = NULL;
+
+}
+
+/**
+ * @brief  Queue a timer into the slot of its expiry
+ * @param  wheel	pointer to timer wheel structure
+ * @param  timer	pointer to the timer, not queued
+ * @param  ticks	ticks from now to the expiry, at least 1
+ * @note   The slot is visited once per turn: the timer expires at the visit that finds its rounds at 0.
+ */
+static void schedule_timer(timer_wheel_t *wheel, virtual_timer_t *timer, uint32_t ticks){
+
+	timer->rounds = (ticks - 1) / TIMER_WHEEL_SLOTS;
+
+	link_timer(&wheel->slots[(wheel->now + ticks) & TIMER_WHEEL_MASK], timer);
+
+}
+
+/**
+ * @brief  Initialize the timer wheel
+ * @param  wheel	pointer to timer wheel structure
+ * @note   A zero filled wheel is initialized too, so the tick interrupt can run before this call.
+ */
+void init_timer_wheel(timer_wheel_t *wheel){
+
+	uint32_t primask = critical_section_enter();
+
+	memset(wheel, 0, sizeof(*wheel));
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief  Initialize a virtual timer
+ * @param  timer		pointer to virtual timer structure
+ * @param  callback		function called at each expiry
+ */
+void init_virtual_timer(virtual_timer_t *timer, virtual_timer_callback_t callback){
+
+	timer->next = NULL;
+	timer->link = NULL;
+	timer->rounds = 0;
+	timer->period = 0;
+	timer->callback = callback;
+
+}
+
+/**
+ * @brief  Start, or restart, a timer
+ * @param  wheel	pointer to timer wheel structure
+ * @param  timer	pointer to virtual timer structure
+ * @param  delay	ticks to the first expiry, 0 is taken as 1
+ * @param  period	ticks between the next expiries, 0 for a one shot timer
+ * @note   Constant time: the timer is unlinked from its slot, if running, and linked at the head of the new one.
+ * 		   It can be called from any interrupt and from the main loop.
+ */
+void timer_wheel_start(timer_wheel_t *wheel, virtual_timer_t *timer, uint32_t delay, uint32_t period){
+
+	uint32_t primask = critical_section_enter();
+
+	if(timer->link != NULL){
+		unlink_timer(timer);
+	}
+
+	timer->period = period;
+	schedule_timer(wheel, timer, delay > 0 ? delay : 1);
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief  Stop a timer
+ * @param  timer	pointer to virtual timer structure
+ * @note   Constant time. A timer expired by the current tick and stopped by the callback of another one is
+ * 		   removed from the expired list, so its callback is not called.
+ */
+void timer_wheel_stop(virtual_timer_t *timer){
+
+	uint32_t primask = critical_section_enter();
+
+	if(timer->link != NULL){
+		unlink_timer(timer);
+	}
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief  Check if a timer is running
+ * @param  timer	pointer to virtual timer structure
+ * @return 1 if the timer is queued, 0 otherwise
+ */
+uint8_t timer_wheel_is_running(virtual_timer_t *timer){
+
+	return timer->link != NULL;
+
+}
+
+/**
+ * @brief  Advance the wheel by one tick
+ * @param  wheel	pointer to timer wheel structure
+ * @note   Called by the tick interrupt. Only the slot of the new tick is visited: its expired timers are moved
+ * 		   to the expired list first, then their callbacks are called one at a time, so a callback can start or
+ * 		   stop any timer. A periodic timer is queued again before its callback.
+ */
+void timer_wheel_tick(timer_wheel_t *wheel){
+
+	virtual_timer_t *timer, *next;
+
+	wheel->now++;
+
+	for(timer = wheel->slots[wheel->now & TIMER_WHEEL_MASK]; timer != NULL; timer = next){
+		next = timer->next;
+		if(timer->rounds == 0){
+			unlink_timer(timer);
+			link_timer(&wheel->expired, timer);
+		}else{
+			timer->rounds--;
+		}
+	}
+
+	while((timer = wheel->expired) != NULL){
+		unlink_timer(timer);
+		if(timer->period > 0){
+			schedule_timer(wheel, timer, timer->period);
+		}
+		wheel->expiries++;
+		timer->callback();
+	}
+
+}
+
+/**
+ * @brief  Compute the first expiry
+ * @param  wheel	pointer to timer wheel structure
+ * @return ticks from now to the first expiry, at least 1, TIMER_WHEEL_IDLE if no timer is running
+ * @note   Each slot is visited from the next tick on: a timer of the slot at distance d expires after
+ * 		   d + rounds * TIMER_WHEEL_SLOTS ticks. It walks the whole wheel, so it is meant for the idle time.
+ */
+uint32_t timer_wheel_next_expiry(timer_wheel_t *wheel){
+
+	virtual_timer_t *timer;
+	uint32_t next = TIMER_WHEEL_IDLE;
+	uint32_t distance, ticks;
+	uint32_t primask = critical_section_enter();
+
+	for(distance = 1; distance <= TIMER_WHEEL_SLOTS; distance++){
+		for(timer = wheel->slots[(wheel->now + distance) & TIMER_WHEEL_MASK]; timer != NULL; timer = timer->next){
+			ticks = distance + timer->rounds*TIMER_WHEEL_SLOTS;
+			if(ticks < next){
+				next = ticks;
+			}
+		}
+	}
+
+	critical_section_exit(primask);
+
+	return next;
+}
+
+/**
+ * @brief  Advance the wheel by some ticks at once
+ * @param  wheel	pointer to timer wheel structure
+ * @param  ticks	ticks to advance, fewer than the ones returned by timer_wheel_next_expiry()
+ * @note   Same result of ticks calls of timer_wheel_tick(), none of which expires a timer: the slot at distance
+ * 		   d is visited 1 + (ticks - d) / TIMER_WHEEL_SLOTS times, if ticks >= d, and each visit takes a round from
+ * 		   its timers. It compensates the ticks lost by the stop mode.
+ */
+void timer_wheel_skip(timer_wheel_t *wheel, uint32_t ticks){
+
+	virtual_timer_t *timer;
+	uint32_t distance, visits;
+	uint32_t primask = critical_section_enter();
+
+	for(distance = 1; distance <= TIMER_WHEEL_SLOTS && distance <= ticks; distance++){
+		visits = 1 + (ticks - distance) / TIMER_WHEEL_SLOTS;
+		for(timer = wheel->slots[(wheel->now + distance) & TIMER_WHEEL_MASK]; timer != NULL; timer = timer->next){
+			timer->rounds -= visits;
+		}
+	}
+
+	wheel->now += ticks;
+
+	critical_section_exit(primask);
+
+}
@@ -12,6 +12,69 @@
 #include "string.h"
 #include "system.h"
 #include "system_log.h"
+#include "critical_section.h"
+
+/**
+ * @brief Channels buffer sizes, they must be powers of two
+ */
+#define ALARM_QUEUE_SIZE (256)
+#define FEEDBACK_QUEUE_SIZE (256)
+#define STATUS_QUEUE_SIZE (256)
+#define DIAGNOSTIC_QUEUE_SIZE (512)
+#define TELEMETRY_QUEUE_SIZE (512)
+
+/**
+ * @brief Maximum bytes sent by a single DMA transfer of the lower priority channels.
+ * 		  A pending alarm waits at most the transmission of one of these transfers, which are further limited to
+ * 		  ALARM_MAX_WAIT_MS of line time: large transfers at the high baud rates, a few interrupts per second
+ * 		  while the telemetry streams, short ones at the low baud rates, where an alarm would wait longer.
+ */
+#define FEEDBACK_MAX_TRANSFER (64)
+#define STATUS_MAX_TRANSFER (256)
+#define DIAGNOSTIC_MAX_TRANSFER (256)
+#define TELEMETRY_MAX_TRANSFER (256)
+#define ALARM_MAX_WAIT_MS (4)
+#define MIN_TRANSFER (16)
+
+/**
+ * @brief Supported baud rates.
+ * 		  With the 16 MHz peripheral clock and oversampling by 16 the error is below 1% up to 460800;
+ * 		  921600 is generated as 941176 (+2.1%), it needs a short cable and a tolerant adapter.
+ */
+const uint32_t uart_baud_rates[UART_BAUD_RATES] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+
+/**
+ * @brief Channels buffers
+ */
+uint8_t alarm_queue_buffer[ALARM_QUEUE_SIZE];
+uint8_t feedback_queue_buffer[FEEDBACK_QUEUE_SIZE];
+uint8_t status_queue_buffer[STATUS_QUEUE_SIZE];
+uint8_t diagnostic_queue_buffer[DIAGNOSTIC_QUEUE_SIZE];
+uint8_t telemetry_queue_buffer[TELEMETRY_QUEUE_SIZE];
+
+/**
+ * @brief 	Initialize a transmission channel
+ * @param 	queue 			pointer to the channel queue
+ * @param 	buffer 			channel buffer
+ * @param 	size 			buffer size, power of two
+ * @param 	max_transfer 	maximum bytes sent by a single DMA transfer
+ * @param 	policy 			what the channel does with a new message when it is full
+ */
+static void uart_tx_queue_init(uart_tx_queue_t *queue, uint8_t *buffer, uint16_t size, uint16_t max_transfer, uart_policy_t policy){
+
+	queue->buffer = buffer;
+	queue->size = size;
+	queue->max_transfer = max_transfer;
+	queue->policy = policy;
+	queue->head = 0;
+	queue->tail = 0;
+	queue->sent = 0;
+	queue->message_head = 0;
+	queue->message_tail = 0;
+	queue->dropped = 0;
+	queue->errors = 0;
+
+}
 
 
 /**
@@ -23,6 +86,102 @@
 void uart_handler_init(uart_handler_t *uart_handler, UART_HandleTypeDef *huart){
 
 	uart_handler->huart = huart;
+
+	uart_handler->active_channel = -1;
+	uart_handler->in_flight = 0;
+
+	uart_handler->rx_position = 0;
+	uart_handler->rx_callback = NULL;
+
+	uart_handler->pending_baud_rate = 0;
+	uart_handler->reconfiguring = 0;
+
+	uart_handler->rx_tick = 0;
+
+	// alarms are never overwritten, old status lines are replaced by the newest ones
+	uart_tx_queue_init(&(uart_handler->tx_queue[UART_CHANNEL_ALARM]), alarm_queue_buffer, ALARM_QUEUE_SIZE, ALARM_QUEUE_SIZE, UART_POLICY_DROP);
+	uart_tx_queue_init(&(uart_handler->tx_queue[UART_CHANNEL_FEEDBACK]), feedback_queue_buffer, FEEDBACK_QUEUE_SIZE, FEEDBACK_MAX_TRANSFER, UART_POLICY_DROP);
+	uart_tx_queue_init(&(uart_handler->tx_queue[UART_CHANNEL_STATUS]), status_queue_buffer, STATUS_QUEUE_SIZE, STATUS_MAX_TRANSFER, UART_POLICY_OVERWRITE);
+	uart_tx_queue_init(&(uart_handler->tx_queue[UART_CHANNEL_DIAGNOSTIC]), diagnostic_queue_buffer, DIAGNOSTIC_QUEUE_SIZE, DIAGNOSTIC_MAX_TRANSFER, UART_POLICY_DROP);
+	uart_tx_queue_init(&(uart_handler->tx_queue[UART_CHANNEL_TELEMETRY]), telemetry_queue_buffer, TELEMETRY_QUEUE_SIZE, TELEMETRY_MAX_TRANSFER, UART_POLICY_DROP);
+}
+
+/**
+ * @brief 	Discard the oldest pending message of the channel
+ * @param 	queue 		pointer to the channel queue
+ * @param 	in_transfer	1 if the channel is under DMA transfer
+ * @return 	UART_ERR if the oldest message is already under transmission
+ */
+static int8_t uart_tx_queue_discard_oldest(uart_tx_queue_t *queue, uint8_t in_transfer){
+
+	if(queue->message_tail == queue->message_head || queue->sent != 0 || in_transfer){
+		return UART_ERR;
+	}
+
+	queue->tail += queue->lengths[queue->message_tail & (UART_TX_MESSAGES - 1)];
+	queue->message_tail += 1;
+	queue->dropped += 1;
+
+	return UART_OK;
+}
+
+/**
+ * @brief 	Start the DMA transfer of the highest priority queued bytes, if the uart isn't already transmitting
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @note	It must be called with the interrupts disabled.
+ * 			The messages queued in the same channel are sent together, the transfer is limited by
+ * 			the buffer end and by the channel max_transfer, so a lower priority channel can't delay
+ * 			a higher priority one for more than one of its transfers. Below the alarm channel the transfer
+ * 			is also limited to ALARM_MAX_WAIT_MS at the current baud rate, 10 bits for each byte.
+ */
+static void uart_handler_start_transfer(uart_handler_t *uart_handler){
+
+	uart_tx_queue_t *queue;
+	uint16_t position;
+	uint16_t length = 0;
+	uint32_t line_limit;
+	int8_t channel;
+
+	if(uart_handler->active_channel >= 0 || uart_handler->reconfiguring){
+		return; // the uart is transmitting or changing its baud rate
+	}
+
+	for(channel = 0; channel < UART_CHANNELS; channel++){ // look for the highest priority pending channel
+		queue = &(uart_handler->tx_queue[channel]);
+		length = (uint16_t)(queue->head - queue->tail);
+		if(length != 0){
+			break;
+		}
+	}
+
+	if(length == 0){
+		return; // nothing to send
+	}
+
+	position = queue->tail & (queue->size - 1);
+
+	if(length > queue->size - position){
+		length = queue->size - position; // send up to the buffer end, the rest is sent by the next transfer
+	}
+	if(length > queue->max_transfer){
+		length = queue->max_transfer;
+	}
+	if(channel != UART_CHANNEL_ALARM){
+		line_limit = uart_handler->huart->Init.BaudRate / (10 * 1000 / ALARM_MAX_WAIT_MS);
+		if(line_limit < MIN_TRANSFER){
+			line_limit = MIN_TRANSFER;
+		}
+		if(length > line_limit){
+			length = line_limit;
+		}
+	}
+
+	if(HAL_UART_Transmit_DMA(uart_handler->huart, queue->buffer + position, length) == HAL_OK){
+		uart_handler->active_channel = channel;
+		uart_handler->in_flight = length;
+	}
+	// otherwise the handle is locked, the bytes stay queued and they are sent by the next enqueue or tx callback
+
 }
 
 /**
@@ -66,25 +225,369 @@ int8_t uart_handler_send_message_DMA(uart_handler_t *uart_handler, uint8_t *buff
 }
 
 /**
- * @brief 	Send buffer with buffer_size through the uart managed by uart_handler, in blocking-mode
+ * @brief 	Copy buffer with buffer_size into the transmission queue of the given channel
  * @param 	uart_handler pointer to the uart_handler structure
+ * @param 	channel	transmission channel, it sets the message priority
  * @param 	buffer data to send over uart
  * @param 	buffer_size amount of bytes to send
+ * @return 	the operation result, UART_ERR if the message has been dropped
+ * @note	It never waits for the uart and it can be called from any interrupt.
+ * 			The message is copied, so the caller can reuse buffer as soon as the function returns.
+ * 			If the uart is idle the DMA transfer starts immediately, otherwise the message is sent
+ * 			when all the higher priority channels are empty.
+ * 			When the channel is full the message is handled following the channel policy.
+ */
+int8_t uart_handler_enqueue_message(uart_handler_t *uart_handler, uart_channel_t channel, uint8_t *buffer, int16_t buffer_size){
+
+	uart_tx_queue_t *queue = &(uart_handler->tx_queue[channel]);
+	uint16_t position;
+	uint16_t first_part;
+	uint32_t primask;
+
+	if(buffer_size <= 0){
+		return UART_OK;
+	}
+
+	primask = critical_section_enter();
+
+	if(buffer_size > queue->size){
+		queue->dropped += 1; // the message can't fit the channel at all
+		critical_section_exit(primask);
+		return UART_ERR;
+	}
+
+	while(buffer_size > queue->size - (uint16_t)(queue->head - queue->tail)
+			|| (uint8_t)(queue->message_head - queue->message_tail) == UART_TX_MESSAGES){
+		// not enough space for the message
+		if(queue->policy != UART_POLICY_OVERWRITE || uart_tx_queue_discard_oldest(queue, uart_handler->active_channel == (int8_t)channel) != UART_OK){
+			queue->dropped += 1; // the whole message is discarded
+			critical_section_exit(primask);
+			return UART_ERR;
+		}
+	}
+
+	position = queue->head & (queue->size - 1);
+	first_part = queue->size - position;
+
+	if(first_part >= buffer_size){
+		memcpy(queue->buffer + position, buffer, buffer_size);
+	}else{
+		memcpy(queue->buffer + position, buffer, first_part); // fill up to the buffer end
+		memcpy(queue->buffer, buffer + first_part, buffer_size - first_part); // wrap around
+	}
+
+	queue->head += buffer_size;
+	queue->lengths[queue->message_head & (UART_TX_MESSAGES - 1)] = buffer_size;
+	queue->message_head += 1;
+
+	uart_handler_start_transfer(uart_handler);
+
+	critical_section_exit(primask);
+
+	return UART_OK;
+}
+
+/**
+ * @brief 	Release the bytes sent by the last DMA transfer and start the transfer of the highest priority queued ones
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @note	It is called by the transmission completed callback
+ */
+void uart_handler_tx_callback(uart_handler_t *uart_handler){
+
+	uart_tx_queue_t *queue;
+	uint16_t length;
+	uint32_t primask = critical_section_enter();
+
+	if(uart_handler->active_channel >= 0){
+
+		queue = &(uart_handler->tx_queue[uart_handler->active_channel]);
+		queue->tail += uart_handler->in_flight;
+		queue->sent += uart_handler->in_flight;
+
+		// release the messages completely transmitted
+		while(queue->message_tail != queue->message_head){
+			length = queue->lengths[queue->message_tail & (UART_TX_MESSAGES - 1)];
+			if(queue->sent < length){
+				break;
+			}
+			queue->sent -= length;
+			queue->message_tail += 1;
+		}
+
+		uart_handler->active_channel = -1;
+		uart_handler->in_flight = 0;
+	}
+
+	uart_handler_start_transfer(uart_handler);
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief 	Handle a DMA transfer ended by a transmission error
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @note	It is called by the error callback. The error is counted in the channel. The alarm bytes are kept
+ * 			and sent again by the next transfer; the bytes of the other channels are released as if they
+ * 			were sent, like the messages dropped by a full channel.
+ */
+void uart_handler_tx_error(uart_handler_t *uart_handler){
+
+	uint32_t primask = critical_section_enter();
+
+	if(uart_handler->active_channel >= 0){
+		uart_handler->tx_queue[uart_handler->active_channel].errors += 1;
+		if(uart_handler->active_channel == UART_CHANNEL_ALARM){
+			uart_handler->active_channel = -1;
+			uart_handler->in_flight = 0;
+		}
+	}
+
+	uart_handler_tx_callback(uart_handler);
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief 	Start the continuous reception in circular DMA mode
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @param 	rx_callback function that receives the incoming bytes
  * @return 	the operation result
+ * @note	The DMA writes the incoming bytes into rx_buffer without any CPU intervention.
+ * 			The bytes are delivered to rx_callback when the line becomes idle and when the DMA
+ * 			reaches the half and the end of the buffer, never byte by byte.
+ * 			HAL_UART_Receive_DMA() ignores a DMA stream that does not start, so the stream state is checked.
  */
-int8_t uart_handler_send_message(uart_handler_t *uart_handler,uint8_t *buffer, int16_t buffer_size){
+int8_t uart_handler_start_reception(uart_handler_t *uart_handler, uart_rx_callback_t rx_callback){
 
-	HAL_StatusTypeDef returnValue;
+	uart_handler->rx_position = 0;
+	uart_handler->rx_callback = rx_callback;
 
-	do{
-		returnValue = HAL_UART_Transmit(uart_handler->huart, buffer, buffer_size, HAL_MAX_DELAY);
-	}while(returnValue == HAL_BUSY);
+	if(HAL_UART_Receive_DMA(uart_handler->huart, uart_handler->rx_buffer, UART_RX_BUFFER_SIZE) != HAL_OK){
+		uart_handler->rx_callback = NULL;
+		return UART_ERR;
+	}
 
-	if(returnValue == HAL_OK){
-		return UART_OK;
+	if(uart_handler->huart->hdmarx->State != HAL_DMA_STATE_BUSY){
+		HAL_UART_AbortReceive(uart_handler->huart); // the uart waits for a stream that is not running
+		uart_handler->rx_callback = NULL;
+		return UART_ERR;
 	}
 
-	return UART_ERR;
+	__HAL_UART_CLEAR_IDLEFLAG(uart_handler->huart);
+	__HAL_UART_ENABLE_IT(uart_handler->huart, UART_IT_IDLE);
+
+	return UART_OK;
+}
+
+/**
+ * @brief 	Stop the continuous reception
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @note	The abort waits for the DMA stream to stop, a few bus cycles, so the reception can be started again
+ * 			as soon as it returns: the interrupt version leaves the stream busy until its callback.
+ */
+void uart_handler_stop_reception(uart_handler_t *uart_handler){
+
+	uart_handler->rx_callback = NULL;
+
+	__HAL_UART_DISABLE_IT(uart_handler->huart, UART_IT_IDLE);
+	HAL_UART_AbortReceive(uart_handler->huart);
+
+}
+
+/**
+ * @brief 	Deliver the bytes written by the DMA since the last call
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @note	The DMA position is computed from the stream counter, the bytes that wrap around the
+ * 			buffer end are delivered with two calls of the rx_callback.
+ */
+void uart_handler_rx_event(uart_handler_t *uart_handler){
+
+	uint16_t position;
+
+	if(uart_handler->rx_callback == NULL){
+		return;
+	}
+
+	position = UART_RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(uart_handler->huart->hdmarx);
+
+	if(position == uart_handler->rx_position){
+		return; // nothing new
+	}
+
+	uart_handler->rx_tick = HAL_GetTick();
+
+	if(position > uart_handler->rx_position){
+		uart_handler->rx_callback(uart_handler->rx_buffer + uart_handler->rx_position, position - uart_handler->rx_position);
+	}else{
+		uart_handler->rx_callback(uart_handler->rx_buffer + uart_handler->rx_position, UART_RX_BUFFER_SIZE - uart_handler->rx_position);
+		if(position > 0 && uart_handler->rx_callback != NULL){ // the first call can stop the reception
+			uart_handler->rx_callback(uart_handler->rx_buffer, position);
+		}
+	}
+
+	uart_handler->rx_position = (position == UART_RX_BUFFER_SIZE) ? 0 : position;
+
+}
+
+/**
+ * @brief 	Handle the idle line interrupt
+ * @param 	huart pointer to the uart peripheral structure that has raised the interrupt
+ * @note	It must be called by the USART IRQ handler before the HAL handler, since the HAL
+ * 			doesn't manage the idle line flag.
+ */
+void uart_handler_idle_IRQHandler(UART_HandleTypeDef *huart){
+
+	if(__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE) && __HAL_UART_GET_IT_SOURCE(huart, UART_IT_IDLE)){
+		__HAL_UART_CLEAR_IDLEFLAG(huart);
+		uart_handler_rx_event(system.uart);
+	}
+
+}
+
+/**
+ * @brief 	Find a baud rate into the supported ones
+ * @param 	baud_rate 	baud rate to find
+ * @return 	index into uart_baud_rates, -1 if the baud rate is not supported
+ */
+int8_t uart_handler_baud_rate_index(uint32_t baud_rate){
+
+	int8_t i;
+
+	for(i = 0; i < UART_BAUD_RATES; i++){
+		if(uart_baud_rates[i] == baud_rate){
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief 	Reconfigure the UART with the given baud rate
+ * @param 	uart_handler 	pointer to the uart_handler structure
+ * @param 	baud_rate 		one of the supported baud rates
+ * @return 	operation result
+ * @note	The transmission must be idle. The continuous reception, if started, is restarted with the same
+ * 			callback. The MSP is not initialized again, so pins and DMA streams are kept.
+ * 			If the reception does not restart the callback is kept, so a new call restarts it.
+ */
+int8_t uart_handler_set_baud_rate(uart_handler_t *uart_handler, uint32_t baud_rate){
+
+	uart_rx_callback_t rx_callback = uart_handler->rx_callback;
+
+	if(uart_handler_baud_rate_index(baud_rate) < 0){
+		return UART_ERR;
+	}
+
+	if(rx_callback != NULL){
+		uart_handler_stop_reception(uart_handler);
+	}
+
+	uart_handler->huart->Init.BaudRate = baud_rate;
+	if(HAL_UART_Init(uart_handler->huart) != HAL_OK){
+		return UART_ERR;
+	}
+
+	if(rx_callback != NULL && uart_handler_start_reception(uart_handler, rx_callback) != UART_OK){
+		uart_handler->rx_callback = rx_callback; // the idle interrupt and the DMA are stopped, nothing delivers
+		return UART_ERR;
+	}
+
+	return UART_OK;
+}
+
+/**
+ * @brief 	Request a baud rate change
+ * @param 	uart_handler 	pointer to the uart_handler structure
+ * @param 	baud_rate 		one of the supported baud rates
+ * @return 	operation result
+ * @note	The change is applied by uart_handler_process(), so the messages already queued, e.g. the
+ * 			acknowledge of the command, are sent at the old baud rate.
+ */
+int8_t uart_handler_request_baud_rate(uart_handler_t *uart_handler, uint32_t baud_rate){
+
+	if(uart_handler_baud_rate_index(baud_rate) < 0){
+		return UART_ERR;
+	}
+
+	uart_handler->pending_baud_rate = baud_rate;
+
+	return UART_OK;
+}
+
+/**
+ * @brief 	Apply the pending baud rate change
+ * @param 	uart_handler 	pointer to the uart_handler structure
+ * @note	Called by the main loop: nothing is done while a channel has data to send or the last
+ * 			byte is still in the shift register. Only this check is done with the interrupts disabled:
+ * 			the transmission is then held by the reconfiguring flag, so the reconfiguration runs with the
+ * 			interrupts enabled, the DMA abort waits on the tick. The messages queued meanwhile are sent at
+ * 			the new baud rate.
+ */
+void uart_handler_process(uart_handler_t *uart_handler){
+
+	uint32_t primask;
+	uint32_t baud_rate;
+
+	if(uart_handler->pending_baud_rate == 0){
+		return;
+	}
+
+	primask = critical_section_enter();
+
+	if(!uart_handler_tx_idle(uart_handler)){
+		critical_section_exit(primask);
+		return;
+	}
+
+	uart_handler->reconfiguring = 1;
+	baud_rate = uart_handler->pending_baud_rate;
+	uart_handler->pending_baud_rate = 0;
+
+	critical_section_exit(primask);
+
+	if(uart_handler_set_baud_rate(uart_handler, baud_rate) != UART_OK && uart_handler->pending_baud_rate == 0){
+		uart_handler->pending_baud_rate = baud_rate; // retried by the next call
+	}
+
+	primask = critical_section_enter();
+
+	uart_handler->reconfiguring = 0;
+	uart_handler_start_transfer(uart_handler);
+
+	critical_section_exit(primask);
+
+}
+
+/**
+ * @brief 	Check if the transmission is idle
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @return 	1 if no message is queued, no DMA transfer is running and the last byte has left the shift register
+ */
+uint8_t uart_handler_tx_idle(uart_handler_t *uart_handler){
+
+	uint8_t idle;
+	uint8_t i;
+
+	idle = (uart_handler->active_channel < 0 && __HAL_UART_GET_FLAG(uart_handler->huart, UART_FLAG_TC) != RESET);
+	for(i = 0; i < UART_CHANNELS && idle; i++){
+		idle = (uart_handler->tx_queue[i].head == uart_handler->tx_queue[i].tail);
+	}
+
+	return idle;
+}
+
+/**
+ * @brief 	Record an activity of the reception line
+ * @param 	uart_handler pointer to the uart_handler structure
+ * @note	The bytes received by the DMA record it too. The first byte that wakes the core from the stop mode
+ * 			is lost, the peripheral clock is stopped at its start bit: only its falling edge is seen.
+ */
+void uart_handler_rx_wakeup(uart_handler_t *uart_handler){
+
+	uart_handler->rx_tick = HAL_GetTick();
 
 }
 
@@ -157,13 +660,31 @@ int8_t uart_handler_receive_message(uart_handler_t *uart_handler, uint8_t *buffe
  */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
 
-	if(system.protocol->state != END_CUSTOM && system.protocol->state != END_DEFAULT){
-		// check if the protocol is in execution
-		protocol_callback_tx();
+	uart_handler_tx_callback(system.uart); // release the sent bytes and send the queued ones
+
+}
+
+/**
+ * @brief 	Error Callback redefinition.
+ * @param 	huart pointer to the uart peripheral structure that has raised the interrupt
+ * @note	If the DMA transmission has been aborted, the error is counted and the queue restarts
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+
+	uart_rx_callback_t rx_callback = system.uart->rx_callback;
+
+	if(system.system_log != NULL){
+		system_log_event(system.system_log, LOG_ID_UART_ERROR, huart->ErrorCode, 0, 0);
+	}
+
+	if(huart->gState == HAL_UART_STATE_READY && system.uart->active_channel >= 0){
+		uart_handler_tx_error(system.uart);
 	}
-	else if(system.system_log->state != START_L){
-		// check if the system_log is waiting for sending a new part of the message
-		log_callback_tx();
+
+	if(huart->RxState == HAL_UART_STATE_READY && rx_callback != NULL){
+		// the reception has been aborted by an overrun or a framing error, restart it
+		uart_handler_rx_event(system.uart);
+		uart_handler_start_reception(system.uart, rx_callback);
 	}
 
 }
@@ -174,6 +695,20 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
  */
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart){
 
-	protocol_callback_rx(); // call the protocol function that handles the receiving callback.
+	if(system.protocol->state != END_CUSTOM && system.protocol->state != END_DEFAULT){
+		protocol_callback_rx(); // call the protocol function that handles the receiving callback.
+	}else{
+		uart_handler_rx_event(system.uart); // the circular DMA has reached the buffer end
+	}
+
+}
+
+/**
+ * @brief 	Rx Half Completed Callback redefinition.
+ * @param 	huart pointer to the uart peripheral structure that has raised the interrupt
+ */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart){
+
+	uart_handler_rx_event(system.uart); // the circular DMA has reached the half of the buffer
 
 }
@@ -0,0 +1,31 @@
+/*
+ * arm_size_log_format.c
+ *
+ * The status line formatted by log_format, linked by "make arm-size" to measure the formatter on the target.
+ */
+
+#include "log_format.h"
+
+char line[128];
+
+int format(date_time_t *date_time, const char *area, const char *barrier){
+
+	log_format_t format;
+
+	log_format_init(&format, line, sizeof(line));
+	log_format_date_time(&format, date_time);
+	log_format_string(&format, " Area ");
+	log_format_string(&format, area);
+	log_format_string(&format, " - Barrier ");
+	log_format_string(&format, barrier);
+	log_format_string(&format, "\n\r");
+
+	return log_format_end(&format);
+}
+
+int main(){
+
+	date_time_t date_time = {5, 4, 3, 1, 1, 2, 26};
+
+	return format(&date_time, "ACTIVE", "INACTIVE");
+}
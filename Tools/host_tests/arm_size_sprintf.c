@@ -0,0 +1,20 @@
+/*
+ * arm_size_sprintf.c
+ *
+ * The status line formatted by sprintf, linked by "make arm-size" to measure the newlib formatter on the target.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+char line[128];
+
+int format(uint8_t date, uint8_t month, uint8_t year, uint8_t hours, uint8_t minutes, uint8_t seconds, const char *area, const char *barrier){
+
+	return sprintf(line, "[%02u-%02u-%04u %02u:%02u:%02u] Area %s - Barrier %s\n\r", date, month, 2000 + year, hours, minutes, seconds, area, barrier);
+}
+
+int main(){
+
+	return format(1, 2, 26, 3, 4, 5, "ACTIVE", "INACTIVE");
+}
@@ -0,0 +1,126 @@
+/*
+ * epoch_test.c
+ *
+ * Check the epoch conversion against the C library: every second from 01-01-2000 to 31-12-2099 is converted into a
+ * date time, compared with gmtime() and converted back. The month lengths, the leap years and the week days are
+ * compared too. Then the time of a round trip is measured.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "host_timer.h" // before the CMSIS headers, their register qualifiers clash with the intrinsics
+#include "epoch.h"
+
+#define EPOCH_2000 (946684800LL) // 01-01-2000 00:00:00 in unix seconds
+#define SECONDS_2000_2099 (3155760000ULL) // 36525 days
+#define ROUNDS (10000000)
+
+static int errors = 0;
+
+static void fail(const char *what, uint64_t seconds){
+
+	if(errors++ < 10){
+		printf("%s mismatch at %llu\n", what, (unsigned long long)seconds);
+	}
+
+}
+
+/**
+ * The date changes once a day, so gmtime() is called at midnight only: the time of the day is checked for every
+ * second against the arithmetic of the day.
+ */
+static void check_conversion(){
+
+	uint64_t day, second;
+	time_t unix_time;
+	struct tm calendar;
+	date_time_t date_time;
+	uint32_t seconds;
+
+	for(day = 0; day < SECONDS_2000_2099 / EPOCH_SECONDS_PER_DAY; day++){
+
+		unix_time = EPOCH_2000 + day*EPOCH_SECONDS_PER_DAY;
+		gmtime_r(&unix_time, &calendar);
+
+		for(second = 0; second < EPOCH_SECONDS_PER_DAY; second++){
+			seconds = day*EPOCH_SECONDS_PER_DAY + second;
+			epoch_to_date_time(seconds, &date_time);
+			if(date_time.year != calendar.tm_year - 100 || date_time.month != calendar.tm_mon + 1 || date_time.date != calendar.tm_mday ||
+			   date_time.day != (calendar.tm_wday ? calendar.tm_wday : 7)){
+				fail("date", seconds);
+			}
+			if(date_time.hours != second / 3600 || date_time.minutes != second / 60 % 60 || date_time.seconds != second % 60){
+				fail("time", seconds);
+			}
+			if(epoch_from_date_time(&date_time) != seconds){
+				fail("round trip", seconds);
+			}
+		}
+
+		if(epoch_days_from_date(calendar.tm_year - 100, calendar.tm_mon + 1, calendar.tm_mday) != day){
+			fail("days from date", day*EPOCH_SECONDS_PER_DAY);
+		}
+		if(epoch_week_day(day) != (calendar.tm_wday ? calendar.tm_wday : 7)){
+			fail("week day", day*EPOCH_SECONDS_PER_DAY);
+		}
+	}
+
+}
+
+static void check_calendar(){
+
+	uint8_t year, month;
+	struct tm calendar = {0};
+	time_t first, next;
+
+	for(year = 0; year < 100; year++){
+		if(epoch_is_leap_year(year) != ((2000 + year) % 4 == 0 && ((2000 + year) % 100 != 0 || (2000 + year) % 400 == 0))){
+			fail("leap year", year);
+		}
+		for(month = 1; month <= 12; month++){
+			calendar.tm_year = 100 + year;
+			calendar.tm_mon = month - 1;
+			calendar.tm_mday = 1;
+			first = timegm(&calendar);
+			calendar.tm_mon = month;
+			next = timegm(&calendar);
+			if(epoch_days_in_month(year, month) != (next - first) / EPOCH_SECONDS_PER_DAY){
+				fail("days in month", year*100 + month);
+			}
+		}
+	}
+
+}
+
+static void benchmark(){
+
+	date_time_t date_time;
+	volatile uint32_t sink = 0;
+	uint64_t start, elapsed;
+	uint32_t i, seconds = 0;
+
+	start = host_timer();
+	for(i = 0; i < ROUNDS; i++){
+		seconds += 314159; // about 3.6 days, it spreads the dates over the century
+		if(seconds >= SECONDS_2000_2099){
+			seconds -= SECONDS_2000_2099;
+		}
+		epoch_to_date_time(seconds, &date_time);
+		sink += epoch_from_date_time(&date_time);
+	}
+	elapsed = host_timer() - start;
+
+	printf("round trip %.1f %s\n", (double)elapsed/ROUNDS, HOST_TIMER_UNIT);
+
+}
+
+int main(){
+
+	check_calendar();
+	check_conversion();
+	benchmark();
+
+	printf("epoch_test: %s\n", errors ? "FAILED" : "OK");
+
+	return errors != 0;
+}
@@ -0,0 +1,11 @@
+/*
+ * host_shim.c
+ *
+ * State of the host critical section, shared by all the tests.
+ */
+
+#include "critical_section.h"
+
+uint32_t host_primask = 0;
+
+void (*host_unmask_hook)(void) = NULL;
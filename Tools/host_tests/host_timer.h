@@ -0,0 +1,29 @@
+/*
+ * host_timer.h
+ *
+ * Time measure of the host benchmarks: the time stamp counter on x86, the monotonic clock in ns elsewhere.
+ */
+
+#ifndef HOST_TIMER_H_
+#define HOST_TIMER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HOST_TIMER_UNIT "cycles"
+static inline uint64_t host_timer(){ return __rdtsc(); }
+#else
+#define HOST_TIMER_UNIT "ns"
+static inline uint64_t host_timer(){
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec;
+}
+#endif
+
+#endif /* HOST_TIMER_H_ */
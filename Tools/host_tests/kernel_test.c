@@ -0,0 +1,298 @@
+/*
+ * kernel_test.c
+ *
+ * Run the kernel on the host: the tasks are ucontext contexts and the port is implemented here. A simulated
+ * interrupt ticks the kernel, gives a semaphore and sends into a queue at random points of the tasks. After each
+ * switch the running task must be the ready one of highest priority; the lock must be held by one task at a time
+ * and the queue must keep the order of the items. The run ends after IDLE_STEPS sleeps of the idle task.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "kernel.h"
+#include "kernel_port.h"
+#include "critical_section.h"
+
+#define IDLE_STEPS (2000000)
+#define MAX_CONTEXTS (8)
+#define CONTEXT_STACK_SIZE (1 << 16)
+#define TASK_STACK_WORDS (64)
+
+static kernel_t kernel;
+
+static ucontext_t contexts[MAX_CONTEXTS];
+static kernel_task_t *context_tasks[MAX_CONTEXTS];
+static int context_count = 0;
+
+static int in_interrupt = 0;
+static int switch_pending = 0;
+
+static kernel_semaphore_t event; // given by the interrupt
+static kernel_semaphore_t lock; // shared by the high and the low priority tasks
+static kernel_queue_t queue; // filled by the interrupt
+static uint32_t queue_buffer[4];
+
+static kernel_task_t high_task, middle_task, low_task;
+static uint32_t high_stack[TASK_STACK_WORDS], middle_stack[TASK_STACK_WORDS], low_stack[TASK_STACK_WORDS];
+
+static unsigned long idle_steps = 0, ticks = 0, gives = 0, takes = 0;
+static uint32_t sent = 0, received = 0;
+static int lock_owners = 0;
+static int errors = 0;
+
+static void fail(const char *what, const char *where){
+
+	if(errors++ < 10){
+		printf("%s at %s\n", what, where);
+	}
+
+}
+
+static ucontext_t *task_context(kernel_task_t *task){
+
+	int i;
+
+	for(i = 0; i < context_count; i++){
+		if(context_tasks[i] == task){
+			return &contexts[i];
+		}
+	}
+
+	abort();
+}
+
+/**
+ * The tasks are sorted by priority, so no ready task can precede the running one.
+ */
+static void check_running(const char *where){
+
+	kernel_task_t *current = kernel.current;
+	int i;
+
+	for(i = 0; i < kernel.count && kernel.tasks[i] != current; i++){
+		if(kernel.tasks[i]->state == TASK_READY){
+			fail("ready task of higher priority", where);
+		}
+	}
+
+	if(current->state != TASK_READY){
+		fail("blocked task running", where);
+	}
+
+}
+
+/**
+ * Run the switch requested by the kernel, as PendSV does once the interrupts are enabled.
+ */
+static void context_switch(){
+
+	kernel_task_t *previous = kernel.current;
+	kernel_task_t *next;
+
+	switch_pending = 0;
+	next = kernel_switch_context(&kernel);
+
+	if(previous == NULL){
+		setcontext(task_context(next));
+	}else if(previous != next){
+		swapcontext(task_context(previous), task_context(next));
+	}
+
+}
+
+static void unmask_hook(){
+
+	if(!in_interrupt && switch_pending){
+		context_switch();
+	}
+
+}
+
+void kernel_port_request_switch(){
+
+	switch_pending = 1;
+
+}
+
+void kernel_port_init_stack(kernel_task_t *task, kernel_task_entry_t entry){
+
+	int i = context_count++;
+	uint16_t word;
+
+	for(word = 0; word < task->stack_words; word++){
+		task->stack[word] = KERNEL_STACK_FILL;
+	}
+
+	context_tasks[i] = task;
+	getcontext(&contexts[i]);
+	contexts[i].uc_stack.ss_sp = malloc(CONTEXT_STACK_SIZE);
+	contexts[i].uc_stack.ss_size = CONTEXT_STACK_SIZE;
+	makecontext(&contexts[i], entry, 0);
+
+}
+
+void kernel_port_start(kernel_t *kernel){
+
+	context_switch();
+
+}
+
+static void interrupt(){
+
+	uint32_t item = sent;
+	int event_type = rand() % 10;
+
+	in_interrupt = 1;
+	ticks++;
+
+	if(event_type < 3){
+		if(kernel_semaphore_give(&kernel, &event) == KERNEL_OK){
+			gives++;
+		}
+	}else if(event_type < 6){
+		if(kernel_queue_send(&kernel, &queue, &item) == KERNEL_OK){
+			sent++;
+		}
+	}
+
+	kernel_tick(&kernel);
+	in_interrupt = 0;
+
+	if(switch_pending && !host_primask){
+		context_switch();
+	}
+
+}
+
+static void maybe_interrupt(){
+
+	if(rand() % 3 == 0){
+		interrupt();
+	}
+
+}
+
+/**
+ * The contexts run on their own host stacks, so the stack use of the tasks is not measured here.
+ */
+static void report(){
+
+	printf("kernel: %lu ticks, %u switches, %lu gives, %lu takes, %u sent, %u received, %d errors\n", ticks,
+			kernel.switches, gives, takes, sent, received, errors);
+
+}
+
+void kernel_port_idle(){
+
+	if(++idle_steps > IDLE_STEPS){
+		report();
+		exit(errors ? 1 : 0);
+	}
+
+	interrupt();
+	check_running("idle");
+
+}
+
+static void take_lock(const char *where){
+
+	if(kernel_semaphore_take(&kernel, &lock, KERNEL_WAIT_FOREVER) != KERNEL_OK){
+		fail("lock not taken", where);
+	}
+	if(lock_owners++ != 0){
+		fail("lock taken twice", where);
+	}
+
+}
+
+static void give_lock(){
+
+	lock_owners--;
+	kernel_semaphore_give(&kernel, &lock);
+
+}
+
+static void high_entry(){
+
+	for(;;){
+
+		if(kernel_semaphore_take(&kernel, &event, rand() % 2 ? KERNEL_WAIT_FOREVER : 1 + rand() % 5) == KERNEL_OK){
+			takes++;
+		}
+		check_running("high");
+		maybe_interrupt();
+
+		if(rand() % 4 == 0){
+			take_lock("high");
+			maybe_interrupt();
+			check_running("high lock");
+			give_lock();
+		}
+
+	}
+
+}
+
+static void middle_entry(){
+
+	uint32_t item;
+
+	for(;;){
+
+		if(kernel_queue_receive(&kernel, &queue, &item, rand() % 2 ? KERNEL_WAIT_FOREVER : 1 + rand() % 3) == KERNEL_OK){
+			if(item != received){
+				fail("queue order", "middle");
+			}
+			received++;
+		}
+		check_running("middle");
+		maybe_interrupt();
+
+		if(rand() % 5 == 0){
+			kernel_sleep(&kernel, 1 + rand() % 3);
+		}
+
+	}
+
+}
+
+static void low_entry(){
+
+	int i;
+
+	for(;;){
+
+		take_lock("low");
+		for(i = 0; i < 3; i++){
+			maybe_interrupt();
+		}
+		check_running("low lock");
+		give_lock();
+		maybe_interrupt();
+
+		if(rand() % 3 == 0){
+			kernel_sleep(&kernel, 1);
+		}
+
+	}
+
+}
+
+int main(){
+
+	host_unmask_hook = unmask_hook;
+
+	init_kernel(&kernel);
+	init_kernel_semaphore(&event, 0, 3);
+	init_kernel_semaphore(&lock, 1, 1);
+	init_kernel_queue(&queue, queue_buffer, sizeof(uint32_t), 4);
+
+	kernel_add_task(&kernel, &low_task, "LOW", 5, low_entry, low_stack, TASK_STACK_WORDS);
+	kernel_add_task(&kernel, &high_task, "HIGH", 1, high_entry, high_stack, TASK_STACK_WORDS);
+	kernel_add_task(&kernel, &middle_task, "MIDDLE", 3, middle_entry, middle_stack, TASK_STACK_WORDS);
+
+	kernel_start(&kernel);
+
+	return 1;
+}
@@ -0,0 +1,101 @@
+/*
+ * log_format_bench.c
+ *
+ * Compare log_format with sprintf: the status line and a diagnostic counter line are formatted by both, the
+ * outputs must match, then the time of each formatter is measured. The code size on the target is compared by
+ * "make arm-size".
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "host_timer.h" // before the CMSIS headers, their register qualifiers clash with the intrinsics
+#include "log_format.h"
+
+#define ROUNDS (1000000)
+#define LINE_SIZE (128)
+
+static const char *states[] = {"ACTIVE", "INACTIVE", "ALARMED"};
+
+static date_time_t random_date_time(){
+
+	date_time_t date_time;
+
+	date_time.seconds = rand() % 60;
+	date_time.minutes = rand() % 60;
+	date_time.hours = rand() % 24;
+	date_time.day = 1 + rand() % 7;
+	date_time.date = 1 + rand() % 28;
+	date_time.month = 1 + rand() % 12;
+	date_time.year = rand() % 100;
+
+	return date_time;
+}
+
+static uint16_t format_log(char *line, date_time_t *date_time, uint8_t area, uint8_t barrier, uint32_t counter){
+
+	log_format_t format;
+
+	log_format_init(&format, line, LINE_SIZE);
+	log_format_date_time(&format, date_time);
+	log_format_string(&format, " Area ");
+	log_format_string(&format, states[area]);
+	log_format_string(&format, " - Barrier ");
+	log_format_string(&format, states[barrier]);
+	log_format_string(&format, " - DROPPED ");
+	log_format_uint(&format, counter, 0);
+	log_format_string(&format, "\n\r");
+
+	return log_format_end(&format);
+}
+
+static uint16_t format_sprintf(char *line, date_time_t *date_time, uint8_t area, uint8_t barrier, uint32_t counter){
+
+	return sprintf(line, "[%02u-%02u-%04u %02u:%02u:%02u] Area %s - Barrier %s - DROPPED %lu\n\r",
+				   date_time->date, date_time->month, 2000 + date_time->year, date_time->hours, date_time->minutes,
+				   date_time->seconds, states[area], states[barrier], (unsigned long)counter);
+}
+
+int main(){
+
+	static date_time_t date_times[256];
+	static uint32_t counters[256];
+	char a[LINE_SIZE], b[LINE_SIZE];
+	uint64_t start, log_time, sprintf_time;
+	volatile uint32_t sink = 0;
+	int i, errors = 0;
+
+	for(i = 0; i < 256; i++){
+		date_times[i] = random_date_time();
+		counters[i] = (i % 4 == 0) ? 0xFFFFFFFF : (uint32_t)rand() >> (i % 32);
+	}
+
+	for(i = 0; i < 100000; i++){ // same output
+		date_time_t date_time = random_date_time();
+		uint32_t counter = (uint32_t)rand() >> (i % 32);
+		uint16_t length = format_log(a, &date_time, i % 3, (i / 3) % 3, counter);
+		if(length != format_sprintf(b, &date_time, i % 3, (i / 3) % 3, counter) || strcmp(a, b) != 0){
+			if(errors++ < 5){
+				printf("mismatch:\n  %s  %s", a, b);
+			}
+		}
+	}
+
+	start = host_timer();
+	for(i = 0; i < ROUNDS; i++){
+		sink += format_log(a, &date_times[i & 255], i % 3, 1, counters[i & 255]);
+	}
+	log_time = host_timer() - start;
+
+	start = host_timer();
+	for(i = 0; i < ROUNDS; i++){
+		sink += format_sprintf(b, &date_times[i & 255], i % 3, 1, counters[i & 255]);
+	}
+	sprintf_time = host_timer() - start;
+
+	printf("log_format %.1f %s/line, sprintf %.1f %s/line, %.2fx\n", (double)log_time/ROUNDS, HOST_TIMER_UNIT,
+		   (double)sprintf_time/ROUNDS, HOST_TIMER_UNIT, (double)sprintf_time/log_time);
+	printf("log_format_bench: %s\n", errors ? "FAILED" : "OK");
+
+	return errors != 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * critical_section.h
+ *
+ * Host replacement of Core/Inc/critical_section.h: PRIMASK is a variable. The kernel test hooks its release
+ * to run the context switch requested inside a critical section, as PendSV does on the target.
+ */
+
+#ifndef INC_CRITICAL_SECTION_H_
+#define INC_CRITICAL_SECTION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+extern uint32_t host_primask;
+
+extern void (*host_unmask_hook)(void);
+
+static inline uint32_t critical_section_enter(){
+
+	uint32_t primask = host_primask;
+
+	host_primask = 1;
+
+	return primask;
+}
+
+static inline void critical_section_exit(uint32_t primask){
+
+	host_primask = primask;
+
+	if(!primask && host_unmask_hook != NULL){
+		host_unmask_hook();
+	}
+
+}
+
+#endif /* INC_CRITICAL_SECTION_H_ */
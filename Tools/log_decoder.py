@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+log_decoder.py
+
+Convert a UART capture of the Home Security System, taken with the system
+log in binary mode (console command "LOG BINARY"), back into the ASCII log
+format:
+
+    [dd-mm-yyyy hh:mm:ss.mmm] AREA  ACTIVE  - BARRIER  INACTIVE
+    [dd-mm-yyyy hh:mm:ss.mmm] EVENT SYSTEM ACTIVE - AREA ALLARMED - BARRIER INACTIVE
+
+Frames are delimited by 0x00 bytes and COBS encoded. Each decoded frame is
+a record followed by its CRC-16/CCITT-FALSE, little endian. Bytes that are
+not a valid frame (echoes, feedback and alarm messages) are printed as they
+are, unless --frames-only is given. Telemetry frames are skipped, they are
+decoded by telemetry_capture.py.
+
+Usage:
+    log_decoder.py capture.bin
+    log_decoder.py --frames-only < capture.bin
+"""
+
+import argparse
+import sys
+
+LOG_FRAME_STATUS = 0x01
+LOG_FRAME_EVENT = 0x02
+LOG_FRAME_TELEMETRY = 0x03
+LOG_FRAME_STATUS_SIZE = 10
+
+# same strings and same mapping of get_state_string() in system_log.c
+SENSOR_STATES = {0: " ACTIVE ", 1: " INACTIVE "}
+ALLARMED_STRING = " ALLARMED "
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_frame(segment):
+    """Return the record carried by segment, None if it is not a valid frame."""
+    raw = cobs_decode(segment)
+    if raw is None or len(raw) < 3:
+        return None
+    record, crc = raw[:-2], raw[-2] | (raw[-1] << 8)
+    if crc16(record) != crc:
+        return None
+    return record
+
+
+def sensor_string(state):
+    return SENSOR_STATES.get(state, ALLARMED_STRING)
+
+
+def format_record(record):
+    if record[0] in (LOG_FRAME_STATUS, LOG_FRAME_EVENT) and len(record) == LOG_FRAME_STATUS_SIZE:
+        date, month, year, hour, minute, second, states = record[1:8]
+        milliseconds = record[8] | (record[9] << 8)
+        date_time = "[%02d-%02d-20%02d %02d:%02d:%02d.%03d]" % (date, month, year, hour, minute, second, milliseconds)
+        area, barrier = sensor_string(states & 0x03), sensor_string((states >> 2) & 0x03)
+        if record[0] == LOG_FRAME_EVENT:
+            # same as get_system_state_string(): ACTIVE, INACTIVE, ALLARMED
+            return "%s EVENT SYSTEM%s- AREA%s- BARRIER%s" % (
+                date_time, sensor_string((states >> 4) & 0x03), area, barrier)
+        return "%s AREA %s - BARRIER %s " % (date_time, area, barrier)
+    return "<unknown record %s>" % record.hex()
+
+
+def decode_stream(data, frames_only):
+    lines = []
+    for segment in data.split(b"\x00"):
+        if not segment:
+            continue
+        record = decode_frame(segment)
+        if record is not None and record[0] == LOG_FRAME_TELEMETRY:
+            continue
+        if record is not None:
+            lines.append(format_record(record) + "\n")
+        elif not frames_only:
+            lines.append(segment.decode("latin-1").replace("\r", ""))
+    return "".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("capture", nargs="?", help="binary capture file, stdin if omitted")
+    parser.add_argument("--frames-only", action="store_true", help="print only the decoded records")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, "rb") as capture:
+            data = capture.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    sys.stdout.write(decode_stream(data, args.frames_only))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+log_ring_decoder.py
+
+Reconstruct the text of the deferred log records from a raw memory dump of
+the log ring (system_log.ring), for example taken with GDB:
+
+    dump binary memory ring.bin &system_log.ring (&system_log.ring)+1
+
+The records already sent keep their slot until it is overwritten, so the
+dump shows the latest records. They are printed oldest first. Records still
+waiting for the main loop are marked with '*'.
+
+The message texts are read from Core/Inc/log_messages.h, so the tool follows
+the firmware without changes.
+
+Usage:
+    log_ring_decoder.py ring.bin
+    log_ring_decoder.py --messages path/to/log_messages.h ring.bin
+"""
+
+import argparse
+import datetime
+import os
+import re
+import struct
+
+DEFAULT_MESSAGES = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                 "..", "Home_Security_System", "Core", "Inc", "log_messages.h")
+
+# log_record_t: tick, args[3], sequence, id, reserved
+RECORD = struct.Struct("<IIIIHBB")
+# log_ring_t fields after the records: head, tail, dropped, sequence, padding
+RING_TAIL = struct.Struct("<HHIH2x")
+
+# same strings and same mapping of get_state_string() and get_system_state_string()
+STATE_STRINGS = {0: " ACTIVE ", 1: " INACTIVE "}
+ALLARMED_STRING = " ALLARMED "
+
+
+def load_messages(path):
+    with open(path) as header:
+        text = header.read()
+    entries = re.findall(r'LOG_MESSAGE\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', text)
+    # LOG_ID_NONE is 0, the messages follow in order
+    return {index + 1: entry for index, entry in enumerate(entries)}
+
+
+def state_string(state):
+    return STATE_STRINGS.get(state, ALLARMED_STRING)
+
+
+# epoch of the record timestamps, see Core/Inc/epoch.h
+EPOCH = datetime.datetime(2000, 1, 1)
+
+
+def format_timestamp(seconds, milliseconds):
+    timestamp = EPOCH + datetime.timedelta(seconds=seconds)
+    return "[%s.%03d]" % (timestamp.strftime("%d-%m-%Y %H:%M:%S"), milliseconds)
+
+
+def format_record(messages, message_id, args):
+    name, text = messages.get(message_id, ("LOG_ID_%d" % message_id, "UNKNOWN MESSAGE %u %u %u"))
+    if name == "LOG_ID_STATUS":
+        return "%s AREA %s - BARRIER %s" % (
+            format_timestamp(args[0], args[1]), state_string(args[2] & 0x03), state_string((args[2] >> 2) & 0x03))
+    if name == "LOG_ID_EVENT":
+        return "%s EVENT SYSTEM%s- AREA%s- BARRIER%s" % (
+            format_timestamp(args[0], args[1]), state_string((args[2] >> 4) & 0x03),
+            state_string(args[2] & 0x03), state_string((args[2] >> 2) & 0x03))
+    values = iter(args)
+
+    def argument(match):
+        value = next(values, 0)
+        if match.group(0) == "%d" and value >= 0x80000000:
+            value -= 0x100000000
+        return str(value)
+
+    return re.sub(r"%[ud]", argument, text)
+
+
+def decode_ring(data, messages):
+    count = (len(data) - RING_TAIL.size) // RECORD.size
+    if count <= 0 or len(data) != count * RECORD.size + RING_TAIL.size:
+        raise ValueError("the dump size does not match a log ring")
+
+    head, tail, dropped, sequence = RING_TAIL.unpack_from(data, count * RECORD.size)
+    lines = ["head %d tail %d dropped %d" % (head, tail, dropped)]
+
+    records = []
+    for slot in range(count):
+        tick, arg0, arg1, arg2, record_sequence, message_id, _ = RECORD.unpack_from(data, slot * RECORD.size)
+        if message_id == 0:
+            continue  # never written
+        pending = (slot - tail) % count < (head - tail) % count
+        age = (sequence - record_sequence) & 0xFFFF  # 16 bit sequence, the oldest has the greatest age
+        records.append((age, tick, pending, format_record(messages, message_id, (arg0, arg1, arg2))))
+
+    for _, tick, pending, text in sorted(records, key=lambda record: -record[0]):
+        lines.append("%s[%d] %s" % ("*" if pending else " ", tick, text))
+
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("dump", help="raw memory dump of the log ring")
+    parser.add_argument("--messages", default=DEFAULT_MESSAGES, help="path of log_messages.h")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as dump:
+        data = dump.read()
+
+    print(decode_ring(data, load_messages(args.messages)), end="")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+provision.py
+
+Configure a Home Security System in one exchange, with the bulk mode of the
+configuration protocol: the first request of the protocol is answered by a
+single line
+
+    PIN=1234;D1=05;D2=10;DUR=20;DT=19/10/26 12:30:00
+
+with the user pin, the pir and barrier delays, the alarm duration and the
+date and time. The line must start with "PIN=", the other fields can be in
+any order. The board switches to the bulk reception after the prefix, so the
+rest of the line is sent once the prefix is echoed. The values are checked as the interactive ones: a malformed line
+or a rejected value loads the default configuration.
+
+Reset the board after starting the tool: it answers the boot handshake with
+START, sends the line and prints the outcome. A board that boots with a
+saved configuration does not run the protocol, clear it first with the
+console command "CONFIG CLEAR".
+
+    provision.py --port /dev/ttyACM0 --pin 1234 --delay1 5 --delay2 10 --duration 20
+    provision.py --print --pin 1234 --duration 20
+
+The date and time default to the local time of the host. Talking with the
+board needs pyserial.
+"""
+
+import argparse
+import datetime
+import sys
+import time
+
+START_STRING = b"START"
+INSERT_PIN = b"INSERT PIN"
+BULK_PREFIX = b"PIN="
+OUTCOMES = {b"System Configuration Loaded": 0,
+            b"System Configuration Rejected": 1,
+            b"Stored Configuration Loaded": 2}
+
+
+def bulk_line(args):
+    """Build the bulk mode line, same fields and sizes of the interactive requests."""
+    date_time = args.date_time or datetime.datetime.now()
+    return "PIN=%s;D1=%02d;D2=%02d;DUR=%02d;DT=%s" % (
+        args.pin, args.delay1, args.delay2, args.duration, date_time.strftime("%d/%m/%y %H:%M:%S"))
+
+
+def wait_for(port, patterns, timeout):
+    """Read until one of the patterns is received, return it, None on timeout."""
+    received = b""
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        received += port.read(256)
+        for pattern in patterns:
+            if pattern in received:
+                return pattern
+    return None
+
+
+def provision(args, line):
+    import serial  # pyserial, needed only to talk with the board
+    port = serial.Serial(args.port, args.baud, timeout=0.1)
+
+    print("waiting for the board boot...", file=sys.stderr)
+    if wait_for(port, [b"\n\r"] + list(OUTCOMES), args.timeout) != b"\n\r":
+        print("no boot handshake, is a configuration already saved?", file=sys.stderr)
+        return 2
+    port.write(START_STRING)
+
+    if wait_for(port, [INSERT_PIN], args.timeout) is None:
+        print("no configuration request", file=sys.stderr)
+        return 2
+    line = line.encode("ascii")
+    port.write(line[:len(BULK_PREFIX)])
+    if wait_for(port, [BULK_PREFIX], args.timeout) is None:
+        print("no bulk mode echo", file=sys.stderr)
+        return 2
+    port.write(line[len(BULK_PREFIX):] + b"\r")
+
+    outcome = wait_for(port, list(OUTCOMES), args.timeout)
+    port.close()
+    if outcome is None:
+        print("no answer", file=sys.stderr)
+        return 2
+    print(outcome.decode("ascii"))
+    return OUTCOMES[outcome]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--port", help="serial port of the board")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--timeout", type=float, default=35, help="seconds to wait for each step")
+    parser.add_argument("--print", action="store_true", help="print the line instead of sending it")
+    parser.add_argument("--pin", default="0000")
+    parser.add_argument("--delay1", type=int, default=0, help="pir delay, 0 to 30 seconds")
+    parser.add_argument("--delay2", type=int, default=0, help="barrier delay, 0 to 30 seconds")
+    parser.add_argument("--duration", type=int, default=5, help="alarm duration, 5 to 60 seconds")
+    parser.add_argument("--date-time", type=datetime.datetime.fromisoformat,
+                        help="ISO date and time, the host time if omitted")
+    args = parser.parse_args()
+
+    line = bulk_line(args)
+    if args.print:
+        print(line)
+        return 0
+    if not args.port:
+        parser.error("--port is required to send the line")
+    return provision(args, line)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
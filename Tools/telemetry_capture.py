@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+telemetry_capture.py
+
+Save and decode the barrier telemetry stream of the Home Security System
+(console command "TELEMETRY ON").
+
+Each telemetry frame carries a record of type 0x03: sequence, decimation,
+threshold, stable signal, number of samples, then for each sample the mean
+of the decimated conversions and the highest stability counter (16 bit
+fields, little endian). Frames use the same COBS and CRC framing of the
+binary log, see log_decoder.py.
+
+The capture stores the raw bytes of the UART, so it can be decoded again,
+or replayed to a serial port, at any time:
+
+    telemetry_capture.py capture --port /dev/ttyACM0 --baud 921600 barrier.bin
+    telemetry_capture.py decode barrier.bin --csv barrier.csv
+    telemetry_capture.py replay barrier.bin --port /dev/ttyUSB1 --baud 921600
+
+capture and replay need pyserial.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import time
+
+from log_decoder import decode_frame
+
+LOG_FRAME_TELEMETRY = 0x03
+HEADER = struct.Struct("<BBHHHB")
+SAMPLE = struct.Struct("<HH")
+FIELDS = ("sequence", "sample", "decimation", "threshold", "stable_signal", "value", "counter")
+
+
+def decode_records(data):
+    """Yield the telemetry records found in a raw capture."""
+    for segment in data.split(b"\x00"):
+        if not segment:
+            continue
+        record = decode_frame(segment)
+        if record is None or record[0] != LOG_FRAME_TELEMETRY or len(record) < HEADER.size:
+            continue
+        _, sequence, decimation, threshold, stable_signal, count = HEADER.unpack_from(record)
+        if len(record) != HEADER.size + count * SAMPLE.size:
+            continue
+        samples = [SAMPLE.unpack_from(record, HEADER.size + i * SAMPLE.size) for i in range(count)]
+        yield sequence, decimation, threshold, stable_signal, samples
+
+
+def decode(args):
+    with open(args.capture, "rb") as capture:
+        data = capture.read()
+
+    output = open(args.csv, "w", newline="") if args.csv else sys.stdout
+    writer = csv.writer(output)
+    writer.writerow(FIELDS)
+
+    records = lost = 0
+    previous = None
+    sample_index = 0
+    for sequence, decimation, threshold, stable_signal, samples in decode_records(data):
+        if previous is not None and sequence != (previous + 1) & 0xFF:
+            lost += (sequence - previous - 1) & 0xFF  # dropped by the firmware or corrupted on the link
+        previous = sequence
+        records += 1
+        for value, counter in samples:
+            writer.writerow((sequence, sample_index, decimation, threshold, stable_signal, value, counter))
+            sample_index += 1
+
+    if output is not sys.stdout:
+        output.close()
+    print("%d records, %d samples, %d records lost" % (records, sample_index, lost), file=sys.stderr)
+
+
+def open_port(args):
+    import serial  # pyserial, needed only to talk with the board
+    return serial.Serial(args.port, args.baud, timeout=0.1)
+
+
+def capture(args):
+    port = open_port(args)
+    end = time.monotonic() + args.duration if args.duration else None
+    size = 0
+    with open(args.capture, "wb") as output:
+        try:
+            while end is None or time.monotonic() < end:
+                data = port.read(4096)
+                if data:
+                    output.write(data)
+                    size += len(data)
+        except KeyboardInterrupt:
+            pass
+    port.close()
+    print("%d bytes saved into %s" % (size, args.capture), file=sys.stderr)
+
+
+def replay(args):
+    with open(args.capture, "rb") as capture:
+        data = capture.read()
+    port = open_port(args)
+    port.write(data)  # the write pace is the baud rate of the port, as in the original stream
+    port.flush()
+    port.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    command = commands.add_parser("capture", help="save the raw UART stream")
+    command.add_argument("capture", help="output file")
+    command.add_argument("--port", required=True)
+    command.add_argument("--baud", type=int, default=9600)
+    command.add_argument("--duration", type=float, help="seconds, until Ctrl-C if omitted")
+    command.set_defaults(run=capture)
+
+    command = commands.add_parser("decode", help="convert a capture into CSV samples")
+    command.add_argument("capture", help="raw capture file")
+    command.add_argument("--csv", help="output file, stdout if omitted")
+    command.set_defaults(run=decode)
+
+    command = commands.add_parser("replay", help="send a capture to a serial port")
+    command.add_argument("capture", help="raw capture file")
+    command.add_argument("--port", required=True)
+    command.add_argument("--baud", type=int, default=9600)
+    command.set_defaults(run=replay)
+
+    args = parser.parse_args()
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main()